@@ -54,8 +54,7 @@ class liqExpression {
   MString	GetValue( void ){ return value; };
   MString	GetCmd( void );
 
-  bool	destExists;
-  bool	destIsNewer;;
+  bool	destUpToDate;
   bool	isValid;
   ExprType	type;
 
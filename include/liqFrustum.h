@@ -0,0 +1,60 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+#ifndef liqFrustum_H
+#define liqFrustum_H
+
+/* ______________________________________________________________________
+**
+** Liquid Frustum Header File
+** ______________________________________________________________________
+*/
+
+#include <maya/MMatrix.h>
+#include <maya/MBoundingBox.h>
+
+// The viewing volume of a job camera, used to leave out objects that
+// can't show up in the picture. The test is conservative : a box is only
+// rejected when all its corners are behind the same plane.
+class liqFrustum {
+public:
+  // worldToCamera maps to RenderMan camera space, looking down +z. The
+  // screen window is in tangents of the view angle for a perspective
+  // camera and in camera units for an orthographic one.
+  liqFrustum( const MMatrix &worldToCamera, bool ortho,
+              double left, double right, double bottom, double top,
+              double neardb, double fardb );
+
+  // false if the world space box is certainly out of view
+  bool intersects( const MBoundingBox &box ) const;
+
+private:
+  MMatrix m_worldToCamera;
+  double  m_planes[6][4];   // camera space, inside is positive
+};
+
+#endif
@@ -91,6 +91,7 @@ public:
   MString       getArgDetailStr( int num );
   MString       getArgStringDefault( int num, int entry );
   float         getArgFloatDefault( int num, int entry );
+  bool          hasArgDefault( int num );
   int           getArgArraySize( int num );
 
   struct mstrcomp
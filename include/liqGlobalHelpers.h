@@ -39,6 +39,7 @@
 #include <maya/MString.h>
 #include <maya/MFnDependencyNode.h>
 #include <maya/MObject.h>
+#include <maya/MMatrix.h>
 
 #include <liquid.h>
 #include <liqTokenPointer.h>
@@ -84,6 +85,26 @@ MString liquidTransGetFullSceneName();
 void liquidInfo( MString info );
 void liquidGetGlobal( MString globalName, double &value, MStatus &returnStatus );
 liquidlong liquidHash( const char *str );
+MString liquidFileHash( const MString &fileName, bool skipRibComments = false );
+bool liquidCopyFile( const MString &from, const MString &to );
+
+// Running hash of translated data, the fingerprint of what a RIB or a map
+// is made from. Same lanes as liquidFileHash().
+class liqHash {
+public:
+  liqHash();
+  void    add( const void *data, unsigned long size );
+  void    add( const char *str );
+  void    add( const MString &str );
+  void    add( int value );
+  void    add( unsigned value );
+  void    add( float value );
+  void    add( double value );
+  void    add( const MMatrix &matrix );
+  MString str() const;
+private:
+  unsigned long h1, h2;
+};
 MString liquidSanitizePath( MString & inputString );
 MString removeEscapes( const MString & inputString );
 MObject getNodeByName( MString name, MStatus *returnStatus );
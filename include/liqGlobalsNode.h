@@ -141,6 +141,19 @@ class liqGlobalsNode : public MPxNode
     static MObject aCompressedOutput;
     static MObject aRenderAllCurves;
     static MObject aOutputMeshUVs;
+    static MObject aUseParticleCache;
+    static MObject aParticleCacheDirectory;
+    static MObject aPolygonLOD;
+    static MObject aPolygonLODArea;
+    static MObject aRibGenThreads;
+    static MObject aTextureProcesses;
+    static MObject aRibJobProcesses;
+    static MObject aCullCameraObjects;
+    static MObject aCullMargin;
+    static MObject aCullDistance;
+    static MObject aShareGeometry;
+    static MObject aIncrementalRibs;
+    static MObject aFrameChunkSize;
     static MObject aIgnoreSurfaces;
     static MObject aIgnoreDisplacements;
     static MObject aIgnoreLights;
@@ -148,11 +161,14 @@ class liqGlobalsNode : public MPxNode
     static MObject aOutputShadersInShadows;
     static MObject aOutputShadersInDeepShadows;
     static MObject aOutputLightsInDeepShadows;
+    static MObject aCullShadowObjects;
 
     static MObject aOutputShadowPass;
     static MObject aOutputHeroPass;
     static MObject aOutputComments;
     static MObject aShaderDebug;
+    static MObject aOutputAllShaderParams;
+    static MObject aGroupByMaterial;
     static MObject aShowProgress;
     static MObject aDoAnimation;
     static MObject aStartFrame;
@@ -305,6 +321,8 @@ class liqGlobalsNode : public MPxNode
     static MObject aBits_features_4;
     static MObject aBits_features_5;
     static MObject aBits_features_6;
+    static MObject aBits_features_7;
+    static MObject aBits_features_8;
 
     static MObject aBits_required;
     static MObject aBits_required_0;
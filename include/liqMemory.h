@@ -39,19 +39,57 @@
 #include <sys/types.h>
 #ifdef _DEBUGMEMORYSYSTEM
 #define lmalloc( size ) ldmalloc( size, __FILE__, __LINE__ )
-#define lfree( block )	ldfree( block, __FILE__, __LINE__)
+#define lfree( block )	ldfree( block )
 #define lcalloc( nelem, elsize ) ldcalloc( nelem, elsize, __FILE__, __LINE__)
+#define lamalloc( size ) ldamalloc( size, __FILE__, __LINE__ )
+#define lafree( block ) ldafree( block )
 #else
 #define lmalloc( size ) malloc( size )
 #define lfree( block ) free( block )
 #define lcalloc( nelem, elsize ) calloc( nelem, elsize ) 
+#define lamalloc( size ) larenaAlloc( size )
+#define lafree( block ) larenaFree( block )
 #endif
 
 int lmemUsage();
 void ldumpUnfreed();
+void lmemReport();
+
+/* Allocations tracked with _DEBUGMEMORYSYSTEM are also counted against the
+ * current category ( "mesh", "shader"... ), lmemReport() prints the peak of
+ * each one. The name must stay valid, use string literals. */
+const char *lmemSetCategory( const char *name );
+
+struct lmemCategory {
+  lmemCategory( const char *name ) : previous( lmemSetCategory( name ) ) {}
+  ~lmemCategory() { lmemSetCategory( previous ); }
+  const char *previous;
+};
 
 void *ldmalloc( size_t size, const char *fileName, const long line );
 void *ldcalloc( size_t nelem, size_t elsize, const char *fileName, const long line );
 void  ldfree( void *ptr );
 
+/* Scan arena : geometry buffers of the scene being translated.
+ * Between larenaBegin() and larenaEnd() lamalloc() takes memory from the
+ * arena, everywhere else it is a plain malloc. lafree() of arena memory does
+ * nothing, the whole arena is given back at once by larenaReset() when the
+ * hash table is deleted, and kept for the next scan until larenaRelease().
+ * Not thread safe, only the scan allocates from it. */
+void  larenaBegin();
+void  larenaEnd();
+void  larenaReset();
+void  larenaRelease();
+bool  larenaOwns( const void *ptr );
+void *larenaAlloc( size_t size );
+void  larenaFree( void *ptr );
+void *ldamalloc( size_t size, const char *fileName, const long line );
+void  ldafree( void *ptr );
+
+// larenaBegin() / larenaEnd() for a block, exceptions included
+struct larenaScope {
+  larenaScope()  { larenaBegin(); }
+  ~larenaScope() { larenaEnd(); }
+};
+
 #endif
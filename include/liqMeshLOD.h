@@ -0,0 +1,89 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+#ifndef liqMeshLOD_H
+#define liqMeshLOD_H
+
+/* ______________________________________________________________________
+**
+** Liquid Mesh Level Of Detail Header File
+** ______________________________________________________________________
+*/
+
+extern "C" {
+#include <ri.h>
+}
+
+#include <vector>
+#include <liqTokenPointer.h>
+
+// Decimated versions of a polygon mesh, built by vertex clustering.
+// Levels only depend on the mesh topology and are shared by every mesh
+// with the same topology ( motion samples, frames, duplicated props ).
+class liqMeshLOD {
+public:
+  struct level {
+    RtFloat               ratio;            // faces kept, relative to the full mesh
+    unsigned              numPoints;
+    std::vector<RtInt>    pointMap;         // original point -> level point
+    std::vector<RtInt>    nverts;
+    std::vector<RtInt>    verts;
+    std::vector<RtInt>    faceSource;       // level face -> original face
+    std::vector<RtInt>    faceVertexSource; // level face vertex -> original face vertex
+  };
+
+  // the levels of this topology, built from P the first time it is seen
+  static const liqMeshLOD *get( unsigned numPoints, unsigned numFaces, const RtInt *nverts, const RtInt *verts, const RtFloat *P );
+  static void clearCache();
+
+  // decimated levels, not counting the full mesh
+  unsigned      numLevels() const;
+  const level  &getLevel( unsigned l ) const;
+
+  // RiDetailRange bounds of a detail level, 0 being the full mesh which is
+  // used down to fullDetailArea pixels
+  void          detailRange( unsigned l, RtFloat fullDetailArea, RtFloat range[4] ) const;
+
+  // Resample a primvar of the full mesh onto level l. Vertex and varying
+  // values are averaged over the points that were merged.
+  void          remap( unsigned l, liqTokenPointer &src, liqTokenPointer &dst ) const;
+
+private:
+  liqMeshLOD( unsigned numPoints, unsigned numFaces, const RtInt *nverts, const RtInt *verts, const RtFloat *P );
+
+  unsigned  cluster( unsigned resolution, level &lev ) const;
+
+  unsigned              m_numPoints;
+  unsigned              m_numFaces;
+  std::vector<RtInt>    m_topology;   // nverts followed by verts
+  const RtFloat        *m_P;          // only valid while building
+  RtFloat               m_min[3];
+  RtFloat               m_size;
+  unsigned long         m_hash;
+  std::vector<level>    m_levels;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+#ifndef liqParticleCache_H
+#define liqParticleCache_H
+
+/* ______________________________________________________________________
+**
+** Liquid Particle Disk Cache Header File
+** ______________________________________________________________________
+*/
+
+#include <maya/MString.h>
+#include <maya/MTime.h>
+#include <maya/MDoubleArray.h>
+#include <maya/MVectorArray.h>
+
+#include <string>
+#include <vector>
+
+
+// A memory mapped Maya particle disk cache file (.pdc)
+class liqPdcFile {
+public:
+  enum AttrType {
+    pdcInt          = 0,
+    pdcIntArray     = 1,
+    pdcDouble       = 2,
+    pdcDoubleArray  = 3,
+    pdcVector       = 4,
+    pdcVectorArray  = 5
+  };
+
+  liqPdcFile();
+  ~liqPdcFile();
+
+  bool      open( const char *fileName );
+  void      close();
+  bool      isOpen() const;
+
+  unsigned  numParticles() const;
+  int       findAttribute( const char *name ) const;
+  AttrType  attributeType( int attr ) const;
+
+  // Per particle values. Scalar attributes are broadcast to every particle.
+  double    getDouble( int attr, unsigned particle ) const;
+  void      getVector( int attr, unsigned particle, double vec[3] ) const;
+
+private:
+  // the mapping belongs to one instance
+  liqPdcFile( const liqPdcFile & );
+  liqPdcFile &operator=( const liqPdcFile & );
+
+  struct attribute {
+    std::string           name;
+    AttrType              type;
+    const unsigned char  *data;
+  };
+
+  int     readInt( const unsigned char *p ) const;
+  double  readDouble( const unsigned char *p ) const;
+
+  void                   *m_map;
+  unsigned long           m_mapSize;
+#ifdef _WIN32
+  void                   *m_fileHandle;
+  void                   *m_mapHandle;
+#endif
+  bool                    m_bigEndian;
+  unsigned                m_numParticles;
+  std::vector<attribute>  m_attributes;
+};
+
+
+// The cached state of one particle system at an arbitrary time. If there is
+// no cache file for that exact time, the two closest samples are interpolated
+// by particle id. Particles that die in between keep their first sample,
+// extrapolated along their velocity if there is one.
+class liqParticleCache {
+public:
+  liqParticleCache();
+  ~liqParticleCache();
+
+  bool      load( const MString &cacheDir, const MString &particleName, const MTime &time );
+  void      clear();
+
+  unsigned  numParticles() const;
+  bool      getDoubleArray( const MString &attr, MDoubleArray &array ) const;
+  bool      getVectorArray( const MString &attr, MVectorArray &array ) const;
+
+  static MString fileName( const MString &cacheDir, const MString &particleName, long ticks );
+
+private:
+  // not copyable either, it holds the mapped files
+  liqParticleCache( const liqParticleCache & );
+  liqParticleCache &operator=( const liqParticleCache & );
+
+  int       findAttribute( const liqPdcFile &file, const MString &attr ) const;
+  static void sampleTicks( const MString &cacheDir, const MString &particleName, std::vector<long> &ticks );
+
+  liqPdcFile        m_file[2];
+  bool              m_interpolate;
+  double            m_alpha;      // position between the two files
+  double            m_deltaTime;  // seconds since the first file
+  std::vector<int>  m_remap;      // index in m_file[1] of each particle in m_file[0]
+};
+
+#endif
@@ -20,6 +20,8 @@
 #define liqProcessLauncher_H_
 
 
+#include <vector>
+
 class MString;
 
 
@@ -30,6 +32,22 @@ class liqProcessLauncher
 {
 public:
   static bool execute(const MString &command, const MString &arguments, const MString &path, const bool wait );
+  // run command lines with at most processes of them at once and wait for
+  // all of them, succeeded tells which ones exited with a zero status
+  static void execute( const std::vector<MString> &commands, const MString &path, unsigned processes, std::vector<bool> &succeeded );
+  // same, a command only runs once the commands listed in its dependencies
+  // succeeded and is cancelled if one of them failed or was cancelled
+  static void execute( const std::vector<MString> &commands, const std::vector< std::vector<unsigned> > &dependencies, const MString &path, unsigned processes, std::vector<bool> &succeeded );
+  // split the calling process in count workers carrying on from the call,
+  // returns the worker index, 0 being the calling process which gets the
+  // ids of the others in workers. Platforms without fork() get a single
+  // worker, as do failed forks past the ones in workers.
+  static unsigned forkWorkers( unsigned count, std::vector<int> &workers );
+  // wait for the workers of forkWorkers(), true if all of them exited with
+  // a zero status
+  static bool waitWorkers( const std::vector<int> &workers );
+  // stop the workers of forkWorkers() and reap them
+  static void killWorkers( const std::vector<int> &workers );
 };
 
 
@@ -33,8 +33,13 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
+
+#include <maya/MString.h>
 
 #include <liqIOStream.h>
+#include <liqProcessLauncher.h>
 
 #if defined(_WIN32) && !defined(DEFINED_LIQUIDVERSION)
 extern const char * LIQUIDVERSION ;
@@ -61,6 +66,23 @@ extern const char * LIQUIDVERSION ;
 class liqRenderScript
 {
 public:
+  // strings are saved as their length followed by their characters
+  static void saveString(std::ostream &out, const std::string &str)
+  {
+    out << " " << str.size() << ":" << str;
+  }
+
+  static bool loadString(std::istream &in, std::string &str)
+  {
+    size_t length;
+    char colon;
+    if (!(in >> length) || !in.get(colon) || colon != ':') {
+      return false;
+    }
+    str.resize(length);
+    return length == 0 || in.read(&str[0], length);
+  }
+
   // a Cmd object represents a single command line to be run as part of a job
   // needs to be a class rather than just a string, to carry along extra info about running the
   // command to be run (e.g. local or remote, alfred tags, etc)
@@ -116,6 +138,20 @@ public:
       
       return ss.str();
     }
+
+    void save(std::ostream &out) const
+    {
+      saveString(out, command);
+      out << " " << remote << " " << alfredExpand;
+      saveString(out, alfredTags);
+      saveString(out, alfredServices);
+    }
+
+    bool load(std::istream &in)
+    {
+      return loadString(in, command) && (in >> remote >> alfredExpand) &&
+             loadString(in, alfredTags) && loadString(in, alfredServices);
+    }
   };
 
   // a Job object encapsulates a single logical task to be run, with additional
@@ -236,6 +272,83 @@ public:
       return ss.str();
     }
     
+    // save the job and its subtasks so that another process can load them
+    void save(std::ostream &out) const
+    {
+      saveString(out, title);
+      saveString(out, chaserCommand);
+      out << " " << isInstance << " " << commands.size() << " " << cleanupCommands.size() << " " << childJobs.size();
+      for(std::vector<Cmd>::const_iterator command=commands.begin(); command!=commands.end(); ++command) {
+        command->save(out);
+      }
+      for(std::vector<Cmd>::const_iterator cleanup=cleanupCommands.begin(); cleanup!=cleanupCommands.end(); ++cleanup) {
+        cleanup->save(out);
+      }
+      for(std::vector<Job>::const_iterator child=childJobs.begin(); child!=childJobs.end(); ++child) {
+        child->save(out);
+      }
+    }
+
+    bool load(std::istream &in)
+    {
+      size_t numCommands, numCleanups, numChildren;
+      if (!loadString(in, title) || !loadString(in, chaserCommand) ||
+          !(in >> isInstance >> numCommands >> numCleanups >> numChildren)) {
+        return false;
+      }
+      commands.resize(numCommands);
+      cleanupCommands.resize(numCleanups);
+      childJobs.resize(numChildren);
+      for(std::vector<Cmd>::iterator command=commands.begin(); command!=commands.end(); ++command) {
+        if (!command->load(in)) return false;
+      }
+      for(std::vector<Cmd>::iterator cleanup=cleanupCommands.begin(); cleanup!=cleanupCommands.end(); ++cleanup) {
+        if (!cleanup->load(in)) return false;
+      }
+      for(std::vector<Job>::iterator child=childJobs.begin(); child!=childJobs.end(); ++child) {
+        if (!child->load(in)) return false;
+      }
+      return true;
+    }
+
+    // adds the commands of this job to a local run, after the ones of its
+    // subtasks and of the tasks it instances. ends gets the commands a job
+    // depending on this one has to wait for, cleanups don't hold anyone.
+    void flatten(std::vector<std::string> &commandLines, std::vector< std::vector<unsigned> > &dependencies,
+                 std::vector<std::string> &tasks, std::map< std::string, std::vector<unsigned> > &done,
+                 std::vector<unsigned> &ends) const
+    {
+      ends.clear();
+      if (isInstance) {
+        std::map< std::string, std::vector<unsigned> >::const_iterator instanced = done.find(title);
+        if (instanced != done.end()) {
+          ends = instanced->second;
+        }
+        return;
+      }
+
+      std::vector<unsigned> after;
+      for(std::vector<Job>::const_iterator child=childJobs.begin(); child!=childJobs.end(); ++child) {
+        std::vector<unsigned> childEnds;
+        child->flatten(commandLines, dependencies, tasks, done, childEnds);
+        after.insert(after.end(), childEnds.begin(), childEnds.end());
+      }
+      for(std::vector<Cmd>::const_iterator command=commands.begin(); command!=commands.end(); ++command) {
+        commandLines.push_back(command->command);
+        dependencies.push_back(after);
+        tasks.push_back(title);
+        after.assign(1, commandLines.size() - 1);
+      }
+      ends = after;
+      done[title] = ends;
+      for(std::vector<Cmd>::const_iterator cleanup=cleanupCommands.begin(); cleanup!=cleanupCommands.end(); ++cleanup) {
+        commandLines.push_back(cleanup->command);
+        dependencies.push_back(after);
+        tasks.push_back(title);
+        after.assign(1, commandLines.size() - 1);
+      }
+    }
+
     // adds a job as a dependency of any 'leaf' jobs anywhere under the hierarchy
     // of this job. i.e. any job with no children will get this as a child
     // good for tacking instances onto the end of job trees
@@ -376,6 +489,43 @@ public:
     return true;
   }
   
+  // run the jobs on this machine, at most processes commands at once.
+  // Tasks depending on a failed one are cancelled, failed gets the titles
+  // of the tasks that did not complete.
+  bool execute(const MString &path, unsigned processes, std::set<std::string> &failed) const
+  {
+    std::vector<std::string> commandLines;
+    std::vector< std::vector<unsigned> > dependencies;
+    std::vector<std::string> tasks;
+    std::map< std::string, std::vector<unsigned> > done;
+    std::vector<unsigned> all;
+    for(std::map<int, Job>::const_iterator job=jobs.begin(); job!=jobs.end(); ++job) {
+      std::vector<unsigned> ends;
+      job->second.flatten(commandLines, dependencies, tasks, done, ends);
+      all.insert(all.end(), ends.begin(), ends.end());
+    }
+    for(std::vector<Cmd>::const_iterator cmd=cleanupCommands.begin(); cmd!=cleanupCommands.end(); ++cmd) {
+      commandLines.push_back(cmd->command);
+      dependencies.push_back(all);
+      tasks.push_back(title);
+    }
+
+    std::vector<MString> commands;
+    for(std::vector<std::string>::const_iterator line=commandLines.begin(); line!=commandLines.end(); ++line) {
+      commands.push_back(MString(line->c_str()));
+    }
+    std::vector<bool> succeeded;
+    liqProcessLauncher::execute(commands, dependencies, path, processes, succeeded);
+
+    failed.clear();
+    for(unsigned i=0; i<tasks.size(); ++i) {
+      if (!succeeded[i]) {
+        failed.insert(tasks[i]);
+      }
+    }
+    return failed.empty();
+  }
+
   void addLeafDependency(const Job &job)
   {
     for(std::map<int, Job>::iterator j=jobs.begin(); j!=jobs.end(); ++j) {
@@ -64,6 +64,8 @@ public:
   bool supports_DOF;
   bool supports_ADVANCED_VISIBILITY;
   bool supports_DISPLAY_CHANNELS;
+  bool supports_POINT_SPHERES;     // RiPoints with "constant string type" "sphere"
+  bool supports_INLINE_ARCHIVES;   // ArchiveBegin / ArchiveEnd
 
   // pixel filters
   bool pixelfilter_BOX;
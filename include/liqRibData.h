@@ -47,8 +47,22 @@ public:
     virtual bool    compare( const liqRibData & other ) const = 0;
     virtual ObjectType type() const = 0;
     virtual void    addAdditionalSurfaceParameters( MObject node );
+    // Geometry that can write simplified versions of itself for RiDetailRange.
+    // Level 0 is the full resolution geometry.
+    virtual unsigned detailLevels() const;
+    virtual void    writeDetailLevel( unsigned level );
+    virtual void    detailRange( unsigned level, RtFloat fullDetailArea, RtFloat range[4] ) const;
+    // Add what write() outputs to a fingerprint. False if that can't be
+    // told without writing it, as for ribgens.
+    virtual bool    hash( liqHash &h ) const;
     std::vector<liqTokenPointer> tokenPointerArray;
     MDagPath	objDagPath;
+protected:
+    // the type and the primitive variables, for the hash() of subclasses
+    void            hashTokens( liqHash &h ) const;
+    // move a token that could not be built in tokenPointerArray into it,
+    // leaving token empty
+    void            addToken( liqTokenPointer &token );
 private:
     void  parseVectorAttributes( MFnDependencyNode &nodeFn, MStringArray & strArray, ParameterType pType );
     unsigned int faceVaryingCount;
@@ -45,6 +45,12 @@ extern "C" liqRibGen    *RIBGenCreate();
 extern "C" void       RIBGenDestroy( liqRibGen * );
 extern "C" void RiFlush( void );
 
+// Optional. A ribgen that only writes to ribStatus->ribFP, makes no Ri
+// calls and keeps no global state may be run on several threads at once,
+// put LIQUID_RIBGEN_THREADSAFE once in its source to say so.
+extern "C" int RIBGenIsThreadSafe();
+#define LIQUID_RIBGEN_THREADSAFE extern "C" int RIBGenIsThreadSafe() { return 1; }
+
 class liqRibGen
 {
 public:
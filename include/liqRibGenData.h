@@ -35,6 +35,7 @@
 ** ______________________________________________________________________
 */
 
+#include <vector>
 #include <liqRibData.h>
 #include <liqRibStatus.h>
 
@@ -49,10 +50,20 @@ public: // Methods
     virtual void       write();
     virtual bool       compare( const liqRibData & other ) const;
     virtual ObjectType type() const;
-    
+
+    // Run the thread safe ribgens of the list on numThreads threads, each
+    // into its own buffer which write() then splices into the RIB stream.
+    // The others are left for write() to run as usual.
+    static void        generate( std::vector<liqRibGenData*> &ribGens, unsigned numThreads );
+
+private: // Methods
+    void               setupStatus();
+    void               releaseGenerated();
+
 private: // Data
     MString 	    ribGenSoName;
     liqRibStatus	ribStatus;
+    FILE         *generatedFP;
 };
 
 #endif
@@ -0,0 +1,62 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+#ifndef liqRibGenRegistry_H
+#define liqRibGenRegistry_H
+
+/* ______________________________________________________________________
+**
+** Liquid Rib Gen Registry Header File
+** ______________________________________________________________________
+*/
+
+#include <maya/MString.h>
+
+class liqRibGen;
+
+// Ribgen libraries, each loaded the first time a ribgen asks for it and
+// kept open until unloadAll() at the end of the frame range.
+class liqRibGenRegistry {
+public:
+  typedef liqRibGen *(*createRibGen)();
+  typedef void (*destroyRibGen)( liqRibGen * );
+  typedef int (*threadSafeRibGen)();
+
+  struct library {
+    void          *handle;
+    createRibGen   create;
+    destroyRibGen  destroy;
+    bool           threadSafe;    // exports RIBGenIsThreadSafe() returning non zero
+  };
+
+  // NULL if the library or its entry points can't be found. The error is
+  // only reported the first time.
+  static const library *get( const MString &soName, const char *objectName );
+  static void unloadAll();
+};
+
+#endif
@@ -45,6 +45,7 @@ public:
 
   virtual void       write();
   virtual bool       compare( const liqRibData & other ) const;
+  virtual bool       hash( liqHash &h ) const;
   virtual ObjectType type() const;
 
   RtLightHandle lightHandle() const;
@@ -0,0 +1,59 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+#ifndef liqRibManifest_H
+#define liqRibManifest_H
+
+/* ______________________________________________________________________
+**
+** Liquid RIB Manifest Header File
+** ______________________________________________________________________
+*/
+
+#include <maya/MString.h>
+
+// Fingerprints of the job RIBs of each frame, kept in a manifest in the
+// RIB directory. A job RIB is written aside first and only replaces the
+// previous one when its fingerprint changed, so re-exporting a range
+// leaves the RIBs of unchanged jobs untouched. The fingerprint of what a
+// RIB was made from is kept too : a job made from the same inputs is not
+// written at all.
+class liqRibManifest {
+public:
+  // true if the RIB on disk was made from these inputs, never for empty ones
+  static bool upToDate( const MString &ribName, const MString &inputs );
+  // where to write a job RIB before commit()
+  static MString pendingName( const MString &ribName );
+  // compare the RIB written to pendingName() with the manifest and replace
+  // or drop it, true if the RIB changed. The inputs it was made from are
+  // recorded either way.
+  static bool commit( const MString &ribName, const MString &inputs = "" );
+  // rewrite the manifest, keeping only the latest record of each RIB
+  static void save();
+};
+
+#endif
@@ -37,6 +37,7 @@
 */
 
 #include <liqRibData.h>
+#include <liqMeshLOD.h>
 
 class liqRibMeshData : public liqRibData {
 public: // Methods
@@ -46,8 +47,13 @@ public: // Methods
 
     virtual void       write();
     virtual bool       compare( const liqRibData & other ) const;
+    virtual bool       hash( liqHash &h ) const;
     virtual ObjectType type() const;
 
+    virtual unsigned   detailLevels() const;
+    virtual void       writeDetailLevel( unsigned level );
+    virtual void       detailRange( unsigned level, RtFloat fullDetailArea, RtFloat range[4] ) const;
+
 private: // Data
 	RtInt     numFaces;
 	RtInt     numPoints;
@@ -61,6 +67,9 @@ private: // Data
     MString 	name;
     RtMatrix	transformationMatrix;
     float   	areaIntensity;
+
+    const liqMeshLOD *lod;  // decimated levels, shared by all meshes of this topology
+    std::vector< std::vector<liqTokenPointer> > levelTokens;  // primvars of each level, remapped on the first write
 };
 
 #endif
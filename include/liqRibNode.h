@@ -41,8 +41,11 @@
 #include <maya/MColor.h>
 #include <maya/MFnDependencyNode.h>
 #include <maya/MDagPath.h>
+#include <maya/MBoundingBox.h>
 #include <maya/MObjectArray.h>
 
+#include <vector>
+
 
 //enum transmissions {TRANS, OPAQUE, OS, SHADER};
 
@@ -95,6 +98,12 @@ class liqRibNode {
     void     doRibGen();
     RtBound  bound;
     RtBound  shadowBound;
+    MBoundingBox objectBound;    /* object space bound over all motion samples */
+    MBoundingBox worldBound;     /* world space bound over all motion samples */
+    bool     hasWorldBound;      /* false if the geometry can't be bounded from Maya */
+    bool     noCull;             /* never culled when out of view */
+    MString  geometryHandle;     /* inline archive holding the shapes, empty if written in place */
+    std::vector<bool> ignoredLightBits;  /* lights turned off for the object, by index in the light links of the scan */
     bool     doDef;    /* Used for per-object deformation blur */
     bool     doMotion;  /* Used for per-object transformation blur */
 
@@ -102,6 +111,9 @@ class liqRibNode {
 
     MString  getInstanceStr() { return instanceStr; };
     bool     hasNObjects( unsigned n );
+    // add the attributes and the samples of the object to a fingerprint,
+    // false if what it outputs can't be told from Maya
+    bool     hash( liqHash &h );
     bool     colorOverridden() { return overrideColor; };
 
 
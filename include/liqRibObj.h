@@ -37,14 +37,18 @@
 
 #include <liqRibData.h>
 
+class liqRibGenData;
+
 class liqRibObj {
 public:
-    liqRibObj( const MDagPath &, ObjectType objType );
+    liqRibObj( const MDagPath &, ObjectType objType, const liqRibObj *firstSample = NULL );
     ~liqRibObj();
 
     AnimType compareMatrix(const liqRibObj *, int instance);
     AnimType compareBody(const liqRibObj *);
-    void     writeObject(); // write geometry directly
+    void     writeObject( unsigned detailLevel = 0 ); // write geometry directly
+    unsigned detailLevels() const;
+    void     detailRange( unsigned detailLevel, RtFloat fullDetailArea, RtFloat range[4] ) const;
 
     int    type;
     int    written;
@@ -55,12 +59,16 @@ public:
 
     MMatrix matrix( int instance ) const;
     void    setMatrix( int instance, MMatrix matrix );
+    // add the instance matrix and the geometry to a fingerprint, false if
+    // the geometry can't be fingerprinted
+    bool    hash( liqHash &h, int instance ) const;
 
     void ref();
     void unref();
 
     RtObjectHandle handle() const;
     RtLightHandle  lightHandle() const;
+    liqRibGenData *ribGenData() const;
     void setHandle( RtObjectHandle handle );
 
 private:
@@ -34,6 +34,7 @@
 */
 
 #include <liqRibData.h>
+#include <liqParticleCache.h>
 #include <maya/MIntArray.h>
 
 class liqRibParticleData : public liqRibData {
@@ -44,6 +45,7 @@ public:
         
     virtual void	write();
     virtual bool	compare( const liqRibData & other ) const;
+    virtual bool	hash( liqHash &h ) const;
     virtual ObjectType	type() const;
 
     void addAdditionalParticleParameters( MObject node );
@@ -71,6 +73,10 @@ public:
     pType particleType; 
     
 private:
+    // per particle arrays from the disk cache if there is one, else from the node
+    bool getDoubleArray( MFnDependencyNode &nodeFn, const MString &attr, MDoubleArray &array );
+    bool getVectorArray( MFnDependencyNode &nodeFn, const MString &attr, MVectorArray &array );
+
     // Data storage for blobby particles 
     RtInt     bCodeArraySize;
     RtInt*    bCodeArray;	
@@ -84,6 +90,10 @@ private:
     unsigned  m_numParticles;
     unsigned  m_numValidParticles;
     short     m_multiCount;  // Support for multi-point and multi-streak.
+    bool      m_spheresAsPoints; // spheres go out as a single RiPoints
+
+    liqParticleCache  m_cache;
+    bool              m_haveCache;
 };
 
 #endif
@@ -63,6 +63,7 @@ public: // Methods
 
   virtual void       write();
   virtual bool       compare( const liqRibData & other ) const;
+  virtual bool       hash( liqHash &h ) const;
   virtual ObjectType type() const;
 
 private: // Data
@@ -36,14 +36,33 @@
 
 #include <liqRibData.h>
 
+// Trim loops of a surface in RiTrimCurve layout. They can't be motion
+// blurred, so all the motion samples of a surface share one copy.
+class liqRibTrimData {
+public:
+  liqRibTrimData();
+
+  void ref();
+  void unref();
+
+  RtInt    nloops;
+  RtInt   *ncurves, *order, *n;
+  RtFloat *knot, *minKnot, *maxKnot, *u, *v, *w;
+
+private:
+  ~liqRibTrimData();
+  int      referenceCount;
+};
+
 class liqRibSurfaceData : public liqRibData {
 public: // Methods
 
-  liqRibSurfaceData( MObject surface );
+  liqRibSurfaceData( MObject surface, const liqRibSurfaceData *firstSample = NULL );
   virtual ~liqRibSurfaceData();
 
   virtual void write();
   virtual bool compare( const liqRibData & other ) const;
+  virtual bool hash( liqHash &h ) const;
   virtual ObjectType type() const;
 
   bool hasTrimCurves() const;
@@ -61,10 +80,7 @@ private: // Data
   RtFloat *CVs;
 
   // Trim information
-
-  RtInt    nloops;
-  RtInt   *ncurves, *order, *n;
-  RtFloat *knot, *minKnot, *maxKnot, *u, *v, *w;
+  liqRibTrimData *trims;
 };
 
 #endif
@@ -42,12 +42,15 @@
 #include <liqRenderScript.h>
 #include <liqRibLightData.h>
 #include <liqExpression.h>
+#include <liqFrustum.h>
 
 #include <maya/MPxCommand.h>
 #include <maya/MDagPathArray.h>
 #include <maya/MFnCamera.h>
 #include <maya/MArgList.h>
 #include <maya/MFloatArray.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MNodeMessage.h>
 
 #include <map>
 
@@ -89,6 +92,43 @@ private: // Methods
   MStatus lightBlock();
   MStatus coordSysBlock();
   MStatus objectBlock();
+  MStatus geometryArchive( long frame );
+  void writeGeometry( liqRibNode *ribNode, bool deformationBlur );
+  void lightLinks();
+
+  typedef enum {
+    liqRegularShaderNode = 0,   // A regular Liquid node, keep it 0 to evaluate to false in conditions
+    liqCustomPxShaderNode = 1,  // A custom MPxNode inheriting from liqCustomNode
+    liqRibBoxShader = 2         // A rib box attached to the shader
+  } liqDetailShaderKind;
+
+  // the shaders an object is rendered with
+  struct shaderAssignment {
+    bool                hasSurfaceShader;
+    bool                hasDisplacementShader;
+    bool                hasVolumeShader;
+    liqDetailShaderKind hasCustomSurfaceShader;
+    liqDetailShaderKind hasCustomDisplacementShader;
+    liqDetailShaderKind hasCustomVolumeShader;
+    MString             surfaceShaderRibBox;
+    MString             displacementShaderRibBox;
+    MString             volumeShaderRibBox;
+  };
+  // an object of a job with its shaders and the material group it goes
+  // out in, empty when it is written with its own shaders
+  struct materialMember {
+    std::string         material;
+    liqRibNode         *ribNode;
+    shaderAssignment    shaders;
+    bool operator<( const materialMember &other ) const { return material < other.material; }
+  };
+  void getShaderAssignment( liqRibNode *ribNode, shaderAssignment &shaders );
+  std::string materialKey( liqRibNode *ribNode, const shaderAssignment &shaders );
+  void writeMaterial( liqRibNode *ribNode, const shaderAssignment &shaders );
+  void writeShader( liqShader &currentShader, SHADER_TYPE type );
+  void getDisplacementBound( liqRibNode *ribNode, float &bound, MString &space );
+  void jobFrustums( const structJob &job, std::vector<liqFrustum> &frustums, double margin = 0, double distance = 0 );
+  bool inFrustums( liqRibNode *ribNode, const std::vector<liqFrustum> &frustums );
   MStatus worldEpilogue();
   MStatus frameEpilogue( long );
   void doAttributeBlocking( const MDagPath & newPath,  const MDagPath & previousPath );
@@ -98,6 +138,7 @@ private: // Methods
   MString generateTempMayaSceneName() const;
   MString generateFileName( fileGenMode mode, const structJob& job );
   MString generateShadowArchiveName( bool renderAllFrames, long renderAtframe, MString geometrySet );
+  MString generateGeometryArchiveName( long frame );
   static bool renderFrameSort( const structJob& a, const structJob& b );
 
 private: // Data
@@ -128,6 +169,10 @@ private: // Data
   liquidlong frameLast;
   liquidlong frameBy;
   MString    m_frameList;
+  int        m_frameWorkers;  // liquidBin processes exporting the frames
+  unsigned   m_frameWorker;   // index of this frame exporting process, 0 for the main one
+  int        m_frameChunkSize;  // consecutive frames rendered from one RIB per job
+  unsigned   m_chunkFrames;     // frames per chunk in this export, 1 when not chunking
   liquidlong width, height, depth;
 
   // alfred stuff
@@ -317,12 +362,26 @@ private :
   bool m_outputHeroPass;
   bool m_deferredGen;
   bool m_lazyCompute;
+  bool m_cullShadowObjects;
   bool m_outputShadersInShadows;
   bool m_outputShadersInDeepShadows;
   bool m_outputLightsInDeepShadows;
   liquidlong m_deferredBlockSize;
   bool m_outputComments;
   bool m_shaderDebug;
+  bool m_groupByMaterial;
+  int m_textureProcesses;   // texture conversions run at once when rendering locally
+  int m_ribJobProcesses;    // processes writing the job RIBs of a frame in batch mode
+  unsigned m_jobWorker;     // index of this job RIB writing process, 0 for the main one
+  bool m_cullCameraObjects;
+  double m_cullMargin;      // part of the frame added around the view when culling
+  double m_cullDistance;    // culling depth from the camera, 0 for the far clipping plane
+  bool m_shareGeometry;
+  bool m_incrementalRibs;   // only replace the RIBs whose contents changed
+  MString m_outputArgs;     // command arguments changing the RIBs
+  MString m_scanInputs;     // fingerprint of the current scan, empty if it can't be made
+  MString m_geometryArchive;      // shapes of the frame shared by all its jobs, empty if not shared
+  std::vector<liqRibNode*> m_linkedLights;  // lights of the scan indexed by liqRibNode::ignoredLightBits
 
   long m_currentLiquidJobNumber;
 
@@ -431,11 +490,51 @@ private :
   bool          m_depthMaskReverseSign;
   float         m_depthMaskDepthBias;
 
-  std::vector<liqShader> m_shaders;
+  // shaders are kept across frames and jobs, and rebuilt when their node
+  // changes or, for animated ones, when the time changes
+  struct shaderCacheEntry {
+    liqShader     *shader;
+    MObjectHandle  node;
+    MCallbackId    callback;
+    bool           dirty;
+    double         time;
+  };
+  std::map<std::string, shaderCacheEntry*> m_shaders;
+  static void shaderChangedCallback( MNodeMessage::AttributeMessage msg, MPlug &plug, MPlug &otherPlug, void *clientData );
 
   liqShader & liqGetShader( MObject shaderObj );
   MStatus liqShaderParseVectorAttr ( liqShader & currentShader, MFnDependencyNode & shaderNode, const char * argName, ParameterType pType );
   void freeShaders( void );
+  // first map of the export made from a shadow fingerprint
+  struct shadowSource {
+    MString mapName;    // absolute name of the map
+    MString imageName;  // name of the map in the render script
+    long    frame;      // frame whose shadows render it
+    bool    current;    // the map is already up to date, or it still has to be rendered
+  };
+  std::map<std::string, shadowSource> m_shadowSources;
+  void hashGlobals( liqHash &h );
+  bool hashShaders( liqHash &h, liqRibNode *ribNode );
+  MString scanFingerprint( long scanTime );
+  MString jobFingerprint( const structJob &job );
+  MString shadowFingerprint( const structJob &job );
+  bool shadowUpToDate( structJob &job, const MString &fingerprint );
+  void skipUpToDateShadow( structJob &job );
+  bool ribUpToDate( const MString &ribName, const MString &inputs );
+  MString ribOutputName( const MString &ribName );
+  void ribWritten( const MString &ribName, const MString &inputs = "" );
+  bool joinJobWorkers( std::vector<int> &workers, const std::vector<unsigned> &jobWorkers, unsigned groupBegin, unsigned groupEnd );
+
+  // the RIBs of a job over the frames of the current chunk
+  struct chunkJob {
+    structJob     job;            // job of the first frame of the chunk
+    MString       ribFileName;    // chunk RIB, declaring the options once
+    MStringArray  frames;         // frame RIBs read by the chunk RIB
+  };
+  std::map<unsigned, chunkJob> m_chunkJobs;   // by index in the job list
+  bool m_chunkFrame;              // the job RIB being written is a frame of a chunk
+  MStatus writeChunkRibs();
+  const chunkJob *chunkOf( const MString &frameRibName ) const;
 
   void scanExpressions( liqShader & currentShader );
   void scanExpressions( liqRibLightData *light );
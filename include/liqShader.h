@@ -34,7 +34,6 @@
 
 #include <liqTokenPointer.h>
 #include <liqGetSloInfo.h>
-#define MR_SURFPARAMSIZE 1024
 
 #include <string>
 #include <vector>
@@ -49,10 +48,15 @@ public :
     liqShader ( MObject shaderObj );
     MStatus liqShaderParseVectorAttr ( MFnDependencyNode & shaderNode, const char * argName, ParameterType pType );
     MStatus liqShaderParseVectorArrayAttr ( MFnDependencyNode & shaderNode, const char * argName, ParameterType pType, unsigned int arraySize );
+    bool isDefault( liqGetSloInfo & shaderInfo, int arg, liqTokenPointer & token );
     ~liqShader();
     void freeShader( void );
+    // slot for the next parameter, numTPV is bumped once it has been filled
+    liqTokenPointer & nextParameter( void );
+    // add what writeShader() outputs to a fingerprint
+    void hash( liqHash &h ) const;
     int numTPV;
-    liqTokenPointer	tokenPointerArray[MR_SURFPARAMSIZE];
+    std::vector<liqTokenPointer> tokenPointerArray;
     std::string name;
     std::string file;
     RtColor     rmColor;
@@ -63,6 +67,7 @@ public :
     RtFloat     displacementBound;
     bool        outputInShadow;
     bool        hasErrors;
+    bool        isAnimated;   // values may change from frame to frame
     SHADER_TYPE shader_type;
     MString     shaderSpace;
 };
@@ -0,0 +1,85 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+#ifndef liqShaderInfo_H
+#define liqShaderInfo_H
+
+/* ______________________________________________________________________
+**
+** Liquid Shader Info Header File
+** ______________________________________________________________________
+*/
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <maya/MString.h>
+#include <maya/MStringArray.h>
+
+#include <liqGetSloInfo.h>
+
+// What a compiled shader declares : its type and its parameters with their
+// defaults. Read with the renderer's shader library when liquid is built
+// for one that has it, else with the liquidSl* mel parsers, and kept in a
+// cache file keyed by path and modification time.
+class liqShaderInfo {
+public:
+  struct param {
+    std::string               name;
+    SHADER_TYPE               type;
+    SHADER_DETAIL             detail;
+    int                       arraySize;  // 0 if not an array
+    bool                      isOutput;
+    std::vector<float>        floats;     // defaults, item after item
+    std::vector<std::string>  strings;
+  };
+
+  std::string         name;
+  SHADER_TYPE         type;
+  std::vector<param>  params;
+
+  // NULL if the shader can't be read
+  static const liqShaderInfo *get( const MString &shaderFile );
+
+  // default of a parameter formatted like the liquidSl* parsers do
+  MString melDefault( unsigned i ) const;
+
+  // name, type, number of parameters then name, detail, type, output,
+  // array size and default of each parameter : liquidGetSloInfo -info
+  void    melInfo( MStringArray &info ) const;
+
+  // a record of the cache file
+  bool    read( FILE *fp );
+  void    write( FILE *fp ) const;
+
+private:
+  bool    readNative( const MString &shaderFile );
+  bool    readMel( const MString &shaderFile );
+};
+
+#endif
@@ -0,0 +1,54 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+#ifndef liqTextureCache_H
+#define liqTextureCache_H
+
+/* ______________________________________________________________________
+**
+** Liquid Texture Cache Header File
+** ______________________________________________________________________
+*/
+
+#include <maya/MString.h>
+
+// Remembers what each converted texture was made from, in a manifest next
+// to the textures. A texture is only converted again when the contents of
+// its source or the conversion options change, touching a source isn't
+// enough. A texture remade after it was recorded, by a render script job,
+// is taken as made from its current source.
+class liqTextureCache {
+public:
+  // true if dest was made from the current contents of source with options
+  static bool upToDate( const MString &source, const MString &options, const MString &dest );
+  // dest was converted successfully, from what the last upToDate() saw
+  static void converted( const MString &dest );
+  // write the manifest if anything changed
+  static void save();
+};
+
+#endif
@@ -30,6 +30,8 @@ extern "C" {
 }
 // token/pointer pairs structure
 
+class liqHash;
+
 enum ParameterType {
   rFloat  = 0,
   rPoint  = 1,
@@ -57,6 +59,8 @@ class liqTokenPointer
     liqTokenPointer(const liqTokenPointer &src);
     liqTokenPointer & operator=( const liqTokenPointer &src);
     ~liqTokenPointer();
+    // exchange contents with other, nothing is copied
+    void           swap( liqTokenPointer &other );
     void           setTokenName( const char * name );
     char          *getTokenName( void );
     char          *getDetailedTokenName( void );
@@ -79,17 +83,43 @@ class liqTokenPointer
     char*          getTokenString( void );
     void           resetTokenString( void );
     ParameterType  getParameterType( void );
+    unsigned int   getArraySize( void );     // number of elements, without the uArraySize factor
+    unsigned int   getUArraySize( void );    // 0 if this is not a two dimensional array
+    unsigned int   getElementSize( void );   // floats per element and u index
+    bool           isNurbs( void );
     RtPointer      getRtPointer( void );
     void           getRiDeclare( char * declare );
+#ifdef GENERIC_RIBLIB
+    // what getRiDeclare() says, for RiParameterTypes()
+    void           getRiParameterType( RtParameterType &type );
+#endif
     bool           isBasicST( void );
     void           reset( void );
+    // add the declaration and the values to a fingerprint
+    void           hash( liqHash &h ) const;
+    // forget the interned token names, if no token is alive to use them
+    static void    releaseNames( void );
   private:
+    // Copies share their floats, which carry a reference count in front
+    // and are only duplicated when one of the copies is written to.
+    union floatsHeaderType {
+      long   refCount;
+      double align;
+    };
+    static RtFloat          *allocFloats( unsigned long size );
+    static floatsHeaderType *floatsHeader( RtFloat *floats );
+    static const char       *internName( const char *name );
+    static unsigned long     liveTokens;
+    void           copy( const liqTokenPointer &src );
+    void           releaseFloats( void );
+    bool           detachFloats( void );
+
     RtFloat *m_tokenFloats;
     char **m_tokenString;
     ParameterType m_pType;
     DetailType m_dType;
-    char m_tokenName[256];
-    char m_detailedTokenName[256];
+    const char *m_tokenName;          // both interned, see internName()
+    const char *m_detailedTokenName;
     unsigned int m_arraySize;
     unsigned int m_uArraySize;
     unsigned int m_eltSize;
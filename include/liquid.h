@@ -318,6 +318,8 @@ struct structJob {
   MString               shadowObjectSet;
   bool                  shadowArchiveRibDone;
   bool                  skip;
+  MString               copyOf;     // map of an earlier frame made from the same inputs, copied instead of rendered
+  long                  copyAfter;  // frame rendering copyOf
 };
 
 typedef enum {
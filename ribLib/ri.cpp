@@ -2198,3 +2198,10 @@ RiVisibility(RtInt n,RtPoint *from,RtPoint *to,RtPoint *Oi) {
 
 	renderMan->RiVisibility(n,from,to,Oi);
 }
+
+EXTERN(RtVoid)
+RiParameterTypes(RtInt n,RtParameterType types[]) {
+	if (check("RiParameterTypes",RENDERMAN_BLOCK | RENDERMAN_FRAME_BLOCK | RENDERMAN_WORLD_BLOCK | RENDERMAN_ATTRIBUTE_BLOCK | RENDERMAN_XFORM_BLOCK | RENDERMAN_SOLID_PRIMITIVE_BLOCK | RENDERMAN_OBJECT_BLOCK | RENDERMAN_MOTION_BLOCK)) return;
+
+	renderMan->RiParameterTypes(n,types);
+}
@@ -563,6 +563,37 @@ EXTERN(RtVoid)
 EXTERN(RtVoid)
 	RiVisibility(RtInt,RtPoint *,RtPoint *,RtPoint *);
 
+/* Liquid extension : the types of a parameter list, given up front so its
+   tokens can be the bare names and need no parsing. A parameter of a later
+   call uses the type at its index if its token is the very same pointer. The
+   array must stay valid until that list has been written, the writer then
+   forgets it as RiParameterTypes(0,NULL) does. */
+typedef struct RtParameterType {
+	RtToken	token;			/* bare name, as passed in the parameter list */
+	RtInt	type;			/* RI_PARAMETER_FLOAT ... */
+	RtInt	detail;			/* RI_PARAMETER_CONSTANT ... */
+	RtInt	arraySize;		/* 0 if the parameter is not an array */
+} RtParameterType;
+
+#define RI_PARAMETER_FLOAT			0
+#define RI_PARAMETER_COLOR			1
+#define RI_PARAMETER_VECTOR			2
+#define RI_PARAMETER_NORMAL			3
+#define RI_PARAMETER_POINT			4
+#define RI_PARAMETER_MATRIX			5
+#define RI_PARAMETER_HPOINT			6
+#define RI_PARAMETER_STRING			7
+#define RI_PARAMETER_INTEGER		8
+
+#define RI_PARAMETER_CONSTANT		0
+#define RI_PARAMETER_UNIFORM		1
+#define RI_PARAMETER_VARYING		2
+#define RI_PARAMETER_VERTEX			3
+#define RI_PARAMETER_FACEVARYING	4
+
+EXTERN(RtVoid)
+	RiParameterTypes(RtInt n,RtParameterType types[]);
+
 
 /*
     Error codes
@@ -374,6 +374,9 @@ void		CRiInterface::RiTrace(int,float [][3],float [][3],float [][3],float []) {
 void		CRiInterface::RiVisibility(int,float [][3],float [][3],float [][3]) {
 }
 
+void		CRiInterface::RiParameterTypes(int /*n*/,RtParameterType * /*types*/) {
+}
+
 void		CRiInterface::RiError(int c,int s,char *m) {
 	if (errorHandler != NULL) {
 		errorHandler(c,s,m);
@@ -34,6 +34,8 @@
 #include <stdio.h>
 #include <stdarg.h>
 
+struct RtParameterType;
+
 ///////////////////////////////////////////////////////////////////////
 // Class				:	CRiInterface
 // Description			:	This is the virtual class that implements the RenderMan interface
@@ -177,6 +179,8 @@ public:
 	virtual	void		RiTrace(int,float [][3],float [][3],float [][3],float []);
 	virtual	void		RiVisibility(int,float [][3],float [][3],float [][3]);
 
+	virtual	void		RiParameterTypes(int n,RtParameterType *types);
+
 	virtual	void		RiError(int,int,char *);
 
 protected:
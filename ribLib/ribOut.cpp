@@ -123,6 +123,8 @@ CRibOut::CRibOut(const char *n) : CRiInterface() {
 	numObjects			=	1;
 	attributes			=	new CRibAttributes;
 	scratch				=	new char[ribOutScratchSize];
+	parameterTypes		=	NULL;
+	numParameterTypes	=	0;
 
 	// Write a header
 //	out("## Pixie %d.%d.%d\n",VERSION_RELEASE,VERSION_BETA,VERSION_ALPHA);
@@ -148,6 +150,8 @@ CRibOut::CRibOut(FILE *o) : CRiInterface() {
 	numObjects			=	1;
 	attributes			=	new CRibAttributes;
 	scratch				=	new char[ribOutScratchSize];
+	parameterTypes		=	NULL;
+	numParameterTypes	=	0;
 
 	// Write a header
 //	out("## Pixie %d.%d.%d\n",VERSION_RELEASE,VERSION_BETA,VERSION_ALPHA);
@@ -1295,8 +1299,14 @@ void		CRibOut::RiTrace(int,float [][3],float [][3],float [][3],float []) {
 void		CRibOut::RiVisibility(int,float [][3],float [][3],float [][3]) {
 }
 
+void		CRibOut::RiParameterTypes(int n,RtParameterType *types) {
+	parameterTypes		=	types;
+	numParameterTypes	=	n;
+}
+
 void		CRibOut::writePL(int numParameters,char *tokens[],void *vals[]) {
 	int		i,j;
+	int		typed	=	FALSE;
 	float	*f;
 	int		*iv;
 	char	**s;
@@ -1304,13 +1314,20 @@ void		CRibOut::writePL(int numParameters,char *tokens[],void *vals[]) {
 	for (i=0;i<numParameters;i++) {
 		CVariable	tmpVar;
 		CVariable	*variable;
+		char		declaration[256];
+		const char	*name	=	tokens[i];
 
 		map<string,CVariable*>::iterator it;
-		if (( it = declaredVariables->find(tokens[i])) != declaredVariables->end()) {
+		if (typedVariable(i,tokens[i],&tmpVar)) {
+			variable	=	&tmpVar;
+			name		=	typedName(i,tokens[i],&tmpVar,declaration);
+			typed		=	TRUE;
+			goto retry;
+		} else if (( it = declaredVariables->find(tokens[i])) != declaredVariables->end()) {
 			variable = it->second;
 retry:;
 
-			out(" \"%s\" [",tokens[i]);
+			out(" \"%s\" [",name);
 
 			switch(variable->type) {
 			case TYPE_FLOAT:
@@ -1386,10 +1403,14 @@ retry:;
 	}
 
 	out("\n");
+
+	// The types were for this list only
+	if (typed)	RiParameterTypes(0,NULL);
 }
 
 void		CRibOut::writePL(int numVertex,int numVarying,int numFaceVarying,int numUniform,int numParameters,char *tokens[],void *vals[]) {
 	int		i,j;
+	int		typed	=	FALSE;
 	float	*f;
 	char	**s;
 
@@ -1420,12 +1441,19 @@ void		CRibOut::writePL(int numVertex,int numVarying,int numFaceVarying,int numUn
 	for (i=0;i<numParameters;i++) {
 		CVariable	tmpVar;
 		CVariable	*variable;
+		char		declaration[256];
+		const char	*name	=	tokens[i];
 
 		map<string,CVariable*>::iterator it;
-		if ((it = declaredVariables->find(tokens[i])) != declaredVariables->end()) {
+		if (typedVariable(i,tokens[i],&tmpVar)) {
+			variable	=	&tmpVar;
+			name		=	typedName(i,tokens[i],&tmpVar,declaration);
+			typed		=	TRUE;
+			goto retry;
+		} else if ((it = declaredVariables->find(tokens[i])) != declaredVariables->end()) {
 			variable = it->second;
 retry:;
-			out(" \"%s\" [",tokens[i]);
+			out(" \"%s\" [",name);
 
 			switch(variable->type) {
 			case TYPE_FLOAT:
@@ -1502,9 +1530,58 @@ retry:;
 
 	out("\n");
 
+	// The types were for this list only
+	if (typed)	RiParameterTypes(0,NULL);
+
 #undef numItems
 }
 
+static const char			*typeNames[]		=	{ "float", "color", "vector", "normal", "point", "matrix", "hpoint", "string", "int" };
+static const char			*detailNames[]		=	{ "constant", "uniform", "varying", "vertex", "facevarying" };
+
+// Parameter i was typed by RiParameterTypes : fill the variable from it
+// rather than parse the token
+int			CRibOut::typedVariable(int i,const char *token,CVariable *variable) {
+	static const EVariableType	types[]				=	{ TYPE_FLOAT, TYPE_COLOR, TYPE_VECTOR, TYPE_NORMAL, TYPE_POINT, TYPE_MATRIX, TYPE_QUAD, TYPE_STRING, TYPE_INTEGER };
+	static const int			numFloats[]			=	{ 1, 3, 3, 3, 3, 16, 4, 1, 1 };
+	static const EVariableClass	containers[]		=	{ CONTAINER_CONSTANT, CONTAINER_UNIFORM, CONTAINER_VARYING, CONTAINER_VERTEX, CONTAINER_FACEVARYING };
+
+	if ((parameterTypes == NULL) || (i >= numParameterTypes))	return FALSE;
+
+	const RtParameterType	*p	=	parameterTypes + i;
+	if (p->token != token)										return FALSE;
+	if ((p->type < 0) || (p->type > RI_PARAMETER_INTEGER))		return FALSE;
+	if ((p->detail < 0) || (p->detail > RI_PARAMETER_FACEVARYING))	return FALSE;
+	if (strlen(token) > 200)									return FALSE;
+
+	variable->type		=	types[p->type];
+	variable->container	=	containers[p->detail];
+	variable->numItems	=	(p->arraySize > 0) ? p->arraySize : 1;
+	variable->numFloats	=	numFloats[p->type]*variable->numItems;
+
+	return TRUE;
+}
+
+// The name to write for typed parameter i : the bare token if it is
+// declared that way already, else the inline declaration, which is only
+// built then
+const char	*CRibOut::typedName(int i,const char *token,const CVariable *variable,char *declaration) {
+	map<string,CVariable*>::iterator it;
+	if ((it = declaredVariables->find(token)) != declaredVariables->end()) {
+		const CVariable	*declared	=	it->second;
+
+		if ((declared->type == variable->type) &&
+			(declared->container == variable->container) &&
+			(declared->numItems == variable->numItems))		return token;
+	}
+
+	const RtParameterType	*p	=	parameterTypes + i;
+	if (p->arraySize > 0)	sprintf(declaration,"%s %s[%d] %s",detailNames[p->detail],typeNames[p->type],p->arraySize,token);
+	else					sprintf(declaration,"%s %s %s",detailNames[p->detail],typeNames[p->type],token);
+
+	return declaration;
+}
+
 void		CRibOut::declareVariable(char *name,char *decl) {
 	CVariable	cVariable,*nVariable;
 
@@ -203,10 +203,14 @@ public:
 	virtual	void		RiTrace(int,float [][3],float [][3],float [][3],float []);
 	virtual	void		RiVisibility(int,float [][3],float [][3],float [][3]);
 
+	virtual	void		RiParameterTypes(int n,RtParameterType *types);
+
 private:
 	void				writePL(int,char *[],void *[]);
 	void				writePL(int numVertex,int numVarying,int numFaceVarying,int numUniform,int,char *[],void *[]);
 	void				declareVariable(char *,char *);
+	int					typedVariable(int,const char *,CVariable *);
+	const char			*typedName(int,const char *,const CVariable *,char *);
 	void				declareDefaultVariables();
 
 	const	char							*outName;
@@ -218,6 +222,8 @@ private:
 	int										numObjects;
 	CRibAttributes							*attributes;
 	char									*scratch;
+	RtParameterType							*parameterTypes;			// Types given by RiParameterTypes
+	int										numParameterTypes;
 
 											///////////////////////////////////////////////////////////////////////
 											// Class				:	CRibOut
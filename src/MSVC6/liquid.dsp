@@ -424,6 +424,34 @@ SOURCE=..\liqVolumeNode.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\liqParticleCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\liqMeshLOD.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\liqRibGenRegistry.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\liqShaderInfo.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\liqTextureCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\liqFrustum.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\liqRibManifest.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\liqWriteArchive.cpp
 # End Source File
 # End Group
@@ -628,6 +656,34 @@ SOURCE=..\..\include\liqVolumeNode.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\include\liqParticleCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\include\liqMeshLOD.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\include\liqRibGenRegistry.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\include\liqShaderInfo.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\include\liqTextureCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\include\liqFrustum.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\include\liqRibManifest.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\include\liqWriteArchive.h
 # End Source File
 # Begin Source File
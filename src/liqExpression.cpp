@@ -28,6 +28,7 @@
 #include <liqIOStream.h>
 #include <liqGlobalHelpers.h>
 #include <liqExpression.h>
+#include <liqTextureCache.h>
 
 extern int debugMode;
 
@@ -42,8 +43,7 @@ extern bool liqglo_shortShaderNames;
 extern MStringArray liqglo_DDimageName;
 
 liqExpression::liqExpression( char * str, char *objName ) :
-  destExists( false ),
-  destIsNewer( false ),
+  destUpToDate( false ),
   isValid( true ),
   type( exp_None ),
   object_name("")
@@ -108,8 +108,7 @@ MString	liqExpression::CalcValue( )
       }
 
       dest = liqglo_textureDir + value;
-      destExists = fileExists( dest );
-      destIsNewer = fileIsNewer( dest, source );
+      destUpToDate = liqTextureCache::upToDate( source, options, dest );
       break;
 
     case exp_ReflectMap:
@@ -0,0 +1,84 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+/* ______________________________________________________________________
+**
+** Liquid Frustum Source
+** ______________________________________________________________________
+*/
+
+#include <liqFrustum.h>
+
+#include <maya/MPoint.h>
+
+
+liqFrustum::liqFrustum( const MMatrix &worldToCamera, bool ortho,
+                        double left, double right, double bottom, double top,
+                        double neardb, double fardb )
+: m_worldToCamera( worldToCamera )
+{
+  double planes[6][4] = {
+    {  1,  0,  0,  0 },   // left
+    { -1,  0,  0,  0 },   // right
+    {  0,  1,  0,  0 },   // bottom
+    {  0, -1,  0,  0 },   // top
+    {  0,  0,  1, -neardb },
+    {  0,  0, -1,  fardb }
+  };
+  // the side planes go through the eye for a perspective camera and are
+  // parallel to the view direction for an orthographic one
+  unsigned side = ortho ? 3 : 2;
+  planes[0][side] = -left;
+  planes[1][side] =  right;
+  planes[2][side] = -bottom;
+  planes[3][side] =  top;
+
+  for ( unsigned p = 0; p < 6; p++ ) {
+    for ( unsigned k = 0; k < 4; k++ ) m_planes[p][k] = planes[p][k];
+  }
+}
+
+bool liqFrustum::intersects( const MBoundingBox &box ) const
+{
+  MPoint corners[8];
+  MPoint min = box.min();
+  MPoint max = box.max();
+  for ( unsigned c = 0; c < 8; c++ ) {
+    MPoint corner( ( c & 1 )? max.x : min.x, ( c & 2 )? max.y : min.y, ( c & 4 )? max.z : min.z );
+    corners[c] = corner * m_worldToCamera;
+  }
+
+  for ( unsigned p = 0; p < 6; p++ ) {
+    const double *plane = m_planes[p];
+    unsigned c = 0;
+    for ( ; c < 8; c++ ) {
+      if ( plane[0] * corners[c].x + plane[1] * corners[c].y + plane[2] * corners[c].z + plane[3] >= 0 ) break;
+    }
+    if ( c == 8 ) return false;
+  }
+  return true;
+}
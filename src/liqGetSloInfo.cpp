@@ -71,6 +71,7 @@
 #include <liquid.h>
 #include <liqGlobalHelpers.h>
 #include <liqGetSloInfo.h>
+#include <liqShaderInfo.h>
 
 #include <map>
 
@@ -210,6 +211,11 @@ float liqGetSloInfo::getArgFloatDefault( int num, int entry )
     return floats[ entry ];
 }
 
+bool liqGetSloInfo::hasArgDefault( int num )
+{
+    return argDefault[ num ] != NULL;
+}
+
 void liqGetSloInfo::resetIt()
 {
     numParam = 0;
@@ -222,163 +228,52 @@ void liqGetSloInfo::resetIt()
     for ( k = 0; k < argDefault.size(); k++ ) {
         lfree( argDefault[k] );
     }
+    argDefault.clear();
 }
 
 int liqGetSloInfo::setShader( MString shaderFileName )
 {
-  int rstatus = 0;
   resetIt();
 
   if ( !fileExists( shaderFileName ) ) {
     printf( "Error finding shader %s \n",shaderFileName.asChar() );
-    resetIt();
     return 0;
-  } else {
-    MStatus cmdStat;
-
-    MString cmd = "liquidSlInfoReset();";
-    cmdStat = MGlobal::executeCommand( cmd );
-    LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlInfoReset failed !" );
-
-    cmd = "liquidSlSetShader \"" + shaderFileName + "\";";
-    cmdStat = MGlobal::executeCommand( cmd );
-    LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> "+cmd+" failed !" );
-
-    // get the shader name
-    cmdStat = MGlobal::executeCommand( "liquidSlShaderName();", shaderName );
-    LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlShaderName failed !" );
-    //cout <<"setShader:  shaderName = "<<shaderName<<endl;
-
-    // get the shader type
-    cmdStat = MGlobal::executeCommand( "liquidSlShaderType();", shaderType );
-    LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlShaderType failed !" );
-
-    // get the number of params
-    cmdStat = MGlobal::executeCommand( "liquidSlNumParams();", numParam );
-    LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlnumParams failed !" );
-
-    // get the data from the arrays
-    MStringArray shaderParams, shaderDetails, shaderTypes, shaderDefaults;
-    MIntArray shaderArraySizes;
-    cmdStat = MGlobal::executeCommand( "liquidSlAllParamNames();", shaderParams );
-    LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlAllParamNames failed !" );
-    //cmdStat = MGlobal::executeCommand( "liquidSlAllParamDetails();", shaderDetails );
-    //LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlAllParamDetails failed !" );
-    //cmdStat = MGlobal::executeCommand( "liquidSlAllParamTypes();", shaderTypes );
-    //LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlAllParamTypes failed !" );
-    //cmdStat = MGlobal::executeCommand( "liquidSlAllParamArraySizes();", shaderArraySizes );
-    //LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlAllParamArraySizes failed !" );
-    //cmdStat = MGlobal::executeCommand( "liquidSlAllParamDefaultsRaw();", shaderDefaults );
-    //LIQCHECKSTATUS( cmdStat, "liqGetSloInfo::setShader -> liquidSlAllParamDefaultsRaw failed !" );
-    //
-    //
-    //for ( unsigned k = 0; k < numParam; k++ ) {
-    //
-    //  //cout <<"setShaderNode:     + shaderParams["<<k<<"] = "<<shaderParams[k]<<endl;
-    //  argName.push_back( shaderParams[k] );
-    //
-    //  SHADER_TYPE theParamType = shaderTypeMap[ shaderTypes[k] ];
-    //  //cout <<"setShaderNode:       - shaderTypes["<<k<<"] = "<<shaderTypes[k]<<" -> "<<theParamType<<endl;
-    //  argType.push_back( theParamType );
-    //
-    //  //cout <<"setShaderNode:       - shaderArraySizes["<<k<<"] = "<<shaderArraySizes[k]<<endl;
-    //  argArraySize.push_back( shaderArraySizes[k] );
-    //
-    //  SHADER_DETAIL theParamDetail = shaderDetailMap[ shaderDetails[k] ];
-    //  //cout <<"setShaderNode:       - shaderDetails["<<k<<"] = "<<shaderDetails[k]<<" -> "<<theParamDetail<<endl;
-    //  argDetail.push_back( theParamDetail );
-    //
-    //
-    //  switch ( shaderTypeMap[ shaderTypes[k] ] ) {
-    //
-    //    case SHADER_TYPE_STRING: {
-    //      char *strings = ( char * )lmalloc( sizeof( char ) * strlen( shaderDefaults[k].asChar() ) + 1 );
-    //      strcpy( strings, shaderDefaults[k].asChar() );
-    //      argDefault.push_back( ( void * )strings );
-    //      break;
-    //    }
-    //
-    //    case SHADER_TYPE_SCALAR: {
-    //      if ( shaderArraySizes[k] > 0 ) {
-    //          MStringArray tmp;
-    //          shaderDefaults[k].split( ':', tmp );
-    //          float *floats = ( float *)lmalloc( sizeof( float ) * shaderArraySizes[k] );
-    //          for (int kk = 0; kk < shaderArraySizes[k]; kk ++ ) {
-    //              floats[kk] = tmp[kk].asFloat();
-    //          }
-    //          argDefault.push_back( ( void * )floats );
-    //      } else {
-    //        float *floats = ( float *)lmalloc( sizeof( float ) * 1 );
-    //        floats[0] = shaderDefaults[k].asFloat();
-    //        argDefault.push_back( ( void * )floats );
-    //      }
-    //      break;
-    //    }
-    //
-    //    case SHADER_TYPE_COLOR:
-    //    case SHADER_TYPE_POINT:
-    //    case SHADER_TYPE_VECTOR:
-    //    case SHADER_TYPE_NORMAL: {
-    //      if( shaderArraySizes[k] > 0  ) {
-    //          float *floats = ( float *)lmalloc( sizeof( float ) * 3 * shaderArraySizes[k] );
-    //          MStringArray tmp;
-    //          shaderDefaults[k].split( ':', tmp );
-    //          for (int kk = 0; kk < tmp.length(); kk ++ ) {
-    //             floats[3 * kk] = tmp[3*kk].asFloat();
-    //             floats[3 * kk + 1] = tmp[3*kk+1].asFloat();
-    //             floats[3 * kk + 2] = tmp[3*kk+2].asFloat();
-    //          }
-    //          argDefault.push_back( ( void * )floats );
-    //      } else {
-    //          float *floats = ( float *)lmalloc( sizeof( float ) * 3 );
-    //          MStringArray tmp;
-    //          shaderDefaults[k].split( ':', tmp );
-    //          floats[0] = tmp[0].asFloat();
-    //          floats[1] = tmp[1].asFloat();
-    //          floats[2] = tmp[2].asFloat();
-    //          argDefault.push_back( ( void * )floats );
-    //      }
-    //      break;
-    //    }
-    //
-    //    //case SHADER_TYPE_MATRIX: {
-    //    //  printf("\"%s\" [%f %f %f %f\n",
-    //    //          arg->svd_spacename,
-    //    //          (double) (arg->svd_default.matrixval[0]),
-    //    //          (double) (arg->svd_default.matrixval[1]),
-    //    //          (double) (arg->svd_default.matrixval[2]),
-    //    //          (double) (arg->svd_default.matrixval[3]));
-    //    //  printf("\t\t\t%f %f %f %f\n",
-    //    //          (double) (arg->svd_default.matrixval[4]),
-    //    //          (double) (arg->svd_default.matrixval[5]),
-    //    //          (double) (arg->svd_default.matrixval[6]),
-    //    //          (double) (arg->svd_default.matrixval[7]));
-    //    //  printf("\t\t\t%f %f %f %f\n",
-    //    //          (double) (arg->svd_default.matrixval[8]),
-    //    //          (double) (arg->svd_default.matrixval[9]),
-    //    //          (double) (arg->svd_default.matrixval[10]),
-    //    //          (double) (arg->svd_default.matrixval[11]));
-    //    //  printf("\t\t\t%f %f %f %f]\n",
-    //    //          (double) (arg->svd_default.matrixval[12]),
-    //    //          (double) (arg->svd_default.matrixval[13]),
-    //    //          (double) (arg->svd_default.matrixval[14]),
-    //    //          (double) (arg->svd_default.matrixval[15]));
-    //    //  break;
-    //    //}
-    //
-    //    default: {
-    //      argDefault.push_back( NULL );
-    //      break;
-    //    }
-    //
-    //  } // switch
-    //} // param loop
-
-  } // file exists
+  }
 
-  rstatus = 1;
+  const liqShaderInfo *info = liqShaderInfo::get( shaderFileName );
+  if ( !info ) {
+    printf( "Error reading shader %s \n",shaderFileName.asChar() );
+    return 0;
+  }
 
-  return rstatus;
+  shaderName = info->name.c_str();
+  shaderType = info->type;
+  numParam   = info->params.size();
+  for ( unsigned k = 0; k < numParam; k++ ) {
+    const liqShaderInfo::param &p = info->params[k];
+    argName.push_back( MString( p.name.c_str() ) );
+    argType.push_back( p.type );
+    argDetail.push_back( p.detail );
+    argArraySize.push_back( p.arraySize );
+
+    if ( p.type == SHADER_TYPE_STRING ) {
+      const char *str = p.strings.size()? p.strings[0].c_str() : "";
+      char *strings = ( char * )lmalloc( sizeof( char ) * strlen( str ) + 1 );
+      strcpy( strings, str );
+      argDefault.push_back( ( void * )strings );
+    } else if ( p.floats.size() ) {
+      // sized for the whole parameter, whatever the shader compiler stored
+      unsigned size = ( p.arraySize ? p.arraySize : 1 ) * ( p.type == SHADER_TYPE_SCALAR ? 1 : 3 );
+      if ( p.type == SHADER_TYPE_MATRIX || size < p.floats.size() ) size = p.floats.size();
+      float *floats = ( float * )lmalloc( sizeof( float ) * size );
+      memset( floats, 0, sizeof( float ) * size );
+      memcpy( floats, &p.floats[0], sizeof( float ) * p.floats.size() );
+      argDefault.push_back( ( void * )floats );
+    } else {
+      argDefault.push_back( NULL );
+    }
+  }
+  return 1;
 }
 
 
@@ -602,6 +497,13 @@ MStatus liqGetSloInfo::doIt( const MArgList& args )
     int success = setShader( shaderFileName );
     if ( !success ) throw( "Error loading shader specified for liquidGetSloInfo!\n" );
     for ( i = 0; i < args.length() - 1; i++ ) {
+      if ( MString( "-info" ) == args.asString( i, &status ) )  {
+        // everything at once, for liquidSlSetShader
+        const liqShaderInfo *info = liqShaderInfo::get( shaderFileName );
+        MStringArray result;
+        if ( info ) info->melInfo( result );
+        setResult( result );
+      }
       if ( MString( "-name" ) == args.asString( i, &status ) )  {
         setResult( getName() );
       }
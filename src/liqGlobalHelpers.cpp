@@ -394,12 +394,32 @@ bool areObjectAndParentsTemplated( const MDagPath & path )
 }
 
 /* Build the correct token/array pairs from the scene data to correctly pass to Renderman. */
+#ifdef GENERIC_RIBLIB
+/* With ribLib the types go straight to the RIB writer through
+ * RiParameterTypes() and the tokens are the plain names, nothing has to be
+ * formatted and parsed back. The types have to outlive the Ri call that
+ * follows, they are kept here until the next parameter list. An empty list
+ * clears them so none are left over for a later call. */
+static std::vector<RtParameterType> liqParameterTypes;
+#endif
+
 void assignTokenArrays( unsigned int numTokens, liqTokenPointer tokenPointerArray[],  RtToken tokens[], RtPointer pointers[] )
 {
+#ifdef GENERIC_RIBLIB
+  liqParameterTypes.resize( numTokens );
+  for ( unsigned i = 0; i < numTokens; i++ ) {
+    tokenPointerArray[i].getRiParameterType( liqParameterTypes[i] );
+    tokens[i] = liqParameterTypes[i].token;
+    pointers[i] = tokenPointerArray[i].getRtPointer();
+  }
+  if ( numTokens ) RiParameterTypes( numTokens, &liqParameterTypes[0] );
+  else RiParameterTypes( 0, NULL );
+#else
   for ( unsigned i = 0; i < numTokens; i++ ) {
     tokens[i] = tokenPointerArray[i].getDetailedTokenName();
     pointers[i] = tokenPointerArray[i].getRtPointer();
   }
+#endif
 }
 
 /* Build the correct token/array pairs from the scene data to correctly pass
@@ -407,14 +427,8 @@ void assignTokenArrays( unsigned int numTokens, liqTokenPointer tokenPointerArra
  * instead of a static array */
 void assignTokenArraysV( std::vector<liqTokenPointer> *tokenPointerArray, RtToken tokens[], RtPointer pointers[] )
 {
-  unsigned i = 0;
-  std::vector<liqTokenPointer>::iterator iter = tokenPointerArray->begin();
-  while ( iter != tokenPointerArray->end() ) {
-    tokens[i] = iter->getDetailedTokenName();
-    pointers[i] = iter->getRtPointer();
-    ++iter;
-    i++;
-  }
+  if ( tokenPointerArray->size() ) assignTokenArrays( tokenPointerArray->size(), &( *tokenPointerArray )[0], tokens, pointers );
+  else assignTokenArrays( 0, NULL, tokens, pointers );
 }
 
 MObject findFacetShader( MObject mesh, int polygonIndex ){
@@ -803,6 +817,128 @@ liquidlong liquidHash(const char *str)
   return (liquidlong)hc;
 }
 
+MString liquidFileHash( const MString &fileName, bool skipRibComments )
+//
+//  Description:
+//      hash of the contents of a file, empty if it can't be read.
+//      RIB comments can be left out, they carry the time of export.
+//
+{
+  FILE *fp = fopen( fileName.asChar(), "rb" );
+  if ( !fp ) return MString( "" );
+  // two 32 bit FNV-1a lanes
+  unsigned long h1 = 2166136261UL, h2 = 84696351UL;
+  unsigned char buffer[ 65536 ];
+  bool lineStart = true, inComment = false;
+  size_t n;
+  while ( ( n = fread( buffer, 1, sizeof( buffer ), fp ) ) > 0 ) {
+    for ( size_t i = 0; i < n; i++ ) {
+      unsigned char c = buffer[i];
+      if ( skipRibComments ) {
+        if ( lineStart && c == '#' ) inComment = true;
+        lineStart = c == '\n';
+        if ( inComment ) {
+          if ( lineStart ) inComment = false;
+          continue;
+        }
+      }
+      h1 = ( ( h1 ^ c ) * 16777619UL ) & 0xffffffffUL;
+      h2 = ( ( h2 ^ c ) * 16777619UL ) & 0xffffffffUL;
+      h2 ^= h2 >> 13;
+    }
+  }
+  fclose( fp );
+  char str[32];
+  sprintf( str, "%08lx%08lx", h1, h2 );
+  return MString( str );
+}
+
+bool liquidCopyFile( const MString &from, const MString &to )
+//
+//  Description:
+//      copy a file, false if it couldn't be copied whole.
+//
+{
+  FILE *in = fopen( from.asChar(), "rb" );
+  if ( !in ) return false;
+  FILE *out = fopen( to.asChar(), "wb" );
+  if ( !out ) {
+    fclose( in );
+    return false;
+  }
+  char buffer[ 65536 ];
+  size_t n;
+  bool copied = true;
+  while ( copied && ( n = fread( buffer, 1, sizeof( buffer ), in ) ) > 0 ) copied = fwrite( buffer, 1, n, out ) == n;
+  copied = copied && !ferror( in );
+  fclose( in );
+  if ( fclose( out ) ) copied = false;
+  if ( !copied ) remove( to.asChar() );
+  return copied;
+}
+
+liqHash::liqHash()
+: h1( 2166136261UL ),
+  h2( 84696351UL )
+{
+}
+
+void liqHash::add( const void *data, unsigned long size )
+{
+  const unsigned char *c = ( const unsigned char * )data;
+  for ( unsigned long i = 0; i < size; i++ ) {
+    h1 = ( ( h1 ^ c[i] ) * 16777619UL ) & 0xffffffffUL;
+    h2 = ( ( h2 ^ c[i] ) * 16777619UL ) & 0xffffffffUL;
+    h2 ^= h2 >> 13;
+  }
+}
+
+void liqHash::add( const char *str )
+{
+  // with the terminator, so that "ab" "c" and "a" "bc" differ
+  if ( str ) add( str, strlen( str ) + 1 );
+  else add( "", 1 );
+}
+
+void liqHash::add( const MString &str )
+{
+  add( str.asChar() );
+}
+
+void liqHash::add( int value )
+{
+  add( &value, sizeof( value ) );
+}
+
+void liqHash::add( unsigned value )
+{
+  add( &value, sizeof( value ) );
+}
+
+void liqHash::add( float value )
+{
+  add( &value, sizeof( value ) );
+}
+
+void liqHash::add( double value )
+{
+  add( &value, sizeof( value ) );
+}
+
+void liqHash::add( const MMatrix &matrix )
+{
+  double values[4][4];
+  matrix.get( values );
+  add( values, sizeof( values ) );
+}
+
+MString liqHash::str() const
+{
+  char str[32];
+  sprintf( str, "%08lx%08lx", h1, h2 );
+  return MString( str );
+}
+
 #ifdef _WIN32
 char * basename( const char *filename ) {
 //
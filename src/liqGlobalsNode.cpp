@@ -134,6 +134,19 @@ MObject liqGlobalsNode::aBinaryOutput;
 MObject liqGlobalsNode::aCompressedOutput;
 MObject liqGlobalsNode::aRenderAllCurves;
 MObject liqGlobalsNode::aOutputMeshUVs;
+MObject liqGlobalsNode::aUseParticleCache;
+MObject liqGlobalsNode::aParticleCacheDirectory;
+MObject liqGlobalsNode::aPolygonLOD;
+MObject liqGlobalsNode::aPolygonLODArea;
+MObject liqGlobalsNode::aRibGenThreads;
+MObject liqGlobalsNode::aTextureProcesses;
+MObject liqGlobalsNode::aRibJobProcesses;
+MObject liqGlobalsNode::aCullCameraObjects;
+MObject liqGlobalsNode::aCullMargin;
+MObject liqGlobalsNode::aCullDistance;
+MObject liqGlobalsNode::aShareGeometry;
+MObject liqGlobalsNode::aIncrementalRibs;
+MObject liqGlobalsNode::aFrameChunkSize;
 MObject liqGlobalsNode::aIgnoreSurfaces;
 MObject liqGlobalsNode::aIgnoreDisplacements;
 MObject liqGlobalsNode::aIgnoreLights;
@@ -141,11 +154,14 @@ MObject liqGlobalsNode::aIgnoreVolumes;
 MObject liqGlobalsNode::aOutputShadersInShadows;
 MObject liqGlobalsNode::aOutputShadersInDeepShadows;
 MObject liqGlobalsNode::aOutputLightsInDeepShadows;
+MObject liqGlobalsNode::aCullShadowObjects;
 
 MObject liqGlobalsNode::aOutputShadowPass;
 MObject liqGlobalsNode::aOutputHeroPass;
 MObject liqGlobalsNode::aOutputComments;
 MObject liqGlobalsNode::aShaderDebug;
+MObject liqGlobalsNode::aOutputAllShaderParams;
+MObject liqGlobalsNode::aGroupByMaterial;
 MObject liqGlobalsNode::aShowProgress;
 MObject liqGlobalsNode::aDoAnimation;
 MObject liqGlobalsNode::aStartFrame;
@@ -324,6 +340,8 @@ MObject liqGlobalsNode::aBits_features_3;
 MObject liqGlobalsNode::aBits_features_4;
 MObject liqGlobalsNode::aBits_features_5;
 MObject liqGlobalsNode::aBits_features_6;
+MObject liqGlobalsNode::aBits_features_7;
+MObject liqGlobalsNode::aBits_features_8;
 
 MObject liqGlobalsNode::aBits_required;
 MObject liqGlobalsNode::aBits_required_0;
@@ -571,6 +589,19 @@ MStatus liqGlobalsNode::initialize()
           CREATE_BOOL( nAttr,  aCompressedOutput,           "compressedOutput",             "comp",   0     );
           CREATE_BOOL( nAttr,  aRenderAllCurves,            "renderAllCurves",              "rac",    0     );
           CREATE_BOOL( nAttr,  aOutputMeshUVs,              "outputMeshUVs",                "muv",    0     );
+          CREATE_BOOL( nAttr,  aUseParticleCache,           "useParticleCache",             "upc",    0     );
+        CREATE_STRING( tAttr,  aParticleCacheDirectory,     "particleCacheDirectory",       "pcd",    ""    );
+          CREATE_BOOL( nAttr,  aPolygonLOD,                 "polygonLOD",                   "plod",   0     );
+         CREATE_FLOAT( nAttr,  aPolygonLODArea,             "polygonLODArea",               "plda",   10000.0 );
+           CREATE_INT( nAttr,  aRibGenThreads,              "ribGenThreads",                "rgth",   1     );
+           CREATE_INT( nAttr,  aTextureProcesses,           "textureProcesses",             "txpr",   4     );
+           CREATE_INT( nAttr,  aRibJobProcesses,            "ribJobProcesses",              "rjpr",   1     );
+          CREATE_BOOL( nAttr,  aCullCameraObjects,          "cullCameraObjects",            "ccul",   0     );
+         CREATE_FLOAT( nAttr,  aCullMargin,                 "cullMargin",                   "cmrg",   0.1   );
+         CREATE_FLOAT( nAttr,  aCullDistance,               "cullDistance",                 "cdst",   0.0   );
+          CREATE_BOOL( nAttr,  aShareGeometry,              "shareGeometry",                "shgm",   0     );
+          CREATE_BOOL( nAttr,  aIncrementalRibs,            "incrementalRibs",              "irib",   0     );
+           CREATE_INT( nAttr,  aFrameChunkSize,             "frameChunkSize",               "fcsz",   1     );
           CREATE_BOOL( nAttr,  aIgnoreSurfaces,             "ignoreSurfaces",               "isrf",   0     );
           CREATE_BOOL( nAttr,  aIgnoreDisplacements,        "ignoreDisplacements",          "idsp",   0     );
           CREATE_BOOL( nAttr,  aIgnoreLights,               "ignoreLights",                 "ilgt",   0     );
@@ -578,11 +609,14 @@ MStatus liqGlobalsNode::initialize()
           CREATE_BOOL( nAttr,  aOutputShadersInShadows,     "outputShadersInShadows",       "osis",   0     );
           CREATE_BOOL( nAttr,  aOutputShadersInDeepShadows, "outputShadersInDeepShadows",   "osids",  0     );
           CREATE_BOOL( nAttr,  aOutputLightsInDeepShadows,  "outputLightsInDeepShadows",    "olids",  0     );
+          CREATE_BOOL( nAttr,  aCullShadowObjects,          "cullShadowObjects",            "cso",    1     );
 
           CREATE_BOOL( nAttr,  aOutputShadowPass,           "outputShadowPass",             "osp",    0     );
           CREATE_BOOL( nAttr,  aOutputHeroPass,             "outputHeroPass",               "ohp",    1     );
           CREATE_BOOL( nAttr,  aOutputComments,             "outputComments",               "oc",     0     );
           CREATE_BOOL( nAttr,  aShaderDebug,                "shaderDebug",                  "sdbg",   0     );
+          CREATE_BOOL( nAttr,  aOutputAllShaderParams,      "outputAllShaderParams",        "oasp",   0     );
+          CREATE_BOOL( nAttr,  aGroupByMaterial,            "groupByMaterial",              "gbm",    0     );
           CREATE_BOOL( nAttr,  aShowProgress,               "showProgress",                 "prog",   0     );
           CREATE_BOOL( nAttr,  aDoAnimation,                "doAnimation",                  "anim",   0     );
            CREATE_INT( nAttr,  aStartFrame,                 "startFrame",                   "sf",     1     );
@@ -801,6 +835,10 @@ MStatus liqGlobalsNode::initialize()
       CHECK_MSTATUS( cAttr.addChild( aBits_features_5 ) );
       CREATE_BOOL( nAttr, aBits_features_6, "DisplayChannels", "DisplayChannels", 0 );
       CHECK_MSTATUS( cAttr.addChild( aBits_features_6 ) );
+      CREATE_BOOL( nAttr, aBits_features_7, "PointSpheres", "PointSpheres", 0 );
+      CHECK_MSTATUS( cAttr.addChild( aBits_features_7 ) );
+      CREATE_BOOL( nAttr, aBits_features_8, "InlineArchives", "InlineArchives", 0 );
+      CHECK_MSTATUS( cAttr.addChild( aBits_features_8 ) );
 
   CREATE_COMP( cAttr, aBits_required, "bits_required", "breq" );
     CREATE_BOOL( nAttr, aBits_required_0, "Swap_UV", "Swap_UV", 0 );
@@ -46,74 +46,194 @@
 #include <maya/MString.h>
 #include <maya/MGlobal.h>
 
-#include <list>
+#include <map>
+#include <string>
+#include <vector>
 
 // Error Messages 
 MString errorGettingMemoryMessage = "Liquid -> Error Allocating Memory!\n";
 
 extern int debugMode;
 
-struct ALLOC_INFO {
-	long     address;
-	long     size;
-	char      file[64];
-	long     line;
+// Allocation profile. Live blocks are looked up by address, every block
+// points to the aggregate of the call site that made it and of the category
+// that was current then ( see lmemCategory ).
+struct allocSite {
+	const char *file;
+	long        line;
+	long        count;      // allocations made
+	long        bytes;      // bytes allocated
+	long        live;       // bytes not freed yet
+	long        peak;       // highest live
 };
 
-std::list<ALLOC_INFO> allocList;
+struct allocCategory {
+	long        live;
+	long        peak;       // highest live since the last report
+	long        count;      // allocations since the last report
+};
 
-void addTrack( long addr,  long asize,  const char *fname, long lnum)
-{
-	ALLOC_INFO info;
-	
-	info.address = addr;
-	strncpy(info.file, fname, 63);
-	info.line = lnum;
-	info.size = asize;
-	allocList.push_back( info );
+struct allocBlock {
+	long           addr;    // 0 for a free slot, -1 for a removed one
+	long           size;
+	allocSite     *site;
+	allocCategory *category;
 };
 
-void removeTrack( long addr )
+typedef std::map<std::pair<const char*, long>, allocSite> allocSiteMap;
+typedef std::map<std::string, allocCategory>             allocCategoryMap;
+
+static allocSiteMap      allocSites;
+static allocCategoryMap  allocCategories;
+static const char       *currentCategoryName = "other";
+static allocCategory    *currentCategory = NULL;
+static long              allocLive = 0;
+
+const char *lmemSetCategory( const char *name )
 {
-	std::list<ALLOC_INFO>::iterator i = allocList.begin();
-	while ( i != allocList.end() ) {
-		if( i->address == addr )
-		{
-			printf( "-> liquidMemory FREE: %ld FILE: %s LINE: %ld\n", i->address, i->file, i->line );
-			allocList.erase( i );
-			break;
-    }
-		++i;
+	const char *previous = currentCategoryName;
+	if ( name != currentCategoryName ) {
+		currentCategoryName = name;
+		currentCategory = NULL;
 	}
+	return previous;
 }
 
-void ldumpUnfreed()
+// The live blocks are in an open addressing table, as every tracked
+// allocation and free looks one up. The size is a power of two, kept at
+// most three quarters full counting the removed slots.
+static std::vector<allocBlock> allocBlocks;
+static unsigned long           allocBlocksUsed = 0;   // live and removed slots
+
+static unsigned long blockSlot( long addr )
+{
+	// the low bits are the same for every block because of the alignment
+	unsigned long h = ( unsigned long )addr >> 4;
+	h ^= h >> 15;
+	h *= 2654435761UL;
+	h ^= h >> 13;
+	return h & ( allocBlocks.size() - 1 );
+}
+
+static allocBlock *findBlock( long addr )
+{
+	if ( allocBlocks.empty() ) return NULL;
+	for ( unsigned long i = blockSlot( addr ); allocBlocks[ i ].addr != 0; i = ( i + 1 ) & ( allocBlocks.size() - 1 ) ) {
+		if ( allocBlocks[ i ].addr == addr ) return &allocBlocks[ i ];
+	}
+	return NULL;
+}
+
+static allocBlock &insertBlock( long addr );
+
+// rebuild the table without the removed slots, larger if need be
+static void rehashBlocks()
+{
+	unsigned long live = 0;
+	for ( unsigned long i = 0; i < allocBlocks.size(); i++ ) {
+		if ( allocBlocks[ i ].addr > 0 ) live++;
+	}
+	unsigned long size = 1024;
+	while ( size < live * 2 ) size *= 2;
+
+	std::vector<allocBlock> blocks( size );
+	blocks.swap( allocBlocks );
+	allocBlocksUsed = 0;
+	for ( unsigned long i = 0; i < blocks.size(); i++ ) {
+		if ( blocks[ i ].addr > 0 ) insertBlock( blocks[ i ].addr ) = blocks[ i ];
+	}
+}
+
+static allocBlock &insertBlock( long addr )
+{
+	if ( ( allocBlocksUsed + 1 ) * 4 > allocBlocks.size() * 3 ) rehashBlocks();
+	allocBlock *removed = NULL;
+	unsigned long i = blockSlot( addr );
+	for ( ; allocBlocks[ i ].addr != 0; i = ( i + 1 ) & ( allocBlocks.size() - 1 ) ) {
+		if ( allocBlocks[ i ].addr == addr ) return allocBlocks[ i ];
+		if ( allocBlocks[ i ].addr == -1 && removed == NULL ) removed = &allocBlocks[ i ];
+	}
+	if ( removed == NULL ) {
+		removed = &allocBlocks[ i ];
+		allocBlocksUsed++;
+	}
+	removed->addr = addr;
+	return *removed;
+}
+
+static void addTrack( long addr, long asize, const char *fname, long lnum )
+{
+	allocSite &site = allocSites[ std::make_pair( fname, lnum ) ];
+	if ( site.file == NULL ) {
+		site.file = fname;
+		site.line = lnum;
+	}
+	site.count++;
+	site.bytes += asize;
+	site.live += asize;
+	if ( site.live > site.peak ) site.peak = site.live;
+
+	if ( currentCategory == NULL ) currentCategory = &allocCategories[ currentCategoryName ];
+	currentCategory->count++;
+	currentCategory->live += asize;
+	if ( currentCategory->live > currentCategory->peak ) currentCategory->peak = currentCategory->live;
+
+	allocLive += asize;
+	allocBlock &block = insertBlock( addr );
+	block.size = asize;
+	block.site = &site;
+	block.category = currentCategory;
+}
+
+static void untrack( const allocBlock &block )
+{
+	block.site->live -= block.size;
+	block.category->live -= block.size;
+	allocLive -= block.size;
+}
+
+static void removeTrack( long addr )
 {
-    long totalSize = 0;
+	allocBlock *block = findBlock( addr );
+	if ( block != NULL ) {
+		untrack( *block );
+		block->addr = -1;
+	}
+}
 
+void ldumpUnfreed()
+{
     printf("-------------- Liquid - Current Memory Usage --------------\n");
 
-    std::list<ALLOC_INFO>::iterator i = allocList.begin();
-    while ( i != allocList.end() ) {
-		printf("%-50s:\t\tLINE %ld,\t\tADDRESS %ld\t%ld unfreed\n", i->file, i->line, i->address, i->size);
-		totalSize += i->size;
-		++i;
+    allocSiteMap::const_iterator i;
+    for ( i = allocSites.begin(); i != allocSites.end(); ++i ) {
+		if ( i->second.live == 0 ) continue;
+		printf("%-50s:\t\tLINE %ld,\t\t%ld unfreed\t( %ld allocations, %ld bytes, peak %ld )\n",
+		       i->second.file, i->second.line, i->second.live, i->second.count, i->second.bytes, i->second.peak );
     }
     printf("-----------------------------------------------------------\n");
-    printf("Total Unfreed: %ld bytes\n", totalSize);
+    printf("Total Unfreed: %ld bytes\n", allocLive);
 }
 
-int lmemUsage() 
+// peak memory of each category since the last report
+void lmemReport()
 {
-    long totalSize = 0;
-	
-    std::list<ALLOC_INFO>::iterator i = allocList.begin();
-    while ( i != allocList.end() ) {
-    	totalSize += i->size;
-    	++i;
+    if ( allocCategories.empty() ) return;
+    printf("-------------- Liquid - Peak Memory Usage -----------------\n");
+    allocCategoryMap::iterator i;
+    for ( i = allocCategories.begin(); i != allocCategories.end(); ++i ) {
+		if ( i->second.peak == 0 ) continue;
+		printf("%-20s:\tpeak %ld bytes\t%ld allocations\t%ld still live\n",
+		       i->first.c_str(), i->second.peak, i->second.count, i->second.live );
+		i->second.peak = i->second.live;
+		i->second.count = 0;
     }
+    printf("-----------------------------------------------------------\n");
+}
 
-    return totalSize;
+int lmemUsage() 
+{
+    return allocLive;
 }
 
 // wrapper for malloc that keeps track of allocated memory as well as
@@ -147,7 +267,140 @@ void *ldcalloc( size_t nelem, size_t elsize, const char *fileName, const long li
 // wrapper for free that keeps track of freed memory
 void ldfree( void *ptr )
 {
-	if ( debugMode ) removeTrack( (long)ptr );
+	if ( debugMode && ptr ) removeTrack( (long)ptr );
 	free( ptr );
 	ptr = NULL;
 }
+
+// Scan arena. Memory comes in chunks that are kept from one scan to the next,
+// allocations bigger than a quarter of a chunk get a chunk of their own which
+// is released by the reset.
+static const size_t arenaChunkSize = 1 << 20;
+static const size_t arenaAlign = 16;
+
+struct arenaChunk {
+	char   *base;
+	size_t  size;
+};
+
+static std::vector<arenaChunk>    arenaChunks;      // standard chunks, in use order
+static std::vector<arenaChunk>    arenaLargeChunks;
+static std::map<const char*, size_t> arenaRanges;   // every chunk, by address
+static unsigned arenaCurrent = 0;
+static size_t   arenaUsed = 0;                      // in the current chunk
+static int      arenaDepth = 0;
+
+void larenaBegin()
+{
+	arenaDepth++;
+}
+
+void larenaEnd()
+{
+	if ( arenaDepth > 0 ) arenaDepth--;
+}
+
+bool larenaOwns( const void *ptr )
+{
+	if ( ptr == NULL || arenaRanges.empty() ) return false;
+	const char *p = ( const char * )ptr;
+	std::map<const char*, size_t>::const_iterator it = arenaRanges.upper_bound( p );
+	if ( it == arenaRanges.begin() ) return false;
+	--it;
+	return p < it->first + it->second;
+}
+
+static arenaChunk arenaNewChunk( size_t size )
+{
+	arenaChunk chunk;
+	chunk.base = ( char * )malloc( size );
+	if ( chunk.base == NULL ) {
+		throw( errorGettingMemoryMessage );
+	}
+	chunk.size = size;
+	arenaRanges[ chunk.base ] = size;
+	return chunk;
+}
+
+void *larenaAlloc( size_t size )
+{
+	if ( size == 0 ) return NULL;
+	if ( arenaDepth == 0 ) {
+		void *ptr = malloc( size );
+		if ( ptr == NULL ) {
+			throw( errorGettingMemoryMessage );
+		}
+		return ptr;
+	}
+	size = ( size + arenaAlign - 1 ) & ~( arenaAlign - 1 );
+	if ( size > arenaChunkSize / 4 ) {
+		arenaLargeChunks.push_back( arenaNewChunk( size ) );
+		return arenaLargeChunks.back().base;
+	}
+	if ( arenaChunks.empty() ) {
+		arenaChunks.push_back( arenaNewChunk( arenaChunkSize ) );
+		arenaCurrent = 0;
+		arenaUsed = 0;
+	}
+	if ( arenaUsed + size > arenaChunks[ arenaCurrent ].size ) {
+		if ( ++arenaCurrent == arenaChunks.size() ) {
+			arenaChunks.push_back( arenaNewChunk( arenaChunkSize ) );
+		}
+		arenaUsed = 0;
+	}
+	void *ptr = arenaChunks[ arenaCurrent ].base + arenaUsed;
+	arenaUsed += size;
+	return ptr;
+}
+
+void larenaFree( void *ptr )
+{
+	if ( !larenaOwns( ptr ) ) free( ptr );
+}
+
+void larenaReset()
+{
+	// whatever is still tracked in the arena goes away with it
+	if ( debugMode ) {
+		for ( unsigned long i = 0; i < allocBlocks.size(); i++ ) {
+			if ( allocBlocks[ i ].addr > 0 && larenaOwns( ( void * )allocBlocks[ i ].addr ) ) {
+				untrack( allocBlocks[ i ] );
+				allocBlocks[ i ].addr = -1;
+			}
+		}
+		printf( "-> liquidMemory arena reset: %u chunks, %u large blocks\n",
+		        ( unsigned )arenaChunks.size(), ( unsigned )arenaLargeChunks.size() );
+	}
+	for ( unsigned i = 0; i < arenaLargeChunks.size(); i++ ) {
+		arenaRanges.erase( arenaLargeChunks[i].base );
+		free( arenaLargeChunks[i].base );
+	}
+	arenaLargeChunks.clear();
+	arenaCurrent = 0;
+	arenaUsed = 0;
+}
+
+// give the chunks kept for the next scan back to the system
+void larenaRelease()
+{
+	larenaReset();
+	for ( unsigned i = 0; i < arenaChunks.size(); i++ ) free( arenaChunks[i].base );
+	arenaChunks.clear();
+	arenaRanges.clear();
+}
+
+// arena versions of ldmalloc / ldfree
+void *ldamalloc( size_t size, const char *fileName, const long line )
+{
+	void *ptr = larenaAlloc( size );
+	if ( ptr != NULL && debugMode ) addTrack( (long)ptr, size, fileName, line );
+	return ptr;
+}
+
+void ldafree( void *ptr )
+{
+	if ( ptr == NULL ) return;
+	if ( debugMode ) removeTrack( (long)ptr );
+	larenaFree( ptr );
+}
+
@@ -0,0 +1,278 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+/* ______________________________________________________________________
+**
+** Liquid Mesh Level Of Detail Source
+**
+** Points are snapped to a regular grid over the mesh bounding box and
+** all the points in a cell are merged. Faces that collapse to less than
+** three corners are dropped. The grid resolution of each level is
+** searched for to get close to the wanted face count.
+** ______________________________________________________________________
+*/
+
+#include <stdio.h>
+#include <map>
+
+#include <liqMeshLOD.h>
+
+extern int debugMode;
+
+// fraction of the faces kept by each decimated level
+static const RtFloat  lodRatios[] = { 0.5, 0.1, 0.02 };
+static const unsigned lodNumRatios = sizeof( lodRatios ) / sizeof( lodRatios[0] );
+static const unsigned lodMaxResolution = 1024;
+static const unsigned lodMinFaces = 8;
+
+static std::multimap<unsigned long, liqMeshLOD*> lodCache;
+
+
+const liqMeshLOD *liqMeshLOD::get( unsigned numPoints, unsigned numFaces, const RtInt *nverts, const RtInt *verts, const RtFloat *P )
+{
+  unsigned numFaceVertices = 0;
+  unsigned long hash = 2166136261UL;
+  unsigned i;
+  for ( i = 0; i < numFaces; i++ ) {
+    numFaceVertices += nverts[i];
+    hash = ( hash ^ ( unsigned long )nverts[i] ) * 16777619UL;
+  }
+  for ( i = 0; i < numFaceVertices; i++ ) {
+    hash = ( hash ^ ( unsigned long )verts[i] ) * 16777619UL;
+  }
+  hash ^= numPoints;
+
+  std::multimap<unsigned long, liqMeshLOD*>::iterator it = lodCache.find( hash );
+  for ( ; it != lodCache.end() && it->first == hash; ++it ) {
+    liqMeshLOD *lod = it->second;
+    if ( lod->m_numPoints != numPoints || lod->m_numFaces != numFaces ||
+         lod->m_topology.size() != numFaces + numFaceVertices ) continue;
+    const RtInt *topo = &lod->m_topology[0];
+    bool same = true;
+    for ( i = 0; same && i < numFaces; i++ ) same = topo[i] == nverts[i];
+    for ( i = 0; same && i < numFaceVertices; i++ ) same = topo[numFaces + i] == verts[i];
+    if ( same ) return lod;
+  }
+
+  liqMeshLOD *lod = new liqMeshLOD( numPoints, numFaces, nverts, verts, P );
+  lod->m_hash = hash;
+  lodCache.insert( std::pair<const unsigned long, liqMeshLOD*>( hash, lod ) );
+  return lod;
+}
+
+void liqMeshLOD::clearCache()
+{
+  std::multimap<unsigned long, liqMeshLOD*>::iterator it;
+  for ( it = lodCache.begin(); it != lodCache.end(); ++it ) delete it->second;
+  lodCache.clear();
+}
+
+liqMeshLOD::liqMeshLOD( unsigned numPoints, unsigned numFaces, const RtInt *nverts, const RtInt *verts, const RtFloat *P )
+: m_numPoints( numPoints ),
+  m_numFaces( numFaces ),
+  m_P( P ),
+  m_size( 0 ),
+  m_hash( 0 )
+{
+  unsigned i, k;
+  unsigned numFaceVertices = 0;
+  for ( i = 0; i < numFaces; i++ ) numFaceVertices += nverts[i];
+  m_topology.reserve( numFaces + numFaceVertices );
+  m_topology.insert( m_topology.end(), nverts, nverts + numFaces );
+  m_topology.insert( m_topology.end(), verts, verts + numFaceVertices );
+
+  // the grid is cubic, sized on the largest side of the bounding box
+  RtFloat max[3];
+  for ( k = 0; k < 3; k++ ) m_min[k] = max[k] = numPoints ? P[k] : 0;
+  for ( i = 1; i < numPoints; i++ ) {
+    for ( k = 0; k < 3; k++ ) {
+      if ( P[ i * 3 + k ] < m_min[k] ) m_min[k] = P[ i * 3 + k ];
+      if ( P[ i * 3 + k ] > max[k] ) max[k] = P[ i * 3 + k ];
+    }
+  }
+  for ( k = 0; k < 3; k++ ) {
+    if ( max[k] - m_min[k] > m_size ) m_size = max[k] - m_min[k];
+  }
+
+  if ( m_size > 0 ) {
+    unsigned previousFaces = numFaces;
+    unsigned hi = lodMaxResolution;
+    for ( unsigned r = 0; r < lodNumRatios; r++ ) {
+      unsigned target = ( unsigned )( lodRatios[r] * numFaces );
+      if ( target < lodMinFaces ) break;
+
+      // smallest resolution that keeps at least the wanted number of faces
+      level lev;
+      unsigned lo = 1;
+      while ( lo < hi ) {
+        unsigned mid = ( lo + hi ) / 2;
+        if ( cluster( mid, lev ) < target ) lo = mid + 1;
+        else hi = mid;
+      }
+      unsigned faces = cluster( lo, lev );
+
+      // not worth a level if it doesn't remove a fair share of the faces
+      if ( faces < lodMinFaces || faces > previousFaces * 0.8 ) continue;
+
+      lev.ratio = ( RtFloat )faces / ( RtFloat )numFaces;
+      m_levels.push_back( lev );
+      previousFaces = faces;
+      if ( debugMode ) printf( "-> mesh lod %u : %u faces, %u points\n", ( unsigned )m_levels.size(), faces, lev.numPoints );
+    }
+  }
+  m_P = NULL;
+}
+
+unsigned liqMeshLOD::cluster( unsigned resolution, level &lev ) const
+{
+  RtFloat cellScale = resolution / m_size;
+  std::map<unsigned, RtInt> cells;
+  unsigned i, k;
+
+  lev.pointMap.resize( m_numPoints );
+  for ( i = 0; i < m_numPoints; i++ ) {
+    unsigned key = 0;
+    for ( k = 0; k < 3; k++ ) {
+      unsigned cell = ( unsigned )( ( m_P[ i * 3 + k ] - m_min[k] ) * cellScale );
+      if ( cell >= resolution ) cell = resolution - 1;
+      key = key * resolution + cell;
+    }
+    std::map<unsigned, RtInt>::iterator found = cells.find( key );
+    if ( found == cells.end() ) {
+      RtInt index = cells.size();
+      cells[key] = index;
+      lev.pointMap[i] = index;
+    } else {
+      lev.pointMap[i] = found->second;
+    }
+  }
+  lev.numPoints = cells.size();
+
+  lev.nverts.clear();
+  lev.verts.clear();
+  lev.faceSource.clear();
+  lev.faceVertexSource.clear();
+
+  const RtInt *nverts = &m_topology[0];
+  const RtInt *verts  = nverts + m_numFaces;
+  unsigned faceVertex = 0;
+  for ( unsigned f = 0; f < m_numFaces; f++ ) {
+    unsigned start = lev.verts.size();
+    unsigned count = nverts[f];
+    for ( unsigned c = 0; c < count; c++ ) {
+      RtInt p = lev.pointMap[ verts[ faceVertex + c ] ];
+      if ( lev.verts.size() > start && lev.verts.back() == p ) continue;
+      lev.verts.push_back( p );
+      lev.faceVertexSource.push_back( faceVertex + c );
+    }
+    while ( lev.verts.size() > start + 1 && lev.verts.back() == lev.verts[start] ) {
+      lev.verts.pop_back();
+      lev.faceVertexSource.pop_back();
+    }
+    if ( lev.verts.size() - start < 3 ) {
+      lev.verts.resize( start );
+      lev.faceVertexSource.resize( start );
+    } else {
+      lev.nverts.push_back( lev.verts.size() - start );
+      lev.faceSource.push_back( f );
+    }
+    faceVertex += count;
+  }
+  return lev.nverts.size();
+}
+
+unsigned liqMeshLOD::numLevels() const
+{
+  return m_levels.size();
+}
+
+const liqMeshLOD::level &liqMeshLOD::getLevel( unsigned l ) const
+{
+  return m_levels[l];
+}
+
+void liqMeshLOD::detailRange( unsigned l, RtFloat fullDetailArea, RtFloat range[4] ) const
+{
+  // level l is used down to fullDetailArea times its own face ratio, the
+  // next level takes over from there. Neighbours cross-fade over 20%.
+  unsigned last = m_levels.size();
+  RtFloat lower = ( l == last )? 0 : fullDetailArea * ( ( l == 0 )? 1 : m_levels[ l - 1 ].ratio );
+  RtFloat upper = ( l == 0 )? 0 : fullDetailArea * ( ( l == 1 )? 1 : m_levels[ l - 2 ].ratio );
+
+  range[0] = lower * 0.9;                               // minvisible
+  range[1] = lower * 1.1;                               // lowertransition
+  range[2] = ( l == 0 )? RI_INFINITY : upper * 0.9;     // uppertransition
+  range[3] = ( l == 0 )? RI_INFINITY : upper * 1.1;     // maxvisible
+}
+
+void liqMeshLOD::remap( unsigned l, liqTokenPointer &src, liqTokenPointer &dst ) const
+{
+  const level &lev = m_levels[l];
+  DetailType detail = src.getDetailType();
+  unsigned items    = src.getArraySize();
+  unsigned uSize    = src.getUArraySize();
+  unsigned itemSize = src.getElementSize() * ( uSize ? uSize : 1 );
+  const RtFloat *values = src.getTokenFloatArray();
+
+  if ( src.getParameterType() == rString || itemSize == 0 || values == NULL ) {
+    dst = src;
+    return;
+  }
+
+  std::vector<RtFloat> resampled;
+  unsigned i, k;
+  if ( ( detail == rVertex || detail == rVarying ) && items == m_numPoints ) {
+    resampled.assign( lev.numPoints * itemSize, 0 );
+    std::vector<unsigned> counts( lev.numPoints, 0 );
+    for ( i = 0; i < m_numPoints; i++ ) {
+      RtFloat *to = &resampled[ lev.pointMap[i] * itemSize ];
+      for ( k = 0; k < itemSize; k++ ) to[k] += values[ i * itemSize + k ];
+      counts[ lev.pointMap[i] ]++;
+    }
+    for ( i = 0; i < lev.numPoints; i++ ) {
+      if ( counts[i] > 1 ) {
+        for ( k = 0; k < itemSize; k++ ) resampled[ i * itemSize + k ] /= counts[i];
+      }
+    }
+  } else if ( detail == rUniform && items == m_numFaces ) {
+    resampled.resize( lev.faceSource.size() * itemSize );
+    for ( i = 0; i < lev.faceSource.size(); i++ ) {
+      for ( k = 0; k < itemSize; k++ ) resampled[ i * itemSize + k ] = values[ lev.faceSource[i] * itemSize + k ];
+    }
+  } else if ( detail == rFaceVarying || detail == rFaceVertex ) {
+    resampled.resize( lev.faceVertexSource.size() * itemSize );
+    for ( i = 0; i < lev.faceVertexSource.size(); i++ ) {
+      for ( k = 0; k < itemSize; k++ ) resampled[ i * itemSize + k ] = values[ lev.faceVertexSource[i] * itemSize + k ];
+    }
+  } else {
+    dst = src;
+    return;
+  }
+
+  dst.set( src.getTokenName(), src.getParameterType(), src.isNurbs(), resampled.size() / itemSize, uSize );
+  dst.setDetailType( detail );
+  if ( resampled.size() ) dst.setTokenFloats( &resampled[0] );
+}
@@ -0,0 +1,488 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+/* ______________________________________________________________________
+**
+** Liquid Particle Disk Cache Source
+**
+** Reads Maya's .pdc particle disk cache files directly so particles can
+** be exported without running the dynamics up to the current frame.
+**
+** A pdc file is a 28 byte header ("PDC ", version, byte order, two
+** reserved ints, particle count, attribute count) followed by the
+** attributes: name length, name, type and the values for that type.
+** ______________________________________________________________________
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <algorithm>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <dirent.h>
+#endif
+
+#include <maya/MVector.h>
+
+#include <liqParticleCache.h>
+
+extern int debugMode;
+
+
+static bool hostIsBigEndian()
+{
+  const int one = 1;
+  return *( ( const char * ) &one ) == 0;
+}
+
+
+liqPdcFile::liqPdcFile()
+: m_map( NULL ),
+  m_mapSize( 0 ),
+#ifdef _WIN32
+  m_fileHandle( NULL ),
+  m_mapHandle( NULL ),
+#endif
+  m_bigEndian( true ),
+  m_numParticles( 0 )
+{
+}
+
+liqPdcFile::~liqPdcFile()
+{
+  close();
+}
+
+bool liqPdcFile::open( const char *fileName )
+{
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFile( fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+  if ( file == INVALID_HANDLE_VALUE ) return false;
+  m_fileHandle = file;
+  m_mapSize = GetFileSize( file, NULL );
+  HANDLE mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+  if ( !mapping ) {
+    close();
+    return false;
+  }
+  m_mapHandle = mapping;
+  m_map = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+  if ( !m_map ) {
+    close();
+    return false;
+  }
+#else
+  int fd = ::open( fileName, O_RDONLY );
+  if ( fd < 0 ) return false;
+  struct stat sbuf;
+  if ( fstat( fd, &sbuf ) || sbuf.st_size == 0 ) {
+    ::close( fd );
+    return false;
+  }
+  m_mapSize = sbuf.st_size;
+  void *map = mmap( NULL, m_mapSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+  ::close( fd );
+  if ( map == MAP_FAILED ) {
+    m_mapSize = 0;
+    return false;
+  }
+  m_map = map;
+#endif
+
+  // header
+  const unsigned char *p   = ( const unsigned char * ) m_map;
+  const unsigned char *end = p + m_mapSize;
+
+  if ( m_mapSize < 28 || memcmp( p, "PDC ", 4 ) ) {
+    fprintf( stderr, "Liquid : %s is not a particle disk cache\n", fileName );
+    close();
+    return false;
+  }
+  m_bigEndian = true;
+  if ( readInt( p + 8 ) != 1 ) {
+    m_bigEndian = false;
+    if ( readInt( p + 8 ) != 1 ) {
+      fprintf( stderr, "Liquid : unknown byte order in particle disk cache %s\n", fileName );
+      close();
+      return false;
+    }
+  }
+  m_numParticles = readInt( p + 20 );
+  int numAttributes = readInt( p + 24 );
+  p += 28;
+
+  // attribute table, the values stay in the mapping
+  for ( int i = 0; i < numAttributes; i++ ) {
+    if ( p + 4 > end ) break;
+    int nameLength = readInt( p );
+    p += 4;
+    if ( nameLength <= 0 || p + nameLength + 4 > end ) break;
+
+    attribute attr;
+    attr.name.assign( ( const char * ) p, nameLength );
+    p += nameLength;
+    attr.type = ( AttrType ) readInt( p );
+    p += 4;
+    attr.data = p;
+
+    unsigned long size;
+    switch ( attr.type ) {
+      case pdcInt:          size = 4; break;
+      case pdcIntArray:     size = 4 * m_numParticles; break;
+      case pdcDouble:       size = 8; break;
+      case pdcDoubleArray:  size = 8 * m_numParticles; break;
+      case pdcVector:       size = 24; break;
+      case pdcVectorArray:  size = 24 * m_numParticles; break;
+      default:              size = end - p + 1; break;
+    }
+    if ( p + size > end ) break;
+    p += size;
+
+    m_attributes.push_back( attr );
+  }
+
+  if ( m_attributes.size() != ( unsigned ) numAttributes ) {
+    fprintf( stderr, "Liquid : particle disk cache %s is truncated or corrupt\n", fileName );
+    close();
+    return false;
+  }
+
+  if ( debugMode ) printf( "-> mapped particle cache %s ( %u particles, %d attributes )\n", fileName, m_numParticles, numAttributes );
+  return true;
+}
+
+void liqPdcFile::close()
+{
+#ifdef _WIN32
+  if ( m_map )        UnmapViewOfFile( m_map );
+  if ( m_mapHandle )  CloseHandle( ( HANDLE ) m_mapHandle );
+  if ( m_fileHandle ) CloseHandle( ( HANDLE ) m_fileHandle );
+  m_mapHandle  = NULL;
+  m_fileHandle = NULL;
+#else
+  if ( m_map ) munmap( m_map, m_mapSize );
+#endif
+  m_map = NULL;
+  m_mapSize = 0;
+  m_numParticles = 0;
+  m_attributes.clear();
+}
+
+bool liqPdcFile::isOpen() const
+{
+  return m_map != NULL;
+}
+
+unsigned liqPdcFile::numParticles() const
+{
+  return m_numParticles;
+}
+
+int liqPdcFile::findAttribute( const char *name ) const
+{
+  for ( unsigned i = 0; i < m_attributes.size(); i++ ) {
+    if ( m_attributes[i].name == name ) return i;
+  }
+  return -1;
+}
+
+liqPdcFile::AttrType liqPdcFile::attributeType( int attr ) const
+{
+  return m_attributes[attr].type;
+}
+
+double liqPdcFile::getDouble( int attr, unsigned particle ) const
+{
+  const attribute &a = m_attributes[attr];
+  switch ( a.type ) {
+    case pdcInt:          return readInt( a.data );
+    case pdcIntArray:     return readInt( a.data + 4 * particle );
+    case pdcDouble:       return readDouble( a.data );
+    case pdcDoubleArray:  return readDouble( a.data + 8 * particle );
+    case pdcVector:       return readDouble( a.data );
+    case pdcVectorArray:  return readDouble( a.data + 24 * particle );
+  }
+  return 0.0;
+}
+
+void liqPdcFile::getVector( int attr, unsigned particle, double vec[3] ) const
+{
+  const attribute &a = m_attributes[attr];
+  const unsigned char *p;
+  switch ( a.type ) {
+    case pdcVector:       p = a.data; break;
+    case pdcVectorArray:  p = a.data + 24 * particle; break;
+    default:
+      vec[0] = vec[1] = vec[2] = getDouble( attr, particle );
+      return;
+  }
+  vec[0] = readDouble( p );
+  vec[1] = readDouble( p + 8 );
+  vec[2] = readDouble( p + 16 );
+}
+
+int liqPdcFile::readInt( const unsigned char *p ) const
+{
+  unsigned char b[4];
+  if ( m_bigEndian == hostIsBigEndian() ) {
+    memcpy( b, p, 4 );
+  } else {
+    b[0] = p[3]; b[1] = p[2]; b[2] = p[1]; b[3] = p[0];
+  }
+  int i;
+  memcpy( &i, b, 4 );
+  return i;
+}
+
+double liqPdcFile::readDouble( const unsigned char *p ) const
+{
+  unsigned char b[8];
+  if ( m_bigEndian == hostIsBigEndian() ) {
+    memcpy( b, p, 8 );
+  } else {
+    for ( unsigned i = 0; i < 8; i++ ) b[i] = p[7 - i];
+  }
+  double d;
+  memcpy( &d, b, 8 );
+  return d;
+}
+
+
+liqParticleCache::liqParticleCache()
+: m_interpolate( false ),
+  m_alpha( 0.0 ),
+  m_deltaTime( 0.0 )
+{
+}
+
+liqParticleCache::~liqParticleCache()
+{
+}
+
+void liqParticleCache::clear()
+{
+  m_file[0].close();
+  m_file[1].close();
+  m_interpolate = false;
+  m_alpha = 0.0;
+  m_deltaTime = 0.0;
+  m_remap.clear();
+}
+
+MString liqParticleCache::fileName( const MString &cacheDir, const MString &particleName, long ticks )
+{
+  // Maya flattens namespaces in cache file names
+  std::string name( particleName.asChar() );
+  for ( unsigned i = 0; i < name.length(); i++ ) {
+    if ( name[i] == ':' || name[i] == '|' ) name[i] = '_';
+  }
+  char tickStr[32];
+  sprintf( tickStr, ".%ld.pdc", ticks );
+
+  MString file( cacheDir );
+  if ( file.length() && file.asChar()[ file.length() - 1 ] != '/' ) file += "/";
+  file += name.c_str();
+  file += tickStr;
+  return file;
+}
+
+void liqParticleCache::sampleTicks( const MString &cacheDir, const MString &particleName, std::vector<long> &ticks )
+{
+  ticks.clear();
+
+  // the files are <dir>/<name>.<ticks>.pdc
+  std::string path( fileName( cacheDir, particleName, 0 ).asChar() );
+  path.erase( path.length() - 5 );
+  std::string::size_type slash = path.rfind( '/' );
+  std::string dir    = path.substr( 0, slash + 1 );
+  std::string prefix = path.substr( slash + 1 );
+
+  std::vector<std::string> names;
+#ifdef _WIN32
+  WIN32_FIND_DATA found;
+  HANDLE find = FindFirstFile( ( path + "*.pdc" ).c_str(), &found );
+  if ( find != INVALID_HANDLE_VALUE ) {
+    do names.push_back( found.cFileName ); while ( FindNextFile( find, &found ) );
+    FindClose( find );
+  }
+#else
+  DIR *d = opendir( dir.length() ? dir.c_str() : "." );
+  if ( d ) {
+    struct dirent *entry;
+    while ( ( entry = readdir( d ) ) ) names.push_back( entry->d_name );
+    closedir( d );
+  }
+#endif
+
+  for ( unsigned i = 0; i < names.size(); i++ ) {
+    const std::string &name = names[i];
+    if ( name.length() <= prefix.length() + 4 || name.compare( 0, prefix.length(), prefix ) ||
+         name.compare( name.length() - 4, 4, ".pdc" ) ) continue;
+    std::string tickStr = name.substr( prefix.length(), name.length() - prefix.length() - 4 );
+    char *end;
+    long t = strtol( tickStr.c_str(), &end, 10 );
+    if ( tickStr.length() && *end == '\0' ) ticks.push_back( t );
+  }
+  std::sort( ticks.begin(), ticks.end() );
+}
+
+bool liqParticleCache::load( const MString &cacheDir, const MString &particleName, const MTime &time )
+{
+  clear();
+
+  // the cache is written in ticks of 1/6000th of a second
+  double seconds = time.as( MTime::kSeconds );
+  long ticks = ( long ) floor( seconds * 6000.0 + 0.5 );
+
+  if ( m_file[0].open( fileName( cacheDir, particleName, ticks ).asChar() ) ) return true;
+
+  // no sample at this exact time : use the cached samples on either side,
+  // whatever step the cache was written with
+  std::vector<long> samples;
+  sampleTicks( cacheDir, particleName, samples );
+  std::vector<long>::const_iterator after = std::upper_bound( samples.begin(), samples.end(), ticks );
+  if ( after == samples.begin() ) return false;
+  long ticks0 = *( after - 1 );
+
+  if ( !m_file[0].open( fileName( cacheDir, particleName, ticks0 ).asChar() ) ) return false;
+  m_deltaTime = ( ticks - ticks0 ) / 6000.0;
+
+  if ( after == samples.end() ) return true;
+  long ticks1 = *after;
+  if ( !m_file[1].open( fileName( cacheDir, particleName, ticks1 ).asChar() ) ) return true;
+  m_alpha = ( double )( ticks - ticks0 ) / ( double )( ticks1 - ticks0 );
+
+  // match the particles of both samples by id
+  int id0 = findAttribute( m_file[0], "id" );
+  int id1 = findAttribute( m_file[1], "id" );
+  unsigned num0 = m_file[0].numParticles();
+  unsigned num1 = m_file[1].numParticles();
+  m_remap.resize( num0 );
+
+  if ( id0 != -1 && id1 != -1 ) {
+    std::map<int, int> ids;
+    unsigned i;
+    for ( i = 0; i < num1; i++ ) {
+      ids[ ( int ) m_file[1].getDouble( id1, i ) ] = i;
+    }
+    for ( i = 0; i < num0; i++ ) {
+      std::map<int, int>::const_iterator found = ids.find( ( int ) m_file[0].getDouble( id0, i ) );
+      m_remap[i] = ( found != ids.end() )? found->second : -1;
+    }
+  } else {
+    for ( unsigned i = 0; i < num0; i++ ) {
+      m_remap[i] = ( i < num1 )? i : -1;
+    }
+  }
+  m_interpolate = true;
+  return true;
+}
+
+unsigned liqParticleCache::numParticles() const
+{
+  return m_file[0].numParticles();
+}
+
+int liqParticleCache::findAttribute( const liqPdcFile &file, const MString &attr ) const
+{
+  int index = file.findAttribute( attr.asChar() );
+  // "id" is the short name Maya uses on the node, the cache has the long one
+  if ( index == -1 && attr == "id" ) index = file.findAttribute( "particleId" );
+  return index;
+}
+
+bool liqParticleCache::getDoubleArray( const MString &attr, MDoubleArray &array ) const
+{
+  if ( !m_file[0].isOpen() ) return false;
+  int attr0 = findAttribute( m_file[0], attr );
+  if ( attr0 == -1 ) return false;
+  liqPdcFile::AttrType type = m_file[0].attributeType( attr0 );
+  if ( type == liqPdcFile::pdcVector || type == liqPdcFile::pdcVectorArray ) return false;
+
+  // ids and other integer data are never blended
+  int attr1 = -1;
+  if ( m_interpolate && attr != "id" && type != liqPdcFile::pdcInt && type != liqPdcFile::pdcIntArray ) {
+    attr1 = findAttribute( m_file[1], attr );
+  }
+
+  unsigned num = m_file[0].numParticles();
+  array.setLength( num );
+  for ( unsigned i = 0; i < num; i++ ) {
+    double value = m_file[0].getDouble( attr0, i );
+    if ( attr1 != -1 && m_remap[i] != -1 ) {
+      value += ( m_file[1].getDouble( attr1, m_remap[i] ) - value ) * m_alpha;
+    }
+    array[i] = value;
+  }
+  return true;
+}
+
+bool liqParticleCache::getVectorArray( const MString &attr, MVectorArray &array ) const
+{
+  if ( !m_file[0].isOpen() ) return false;
+  int attr0 = findAttribute( m_file[0], attr );
+  if ( attr0 == -1 ) return false;
+  liqPdcFile::AttrType type = m_file[0].attributeType( attr0 );
+  if ( type != liqPdcFile::pdcVector && type != liqPdcFile::pdcVectorArray ) return false;
+
+  int attr1 = m_interpolate ? findAttribute( m_file[1], attr ) : -1;
+
+  // positions without a second sample move along their velocity
+  int velocity = -1;
+  if ( attr == "position" && m_deltaTime > 0.0 ) velocity = findAttribute( m_file[0], "velocity" );
+
+  unsigned num = m_file[0].numParticles();
+  array.setLength( num );
+  double v[3], w[3];
+  for ( unsigned i = 0; i < num; i++ ) {
+    m_file[0].getVector( attr0, i, v );
+    if ( attr1 != -1 && m_remap[i] != -1 ) {
+      m_file[1].getVector( attr1, m_remap[i], w );
+      v[0] += ( w[0] - v[0] ) * m_alpha;
+      v[1] += ( w[1] - v[1] ) * m_alpha;
+      v[2] += ( w[2] - v[2] ) * m_alpha;
+    } else if ( velocity != -1 ) {
+      m_file[0].getVector( velocity, i, w );
+      v[0] += w[0] * m_deltaTime;
+      v[1] += w[1] * m_deltaTime;
+      v[2] += w[2] * m_deltaTime;
+    }
+    array.set( MVector( v[0], v[1], v[2] ), i );
+  }
+  return true;
+}
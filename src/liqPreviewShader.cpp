@@ -509,10 +509,11 @@ int liquidOutputPreviewShader( const char *fileName, liqPreviewShoptions *option
 
   MFnDependencyNode assignedShader( shaderObj );
 
-  RtToken *tokenArray = (RtToken *)alloca( sizeof(RtToken) * currentShader.numTPV );
-  RtPointer *pointerArray = (RtPointer *)alloca( sizeof(RtPointer) * currentShader.numTPV );
+  unsigned numTokens = currentShader.tokenPointerArray.size();
+  RtToken *tokenArray = (RtToken *)alloca( sizeof(RtToken) * numTokens );
+  RtPointer *pointerArray = (RtPointer *)alloca( sizeof(RtPointer) * numTokens );
 
-  assignTokenArrays( currentShader.numTPV, currentShader.tokenPointerArray, tokenArray, pointerArray );
+  assignTokenArraysV( &currentShader.tokenPointerArray, tokenArray, pointerArray );
 
   float displacementBounds = 0.0;
   MPlug tmpPlug;
@@ -550,12 +551,12 @@ int liquidOutputPreviewShader( const char *fileName, liqPreviewShoptions *option
     if ( options->fullShaderPath )
       RiSurface( shaderFileName, RI_NULL );
     else
-      RiSurfaceV( shaderFileName, currentShader.numTPV, tokenArray, pointerArray );
+      RiSurfaceV( shaderFileName, numTokens, tokenArray, pointerArray );
   } else if ( currentShader.shader_type == SHADER_TYPE_DISPLACEMENT ) {
     if ( options->fullShaderPath )
       RiDisplacement( shaderFileName, RI_NULL );
     else
-      RiDisplacementV( shaderFileName, currentShader.numTPV, tokenArray, pointerArray );
+      RiDisplacementV( shaderFileName, numTokens, tokenArray, pointerArray );
   }
 
   RiTransformEnd();
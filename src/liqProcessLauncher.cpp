@@ -21,6 +21,34 @@
 #include <maya/MString.h>
 
 
+/* ______________________________________________________________________
+**
+** Dependencies of the parallel liqProcessLauncher::execute()
+** ______________________________________________________________________
+*/
+
+enum commandState { commandPending, commandRunning, commandDone };
+
+// 1 if command c can run, 0 if it waits on others, -1 if it is cancelled
+static int commandReadiness( unsigned c, const std::vector< std::vector<unsigned> > &dependencies, const std::vector<int> &state, const std::vector<bool> &succeeded )
+{
+  if ( c >= dependencies.size() ) return 1;
+  int ready = 1;
+  for ( unsigned i = 0; i < dependencies[c].size(); i++ ) {
+    unsigned d = dependencies[c][i];
+    if ( d >= state.size() ) continue;
+    if ( state[d] != commandDone ) ready = 0;
+    else if ( !succeeded[d] ) return -1;
+  }
+  return ready;
+}
+
+void liqProcessLauncher::execute( const std::vector<MString> &commands, const MString &path, unsigned processes, std::vector<bool> &succeeded )
+{
+  execute( commands, std::vector< std::vector<unsigned> >(), path, processes, succeeded );
+}
+
+
 /* ______________________________________________________________________
 **
 ** Linux implementation of liqProcessLauncher::execute()
@@ -176,3 +204,197 @@ bool liqProcessLauncher::execute( const MString &command, const MString &argumen
   return ( returnCode != -1 );
 }
 #endif // OSX
+
+
+/* ______________________________________________________________________
+**
+** Unix implementation of the parallel liqProcessLauncher::execute()
+** ______________________________________________________________________
+*/
+#if !defined(_WIN32)
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+void liqProcessLauncher::execute( const std::vector<MString> &commands, const std::vector< std::vector<unsigned> > &dependencies, const MString &path, unsigned processes, std::vector<bool> &succeeded )
+{
+  chdir( path.asChar() );
+  succeeded.assign( commands.size(), false );
+  if ( processes < 1 ) processes = 1;
+
+  std::vector<int>      state( commands.size(), commandPending );
+  std::vector<pid_t>    running;
+  std::vector<unsigned> runningCommand;
+  unsigned left = commands.size();
+  while ( left ) {
+    bool started = false;
+    for ( unsigned c = 0; c < commands.size(); c++ ) {
+      if ( state[c] != commandPending ) continue;
+      int ready = commandReadiness( c, dependencies, state, succeeded );
+      if ( ready < 0 ) {
+        state[c] = commandDone;
+        left--;
+        started = true;
+      } else if ( ready > 0 && running.size() < processes ) {
+        const char *cmd = commands[c].asChar();
+        pid_t pid = fork();
+        if ( pid == 0 ) {
+          execl( "/bin/sh", "sh", "-c", cmd, ( char * )NULL );
+          _exit( 127 );
+        }
+        if ( pid > 0 ) {
+          running.push_back( pid );
+          runningCommand.push_back( c );
+          state[c] = commandRunning;
+        } else {
+          state[c] = commandDone;
+          left--;
+        }
+        started = true;
+      }
+    }
+    // what is left waits on itself
+    if ( !running.size() && !started ) break;
+
+    // only our own children are waited for, Maya may have others
+    bool reaped = false;
+    for ( unsigned i = 0; i < running.size(); ) {
+      int status;
+      if ( waitpid( running[i], &status, WNOHANG ) == running[i] ) {
+        succeeded[ runningCommand[i] ] = WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+        state[ runningCommand[i] ] = commandDone;
+        left--;
+        running.erase( running.begin() + i );
+        runningCommand.erase( runningCommand.begin() + i );
+        reaped = true;
+      } else {
+        i++;
+      }
+    }
+    if ( !reaped && running.size() ) usleep( 10000 );
+  }
+}
+
+unsigned liqProcessLauncher::forkWorkers( unsigned count, std::vector<int> &workers )
+{
+  workers.clear();
+  // pending output would be written again by every worker
+  fflush( NULL );
+  for ( unsigned w = 1; w < count; w++ ) {
+    pid_t pid = fork();
+    if ( pid == 0 ) {
+      workers.clear();
+      return w;
+    }
+    if ( pid < 0 ) break;
+    workers.push_back( pid );
+  }
+  return 0;
+}
+
+bool liqProcessLauncher::waitWorkers( const std::vector<int> &workers )
+{
+  bool succeeded = true;
+  for ( unsigned i = 0; i < workers.size(); i++ ) {
+    int status;
+    if ( waitpid( workers[i], &status, 0 ) != workers[i] || !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ) {
+      succeeded = false;
+    }
+  }
+  return succeeded;
+}
+
+void liqProcessLauncher::killWorkers( const std::vector<int> &workers )
+{
+  for ( unsigned i = 0; i < workers.size(); i++ ) kill( workers[i], SIGTERM );
+  for ( unsigned i = 0; i < workers.size(); i++ ) {
+    int status;
+    waitpid( workers[i], &status, 0 );
+  }
+}
+#endif // !_WIN32
+
+
+/* ______________________________________________________________________
+**
+** Win32 implementation of the parallel liqProcessLauncher::execute()
+** ______________________________________________________________________
+*/
+#if defined(_WIN32)
+
+void liqProcessLauncher::execute( const std::vector<MString> &commands, const std::vector< std::vector<unsigned> > &dependencies, const MString &path, unsigned processes, std::vector<bool> &succeeded )
+{
+  succeeded.assign( commands.size(), false );
+  if ( processes < 1 ) processes = 1;
+  if ( processes > MAXIMUM_WAIT_OBJECTS ) processes = MAXIMUM_WAIT_OBJECTS;
+
+  std::vector<int>      state( commands.size(), commandPending );
+  std::vector<HANDLE>   running;
+  std::vector<unsigned> runningCommand;
+  unsigned left = commands.size();
+  while ( left ) {
+    bool started = false;
+    for ( unsigned c = 0; c < commands.size(); c++ ) {
+      if ( state[c] != commandPending ) continue;
+      int ready = commandReadiness( c, dependencies, state, succeeded );
+      if ( ready < 0 ) {
+        state[c] = commandDone;
+        left--;
+        started = true;
+      } else if ( ready > 0 && running.size() < processes ) {
+        PROCESS_INFORMATION pinfo;
+        STARTUPINFO sinfo;
+        ZeroMemory( &pinfo, sizeof( PROCESS_INFORMATION ) );
+        ZeroMemory( &sinfo, sizeof( STARTUPINFO ) );
+        sinfo.cb = sizeof( STARTUPINFO );
+        if ( CreateProcess( NULL, ( char * )commands[c].asChar(), NULL, NULL, true, CREATE_NO_WINDOW, NULL, ( LPCTSTR )path.asChar(), &sinfo, &pinfo ) ) {
+          CloseHandle( pinfo.hThread );
+          running.push_back( pinfo.hProcess );
+          runningCommand.push_back( c );
+          state[c] = commandRunning;
+        } else {
+          state[c] = commandDone;
+          left--;
+        }
+        started = true;
+      }
+    }
+    if ( !running.size() ) {
+      // what is left waits on itself
+      if ( !started ) break;
+      continue;
+    }
+
+    DWORD done = WaitForMultipleObjects( running.size(), &running[0], FALSE, INFINITE );
+    if ( done < WAIT_OBJECT_0 || done >= WAIT_OBJECT_0 + running.size() ) break;
+    unsigned i = done - WAIT_OBJECT_0;
+    DWORD exitCode = 1;
+    GetExitCodeProcess( running[i], &exitCode );
+    succeeded[ runningCommand[i] ] = exitCode == 0;
+    state[ runningCommand[i] ] = commandDone;
+    left--;
+    CloseHandle( running[i] );
+    running.erase( running.begin() + i );
+    runningCommand.erase( runningCommand.begin() + i );
+  }
+  for ( unsigned i = 0; i < running.size(); i++ ) CloseHandle( running[i] );
+}
+
+unsigned liqProcessLauncher::forkWorkers( unsigned count, std::vector<int> &workers )
+{
+  workers.clear();
+  return 0;
+}
+
+bool liqProcessLauncher::waitWorkers( const std::vector<int> &workers )
+{
+  return true;
+}
+
+void liqProcessLauncher::killWorkers( const std::vector<int> &workers )
+{
+}
+#endif // _WIN32
@@ -132,6 +132,8 @@ void liqRenderer::setRenderer()
 		  if ( feature == "depthoffield" )        supports_DOF                  = enabled;
 		  if ( feature == "advancedvisibility" )  supports_ADVANCED_VISIBILITY  = enabled;
 		  if ( feature == "displaychannels" )     supports_DISPLAY_CHANNELS     = enabled;
+		  if ( feature == "pointspheres" )        supports_POINT_SPHERES        = enabled;
+		  if ( feature == "inlinearchives" )      supports_INLINE_ARCHIVES      = enabled;
         }
       }
     }
@@ -276,6 +278,8 @@ void liqRenderer::setRenderer()
   cout <<"  supports_DOF                 : "<<supports_DOF<<endl;
   cout <<"  supports_ADVANCED_VISIBILITY : "<<supports_ADVANCED_VISIBILITY<<endl;
   cout <<"  supports_DISPLAY_CHANNELS    : "<<supports_DISPLAY_CHANNELS<<endl;
+  cout <<"  supports_POINT_SPHERES       : "<<supports_POINT_SPHERES<<endl;
+  cout <<"  supports_INLINE_ARCHIVES     : "<<supports_INLINE_ARCHIVES<<endl;
   cout <<"  pixelfilter_BOX            : "<<pixelfilter_BOX<<endl;
   cout <<"  pixelfilter_TRIANGLE       : "<<pixelfilter_TRIANGLE<<endl;
   cout <<"  pixelfilter_CATMULLROM     : "<<pixelfilter_CATMULLROM<<endl;
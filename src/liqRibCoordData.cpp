@@ -38,6 +38,7 @@ extern "C" {
 #include <maya/MFnDependencyNode.h>
 
 #include <liquid.h>
+#include <liqGlobalHelpers.h>
 #include <liqRibCoordData.h>
 
 extern int debugMode;
@@ -82,6 +83,16 @@ bool liqRibCoordData::compare( const liqRibData & otherObj ) const
     return true;
 }
 
+/**
+ * Add the coordinate system to a fingerprint.
+ */
+bool liqRibCoordData::hash( liqHash &h ) const
+{
+  hashTokens( h );
+  h.add( name );
+  return true;
+}
+
 /**
  * Return the geometry type.
  */
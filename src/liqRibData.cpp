@@ -80,13 +80,48 @@ liqRibData::~liqRibData()
   LIQDEBUGPRINTF("\n" );
 }
 
+unsigned liqRibData::detailLevels() const
+{
+  return 1;
+}
+
+void liqRibData::writeDetailLevel( unsigned level )
+{
+  write();
+}
+
+void liqRibData::detailRange( unsigned level, RtFloat fullDetailArea, RtFloat range[4] ) const
+{
+  range[0] = range[1] = 0;
+  range[2] = range[3] = RI_INFINITY;
+}
+
+bool liqRibData::hash( liqHash &h ) const
+{
+  return false;
+}
+
+void liqRibData::hashTokens( liqHash &h ) const
+{
+  h.add( ( int )type() );
+  h.add( ( unsigned )tokenPointerArray.size() );
+  for ( unsigned i = 0; i < tokenPointerArray.size(); i++ ) tokenPointerArray[i].hash( h );
+}
+
+void liqRibData::addToken( liqTokenPointer &token )
+{
+  tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+  tokenPointerArray.back().swap( token );
+}
+
 void liqRibData::parseVectorAttributes( MFnDependencyNode & nodeFn, MStringArray & strArray, ParameterType pType )
 {
   int i;
   MStatus status;
   if ( strArray.length() > 0 ) {
     for ( i = 0; i < strArray.length(); i++ ) {
-      liqTokenPointer tokenPointerPair;
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &tokenPointerPair = tokenPointerArray.back();
       MString cutString = strArray[i].substring(5, strArray[i].length());
       MPlug vPlug = nodeFn.findPlug( strArray[i] );
       MObject plugObj;
@@ -110,10 +145,6 @@ void liqRibData::parseVectorAttributes( MFnDependencyNode & nodeFn, MStringArray
         } else {
           tokenPointerPair.setDetailType( rVertex );
         }
-
-        // store it all
-        tokenPointerArray.push_back( tokenPointerPair );
-
       } else {
         // Hmmmm float ? double ?
         float x, y, z;
@@ -128,7 +159,6 @@ void liqRibData::parseVectorAttributes( MFnDependencyNode & nodeFn, MStringArray
         vPlug.child(2).getValue( z );
         tokenPointerPair.setTokenFloat( 0, x, y, z );
         tokenPointerPair.setDetailType( rConstant );
-        tokenPointerArray.push_back( tokenPointerPair );
       }
     }
   }
@@ -161,10 +191,16 @@ void liqRibData::addAdditionalSurfaceParameters( MObject node )
   MStringArray colorAttributesFound  = findAttributesByPrefix( "rmanC", nodeFn );
   MStringArray stringAttributesFound = findAttributesByPrefix( "rmanS", nodeFn );
 
+  // every attribute found adds one token, built in place below
+  tokenPointerArray.reserve( tokenPointerArray.size() + floatAttributesFound.length() +
+                             pointAttributesFound.length() + vectorAttributesFound.length() +
+                             normalAttributesFound.length() + colorAttributesFound.length() +
+                             stringAttributesFound.length() );
 
   if ( floatAttributesFound.length() > 0 ) {
     for ( i = 0; i < floatAttributesFound.length(); i++ ) {
-      liqTokenPointer tokenPointerPair;
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &tokenPointerPair = tokenPointerArray.back();
       MString cutString = floatAttributesFound[i].substring(5, floatAttributesFound[i].length());
       MPlug fPlug = nodeFn.findPlug( floatAttributesFound[i] );
       MObject plugObj;
@@ -224,13 +260,13 @@ void liqRibData::addAdditionalSurfaceParameters( MObject node )
         }
 
       }
-      tokenPointerArray.push_back( tokenPointerPair );
     }
   }
 
   if ( pointAttributesFound.length() > 0 ) {
     for ( i = 0; i < pointAttributesFound.length(); i++ ) {
-      liqTokenPointer tokenPointerPair;
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &tokenPointerPair = tokenPointerArray.back();
       MString cutString = pointAttributesFound[i].substring(5, pointAttributesFound[i].length());
       MPlug pPlug = nodeFn.findPlug( pointAttributesFound[i] );
       MObject plugObj;
@@ -271,7 +307,6 @@ void liqRibData::addAdditionalSurfaceParameters( MObject node )
         tokenPointerPair.setTokenFloat( 0, x, y, z );
         tokenPointerPair.setDetailType( rConstant );
       }
-      tokenPointerArray.push_back( tokenPointerPair );
     }
   }
   parseVectorAttributes( nodeFn, vectorAttributesFound, rVector );
@@ -280,7 +315,8 @@ void liqRibData::addAdditionalSurfaceParameters( MObject node )
 
   if ( stringAttributesFound.length() > 0 ) {
     for ( i = 0; i < stringAttributesFound.length(); i++ ) {
-      liqTokenPointer tokenPointerPair;
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &tokenPointerPair = tokenPointerArray.back();
       MString cutString = stringAttributesFound[i].substring(5, stringAttributesFound[i].length());
       MPlug sPlug = nodeFn.findPlug( stringAttributesFound[i] );
       MObject plugObj;
@@ -296,7 +332,6 @@ void liqRibData::addAdditionalSurfaceParameters( MObject node )
       sPlug.getValue( stringVal );
       tokenPointerPair.setTokenString( 0, stringVal.asChar(), stringVal.length() );
       tokenPointerPair.setDetailType( rConstant );
-      tokenPointerArray.push_back( tokenPointerPair );
     }
   }
 }
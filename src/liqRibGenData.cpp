@@ -33,8 +33,9 @@
 */
 
 #ifndef _WIN32
-#  include <dlfcn.h> // dlopen() etc
+#  include <pthread.h>
 #endif
+#include <string>
 
 // Renderman Headers
 extern "C" {
@@ -55,6 +56,7 @@ extern "C" {
 #include <liqGlobalHelpers.h>
 #include <liqRibGenData.h>
 #include <liqRibGen.h>
+#include <liqRibGenRegistry.h>
 
 extern int debugMode;
 
@@ -103,6 +105,7 @@ liqRibGenData::liqRibGenData( MObject obj, MDagPath path )
 	ribStatus.objectName = (char *)lmalloc( sizeof(char) * ( fnNode.name().length() + 1 ) );
 	strcpy( ribStatus.objectName, fnNode.name().asChar() );
 	ribStatus.dagPath = path;
+	generatedFP = NULL;
 }
 
 liqRibGenData::~liqRibGenData()
@@ -114,19 +117,15 @@ liqRibGenData::~liqRibGenData()
     LIQDEBUGPRINTF( "-> killing ribgen\n" );
 		lfree( ribStatus.objectName ); 
 		ribStatus.objectName = NULL; 
+		releaseGenerated();
 }
 
-void liqRibGenData::write()
+void liqRibGenData::setupStatus()
+//
+//  Description:
+//      fill the ribgen status from the current frame and job
+//
 {
-	LIQDEBUGPRINTF( "-> writing ribgen\n" );
-#ifdef PRMAN
-#ifndef _WIN32
-	void *handle;
-#else 
-	HINSTANCE handle;
-#endif
-	char *dlStatus = NULL;
-	// Hmmmmmm do not really understand what's going on here 
 	ribStatus.ribFP = liqglo_ribFP;
 	ribStatus.frame = liqglo_lframe;
 	if ( liqglo_currentJob.isShadow ) {
@@ -150,6 +149,60 @@ void liqRibGenData::write()
 		ribStatus.motionSamples = 1;
 	}		
 	ribStatus.shutterAngle = liqglo_shutterTime;
+}
+
+void liqRibGenData::releaseGenerated()
+{
+	if ( generatedFP != NULL ) {
+		fclose( generatedFP );
+		generatedFP = NULL;
+	}
+}
+
+void liqRibGenData::write()
+{
+	LIQDEBUGPRINTF( "-> writing ribgen\n" );
+#ifdef PRMAN
+	if ( generatedFP != NULL ) {
+		// already generated on a worker thread, splice it in. Records are
+		// kept well under the verbatim scratch buffer of the rib writer and
+		// only broken after a separator outside of quoted strings, which
+		// stays with its record, so the spliced stream is the generated one.
+		std::string rib;
+		char buffer[ 4096 ];
+		size_t got;
+		rewind( generatedFP );
+		while ( ( got = fread( buffer, 1, sizeof( buffer ), generatedFP ) ) > 0 ) rib.append( buffer, got );
+		const size_t maxRecord = 900;
+		size_t pos = 0, lastBreak = 0;
+		bool quoted = false;
+		for ( size_t i = 0; i < rib.size(); i++ ) {
+			char c = rib[ i ];
+			if ( quoted ) {
+				if ( c == '\\' ) i++;
+				else if ( c == '"' ) quoted = false;
+				continue;
+			}
+			// a single token longer than a record goes out whole
+			if ( i - pos >= maxRecord && lastBreak > pos ) {
+				RiArchiveRecord( RI_VERBATIM, "%s", rib.substr( pos, lastBreak - pos ).c_str() );
+				pos = lastBreak;
+			}
+			if ( c == '"' ) {
+				quoted = true;
+			} else if ( c == '\n' ) {
+				RiArchiveRecord( RI_VERBATIM, "%s", rib.substr( pos, i + 1 - pos ).c_str() );
+				pos = lastBreak = i + 1;
+			} else if ( c == ' ' || c == '\t' ) {
+				lastBreak = i + 1;
+			}
+		}
+		if ( pos < rib.size() ) RiArchiveRecord( RI_VERBATIM, "%s", rib.substr( pos ).c_str() );
+		releaseGenerated();
+		return;
+	}
+
+	setupStatus();
     
 	/*
 	* rib stream connection call from the Affine toolkit.
@@ -158,48 +211,11 @@ void liqRibGenData::write()
 	*/
 	//ribStatus.RiConnection = RiDetach();
 	
-	typedef liqRibGen *(*createRibGen)();
-	typedef void (*destroyRibGen)( liqRibGen * );
-	
-	createRibGen		createRibGenFunc;
-	destroyRibGen		destroyRibGenFunc;
-	
-#ifndef _WIN32
-	handle = dlopen( ribGenSoName.asChar(), RTLD_LAZY );
-	dlStatus = dlerror();
-	if ( dlStatus == NULL ) {
-		createRibGenFunc = (createRibGen)dlsym( handle, "RIBGenCreate" );
-		destroyRibGenFunc = (destroyRibGen)dlsym( handle, "RIBGenDestroy" );
-		dlStatus = dlerror();
-		if ( dlStatus == NULL ) {
-#else
-	handle = LoadLibrary( ribGenSoName.asChar() );
-	if ( handle != NULL ) {
-		createRibGenFunc = (createRibGen)GetProcAddress( handle, "RIBGenCreate" );
-		destroyRibGenFunc = (destroyRibGen)GetProcAddress( handle, "RIBGenDestroy" );
-		if ( ( createRibGenFunc != NULL ) && ( destroyRibGenFunc != NULL ) ) {
-#endif
-			liqRibGen *ribGen = (*createRibGenFunc)();
-			ribGen->_GenRIB( &ribStatus );
-			(*destroyRibGenFunc)( ribGen );
-		} else {
-			MString errorString = "Error reading RIBGenCreate or RIBGenDestroy in RibGen: ";
-			errorString += ribGenSoName;
-			liquidInfo( errorString );
-		}
-#ifndef _WIN32
-		dlclose( handle );
-#else
-		FreeLibrary( handle );
-#endif
-	} else {
-		MString errorString = "Error opening RibGen: ";
-		errorString += ribGenSoName;
-		errorString += " ";
-		errorString += dlStatus;
-		errorString += " on object: ";
-		errorString += ribStatus.objectName;
-		liquidInfo( errorString );
+	const liqRibGenRegistry::library *lib = liqRibGenRegistry::get( ribGenSoName, ribStatus.objectName );
+	if ( lib != NULL ) {
+		liqRibGen *ribGen = (*lib->create)();
+		ribGen->_GenRIB( &ribStatus );
+		(*lib->destroy)( ribGen );
 	}
 
 	/*
@@ -213,6 +229,82 @@ void liqRibGenData::write()
     liquidInfo( "Sorry : Can't handle Rib Gen ...\n" );
 #endif
 }
+
+#if defined( PRMAN ) && !defined( _WIN32 )
+struct liqRibGenWork {
+	liqRibGenData   *data;
+	liqRibStatus    *status;
+	liqRibGen       *ribGen;
+};
+
+struct liqRibGenQueue {
+	std::vector<liqRibGenWork>  work;
+	unsigned                    next;
+	pthread_mutex_t             lock;
+};
+
+static void *ribGenWorker( void *arg )
+{
+	liqRibGenQueue *queue = (liqRibGenQueue *)arg;
+	while ( 1 ) {
+		pthread_mutex_lock( &queue->lock );
+		unsigned i = queue->next++;
+		pthread_mutex_unlock( &queue->lock );
+		if ( i >= queue->work.size() ) break;
+		queue->work[i].ribGen->_GenRIB( queue->work[i].status );
+	}
+	return NULL;
+}
+#endif
+
+void liqRibGenData::generate( std::vector<liqRibGenData*> &ribGens, unsigned numThreads )
+//
+//  Description:
+//      run the thread safe ribgens in parallel, in their own buffers
+//
+{
+#if defined( PRMAN ) && !defined( _WIN32 )
+	liqRibGenQueue queue;
+	queue.next = 0;
+	unsigned i;
+	for ( i = 0; i < ribGens.size(); i++ ) {
+		liqRibGenData *data = ribGens[i];
+		data->releaseGenerated();
+		const liqRibGenRegistry::library *lib = liqRibGenRegistry::get( data->ribGenSoName, data->ribStatus.objectName );
+		if ( lib == NULL || !lib->threadSafe ) continue;
+		FILE *fp = tmpfile();
+		if ( fp == NULL ) continue;
+		data->setupStatus();
+		data->ribStatus.ribFP = fp;
+		data->generatedFP = fp;
+		liqRibGenWork work;
+		work.data = data;
+		work.status = &data->ribStatus;
+		work.ribGen = (*lib->create)();
+		queue.work.push_back( work );
+	}
+	if ( queue.work.empty() ) return;
+	if ( numThreads > queue.work.size() ) numThreads = queue.work.size();
+	if ( debugMode ) printf( "-> generating %u ribgens on %u threads\n", ( unsigned )queue.work.size(), numThreads );
+
+	pthread_mutex_init( &queue.lock, NULL );
+	// this thread is one of the workers
+	std::vector<pthread_t> threads( numThreads );
+	unsigned started = 0;
+	for ( i = 1; i < numThreads; i++ ) {
+		if ( pthread_create( &threads[ started ], NULL, ribGenWorker, &queue ) == 0 ) started++;
+	}
+	ribGenWorker( &queue );
+	for ( i = 0; i < started; i++ ) pthread_join( threads[i], NULL );
+	pthread_mutex_destroy( &queue.lock );
+
+	for ( i = 0; i < queue.work.size(); i++ ) {
+		const liqRibGenRegistry::library *lib = liqRibGenRegistry::get( queue.work[i].data->ribGenSoName, NULL );
+		(*lib->destroy)( queue.work[i].ribGen );
+		fflush( queue.work[i].data->generatedFP );
+	}
+#endif
+}
 		
 bool liqRibGenData::compare( const liqRibData & otherObj ) const
 //
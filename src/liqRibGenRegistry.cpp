@@ -0,0 +1,125 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+/* ______________________________________________________________________
+**
+** Liquid Rib Gen Registry Source
+** ______________________________________________________________________
+*/
+
+#ifndef _WIN32
+#  include <dlfcn.h> // dlopen() etc
+#else
+#  include <windows.h>
+#endif
+
+#include <string>
+#include <map>
+
+#include <liquid.h>
+#include <liqGlobalHelpers.h>
+#include <liqRibGenRegistry.h>
+
+extern int debugMode;
+
+static std::map<std::string, liqRibGenRegistry::library> ribGenLibraries;
+
+
+const liqRibGenRegistry::library *liqRibGenRegistry::get( const MString &soName, const char *objectName )
+{
+  std::string key( soName.asChar() );
+  std::map<std::string, library>::iterator found = ribGenLibraries.find( key );
+  if ( found != ribGenLibraries.end() ) {
+    return ( found->second.create != NULL )? &found->second : NULL;
+  }
+
+  // failures are remembered too, so a missing library is only reported once
+  library &lib = ribGenLibraries[ key ];
+  lib.handle = NULL;
+  lib.create = NULL;
+  lib.destroy = NULL;
+  lib.threadSafe = false;
+
+  threadSafeRibGen threadSafeFunc = NULL;
+#ifndef _WIN32
+  dlerror();
+  lib.handle = dlopen( soName.asChar(), RTLD_LAZY );
+  if ( lib.handle == NULL ) {
+    MString errorString = "Error opening RibGen: ";
+    errorString += soName;
+    errorString += " ";
+    errorString += dlerror();
+    errorString += " on object: ";
+    errorString += objectName;
+    liquidInfo( errorString );
+    return NULL;
+  }
+  lib.create = (createRibGen)dlsym( lib.handle, "RIBGenCreate" );
+  lib.destroy = (destroyRibGen)dlsym( lib.handle, "RIBGenDestroy" );
+  threadSafeFunc = (threadSafeRibGen)dlsym( lib.handle, "RIBGenIsThreadSafe" );
+  dlerror();
+#else
+  HINSTANCE handle = LoadLibrary( soName.asChar() );
+  if ( handle == NULL ) {
+    MString errorString = "Error opening RibGen: ";
+    errorString += soName;
+    errorString += " on object: ";
+    errorString += objectName;
+    liquidInfo( errorString );
+    return NULL;
+  }
+  lib.handle = (void *)handle;
+  lib.create = (createRibGen)GetProcAddress( handle, "RIBGenCreate" );
+  lib.destroy = (destroyRibGen)GetProcAddress( handle, "RIBGenDestroy" );
+  threadSafeFunc = (threadSafeRibGen)GetProcAddress( handle, "RIBGenIsThreadSafe" );
+#endif
+
+  if ( lib.create == NULL || lib.destroy == NULL ) {
+    MString errorString = "Error reading RIBGenCreate or RIBGenDestroy in RibGen: ";
+    errorString += soName;
+    liquidInfo( errorString );
+    lib.create = NULL;
+    return NULL;
+  }
+  lib.threadSafe = ( threadSafeFunc != NULL ) && ( (*threadSafeFunc)() != 0 );
+  if ( debugMode ) printf( "-> loaded ribgen %s%s\n", soName.asChar(), lib.threadSafe ? " (thread safe)" : "" );
+  return &lib;
+}
+
+void liqRibGenRegistry::unloadAll()
+{
+  std::map<std::string, library>::iterator it;
+  for ( it = ribGenLibraries.begin(); it != ribGenLibraries.end(); ++it ) {
+    if ( it->second.handle == NULL ) continue;
+#ifndef _WIN32
+    dlclose( it->second.handle );
+#else
+    FreeLibrary( (HINSTANCE)it->second.handle );
+#endif
+  }
+  ribGenLibraries.clear();
+}
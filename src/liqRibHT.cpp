@@ -79,6 +79,8 @@ liqRibHT::~liqRibHT()
     }
     RibNodeMap.clear();
   }
+  // all the scanned geometry is gone, give its memory back in one go
+  larenaReset();
   if ( debugMode ) {
     printf("-> finished killing hash table\n");
   }
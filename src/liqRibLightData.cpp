@@ -271,7 +271,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                       tokenPointerPair.setTokenString( kk, stringPlugVal.asChar(), stringPlugVal.length() );
                     }
                   }
-                  tokenPointerArray.push_back( tokenPointerPair );
+                  addToken( tokenPointerPair );
                 }
               } else {
                 // simple string
@@ -291,7 +291,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                   parsingString.toLowerCase();
                   tokenPointerPair.set( shaderInfo.getArgName( i ).asChar(), rString, false, 0, 0 );
                   tokenPointerPair.setTokenString( 0, stringPlugVal.asChar(), stringPlugVal.length() );
-                  tokenPointerArray.push_back( tokenPointerPair );
+                  addToken( tokenPointerPair );
                 }
               }
             }
@@ -316,7 +316,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                       tokenPointerPair.setTokenFloat( kk, x  );
                     }
                   }
-                  tokenPointerArray.push_back( tokenPointerPair );
+                  addToken( tokenPointerPair );
                 } else {
                   // philippe : keep the old stuff for compatibility's sake
                   if ( liqglo_expandShaderArrays ) {
@@ -342,7 +342,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                     tokenPointerPair.set( shaderInfo.getArgName( i ).asChar(), rFloat, false, false, true, arraySize );
                     for( int k = 0; k < arraySize; k++ )
                       tokenPointerPair.setTokenFloat( k, doubleArrayData[k] );
-                    tokenPointerArray.push_back( tokenPointerPair );
+                    addToken( tokenPointerPair );
                   }
                 }
               } else {
@@ -350,7 +350,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                 floatPlug.getValue( floatPlugVal );
                 tokenPointerPair.set( shaderInfo.getArgName( i ).asChar(), rFloat, false, false, false, 0 );
                 tokenPointerPair.setTokenFloat( 0, floatPlugVal );
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             }
             break; }
@@ -372,7 +372,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                     tokenPointerPair.setTokenFloat( kk, x, y, z );
                   }
                 }
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             } else {
               if ( status == MS::kSuccess ) {
@@ -382,7 +382,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                 triplePlug.child(2).getValue( z );
                 tokenPointerPair.set( shaderInfo.getArgName( i ).asChar(), rColor, false, false, false, 0 );
                 tokenPointerPair.setTokenFloat( 0, x, y, z );
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             }
             break; }
@@ -404,7 +404,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                     tokenPointerPair.setTokenFloat( kk, x, y, z );
                   }
                 }
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             } else {
               if ( status == MS::kSuccess ) {
@@ -414,7 +414,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                 triplePlug.child(2).getValue( z );
                 tokenPointerPair.set( shaderInfo.getArgName( i ).asChar(), rPoint, false, false, false, 0 );
                 tokenPointerPair.setTokenFloat( 0, x, y, z );
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             }
             break; }
@@ -436,7 +436,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                     tokenPointerPair.setTokenFloat( kk, x, y, z );
                   }
                 }
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             } else {
               MPlug triplePlug = lightDepNode.findPlug( shaderInfo.getArgName( i ), &status );
@@ -447,7 +447,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                 triplePlug.child(2).getValue( z );
                 tokenPointerPair.set( shaderInfo.getArgName( i ).asChar(), rVector, false, false, false, 0 );
                 tokenPointerPair.setTokenFloat( 0, x, y, z );
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             }
             break; }
@@ -469,7 +469,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                     tokenPointerPair.setTokenFloat( kk, x, y, z );
                   }
                 }
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             } else {
               MPlug triplePlug = lightDepNode.findPlug( shaderInfo.getArgName( i ), &status );
@@ -480,7 +480,7 @@ liqRibLightData::liqRibLightData( const MDagPath & light )
                 triplePlug.child(2).getValue( z );
                 tokenPointerPair.set( shaderInfo.getArgName( i ).asChar(), rNormal, false, false, false, 0 );
                 tokenPointerPair.setTokenFloat( 0, x, y, z );
-                tokenPointerArray.push_back( tokenPointerPair );
+                addToken( tokenPointerPair );
               }
             }
             break; }
@@ -1023,6 +1023,76 @@ bool liqRibLightData::compare( const liqRibData & otherObj ) const
   LIQDEBUGPRINTF( "-> comparing light\n" );
   return true;
 }
+bool liqRibLightData::hash( liqHash &h ) const
+//
+//  Description:
+//      Add the light and its shader parameters to a fingerprint
+//
+{
+  hashTokens( h );
+  h.add( ( int )rmanLight );
+  h.add( assignedRManShader );
+  h.add( ( int )lightType );
+  h.add( color, sizeof( color ) );
+  h.add( decay );
+  h.add( intensity );
+  h.add( coneAngle );
+  h.add( penumbraAngle );
+  h.add( dropOff );
+  h.add( barnDoors );
+  h.add( leftBarnDoor );
+  h.add( rightBarnDoor );
+  h.add( topBarnDoor );
+  h.add( bottomBarnDoor );
+  h.add( decayRegions );
+  h.add( startDistance1 );
+  h.add( endDistance1 );
+  h.add( startDistance2 );
+  h.add( endDistance2 );
+  h.add( startDistance3 );
+  h.add( endDistance3 );
+  h.add( startDistanceIntensity1 );
+  h.add( endDistanceIntensity1 );
+  h.add( startDistanceIntensity2 );
+  h.add( endDistanceIntensity2 );
+  h.add( startDistanceIntensity3 );
+  h.add( endDistanceIntensity3 );
+  h.add( lightMap );
+  h.add( lightMapSaturation );
+  h.add( nonDiffuse );
+  h.add( nonSpecular );
+  h.add( transformationMatrix, sizeof( transformationMatrix ) );
+  h.add( ( int )usingShadow );
+  h.add( ( int )deepShadows );
+  h.add( ( int )rayTraced );
+  h.add( raySamples );
+  h.add( shadowRadius );
+  h.add( ( int )excludeFromRib );
+  h.add( bothSidesEmit );
+  h.add( userShadowName );
+  h.add( lightName );
+  h.add( ( int )shadowType );
+  h.add( ( int )shadowHiderType );
+  h.add( ( int )everyFrame );
+  h.add( ( int )renderAtFrame );
+  h.add( geometrySet );
+  h.add( shadowName );
+  h.add( shadowNamePx );
+  h.add( shadowNameNx );
+  h.add( shadowNamePy );
+  h.add( shadowNameNy );
+  h.add( shadowNamePz );
+  h.add( shadowNameNz );
+  h.add( shadowBias );
+  h.add( shadowFilterSize );
+  h.add( shadowSamples );
+  h.add( shadowColor, sizeof( shadowColor ) );
+  h.add( lightCategory );
+  h.add( lightID );
+  h.add( hitmode );
+  return true;
+}
+
 ObjectType liqRibLightData::type() const
 //
 //  Description:
@@ -92,6 +92,16 @@ bool liqRibLocatorData::compare( const liqRibData & otherObj ) const
   return true;
 }
 
+bool liqRibLocatorData::hash( liqHash &h ) const
+//
+//  Description:
+//      Add the locator to a fingerprint
+//
+{
+  hashTokens( h );
+  return true;
+}
+
 ObjectType liqRibLocatorData::type() const
 //
 //  Description:
@@ -0,0 +1,176 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+/* ______________________________________________________________________
+**
+** Liquid RIB Manifest Source
+**
+** The manifest is a log : each RIB written appends its fingerprint and the
+** one of its inputs, which lets processes exporting jobs or frames side by
+** side share it. The last record of a RIB is the one that counts.
+** ______________________________________________________________________
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include <liquid.h>
+#include <liqGlobalHelpers.h>
+#include <liqRibManifest.h>
+
+extern int debugMode;
+extern MString liqglo_ribDir;
+extern MString liqglo_projectDir;
+extern bool liqglo_relativeFileNames;
+
+static const char *manifestHeader = "liquidRibs 2";
+
+struct ribRecord {
+  std::string fingerprint;  // of the RIB contents, comments left out
+  std::string inputs;       // of what it was made from, empty if unknown
+};
+
+static std::string                      manifestName;
+static std::map<std::string, ribRecord> records;   // by RIB file name
+
+
+static void writeString( FILE *fp, const std::string &str )
+{
+  fprintf( fp, " %u:", ( unsigned )str.size() );
+  fwrite( str.data(), 1, str.size(), fp );
+}
+
+static bool readString( FILE *fp, std::string &str )
+{
+  unsigned length;
+  if ( fscanf( fp, " %u:", &length ) != 1 ) return false;
+  str.resize( length );
+  return length == 0 || fread( &str[0], 1, length, fp ) == length;
+}
+
+static void readManifest( const std::string &fileName )
+{
+  records.clear();
+  FILE *fp = fopen( fileName.c_str(), "rb" );
+  if ( !fp ) return;
+  char header[64];
+  bool current = fgets( header, sizeof( header ), fp ) && !strncmp( header, manifestHeader, strlen( manifestHeader ) );
+  if ( current ) {
+    std::string rib;
+    ribRecord record;
+    while ( readString( fp, rib ) && readString( fp, record.fingerprint ) && readString( fp, record.inputs ) ) records[ rib ] = record;
+  }
+  fclose( fp );
+  // a manifest of an older format is started again
+  if ( !current ) remove( fileName.c_str() );
+}
+
+// the manifest of the current RIB directory
+static void loadManifest()
+{
+  std::string fileName = ( LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, liqglo_ribDir, liqglo_projectDir ) + ".liquidRibs" ).asChar();
+  if ( fileName == manifestName ) return;
+  manifestName = fileName;
+  readManifest( fileName );
+  if ( debugMode ) printf( "-> read %u RIB records from %s\n", ( unsigned )records.size(), fileName.c_str() );
+}
+
+bool liqRibManifest::upToDate( const MString &ribName, const MString &inputs )
+{
+  if ( inputs == "" ) return false;
+  loadManifest();
+  std::map<std::string, ribRecord>::const_iterator found = records.find( ribName.asChar() );
+  return found != records.end() && found->second.inputs == inputs.asChar() && fileExists( ribName );
+}
+
+MString liqRibManifest::pendingName( const MString &ribName )
+{
+  return ribName + ".pending";
+}
+
+bool liqRibManifest::commit( const MString &ribName, const MString &inputs )
+{
+  loadManifest();
+  MString pending = pendingName( ribName );
+  ribRecord record;
+  record.fingerprint = liquidFileHash( pending, true ).asChar();
+  record.inputs = inputs.asChar();
+
+  std::map<std::string, ribRecord>::const_iterator found = records.find( ribName.asChar() );
+  bool changed = record.fingerprint == "" || found == records.end() || found->second.fingerprint != record.fingerprint || !fileExists( ribName );
+  if ( changed ) {
+    remove( ribName.asChar() );
+    rename( pending.asChar(), ribName.asChar() );
+  } else {
+    remove( pending.asChar() );
+    if ( found->second.inputs == record.inputs ) return false;
+  }
+  // a RIB that can't be read is not vouched for
+  if ( record.fingerprint == "" ) record.inputs.clear();
+  records[ ribName.asChar() ] = record;
+
+  // a new manifest starts with its header
+  FILE *fp = fopen( manifestName.c_str(), "ab" );
+  if ( fp ) {
+    fseek( fp, 0, SEEK_END );
+    if ( ftell( fp ) == 0 ) fprintf( fp, "%s\n", manifestHeader );
+    writeString( fp, ribName.asChar() );
+    writeString( fp, record.fingerprint );
+    writeString( fp, record.inputs );
+    fprintf( fp, "\n" );
+    fclose( fp );
+  }
+  return changed;
+}
+
+void liqRibManifest::save()
+{
+  if ( manifestName == "" ) return;
+  // other processes may have added records since it was loaded
+  readManifest( manifestName );
+  std::string compacted = manifestName + ".pending";
+  FILE *fp = fopen( compacted.c_str(), "wb" );
+  if ( !fp ) {
+    if ( debugMode ) printf( "-> could not write RIB manifest %s\n", manifestName.c_str() );
+    return;
+  }
+  fprintf( fp, "%s\n", manifestHeader );
+  std::map<std::string, ribRecord>::const_iterator it;
+  for ( it = records.begin(); it != records.end(); ++it ) {
+    writeString( fp, it->first );
+    writeString( fp, it->second.fingerprint );
+    writeString( fp, it->second.inputs );
+    fprintf( fp, "\n" );
+  }
+  fclose( fp );
+  remove( manifestName.c_str() );
+  rename( compacted.c_str(), manifestName.c_str() );
+  manifestName.clear();
+}
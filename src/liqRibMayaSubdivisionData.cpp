@@ -120,12 +120,12 @@ liqRibMayaSubdivisionData::liqRibMayaSubdivisionData( MObject mesh )
     i++;
   }
   }
-  verts = (RtInt*) lmalloc( sizeof( RtInt ) * polyvertsIds.length() );
+  verts = (RtInt*) lamalloc( sizeof( RtInt ) * polyvertsIds.length() );
   for( unsigned i = 0; i < polyvertsIds.length(); i++ ) {
     verts[i] = idmap[polyvertsIds[i]];
   }  
   npolys = nvertsArray.length();
-  nverts = (RtInt*) lmalloc( sizeof( RtInt ) * nvertsArray.length() );
+  nverts = (RtInt*) lamalloc( sizeof( RtInt ) * nvertsArray.length() );
   nvertsArray.get( nverts );
 
   // End nverts and vertices array
@@ -136,7 +136,9 @@ liqRibMayaSubdivisionData::liqRibMayaSubdivisionData( MObject mesh )
 
   // Allocate memory for arrays
   // Vertices of the mesh or control cage
-  liqTokenPointer vertexPointerPair;
+  LIQDEBUGPRINTF( "-> adding vertex token\n" );
+  tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+  liqTokenPointer &vertexPointerPair = tokenPointerArray.back();
   vertexPointerPair.set( "P", rPoint, false, idmap.size() );
   vertexParam = vertexPointerPair.getTokenFloatArray( );
   vertexPointerPair.setDetailType( rVertex );
@@ -147,9 +149,6 @@ liqRibMayaSubdivisionData::liqRibMayaSubdivisionData( MObject mesh )
     vertexPointerPair.setTokenFloat( mi->second, pt.x, pt.y, pt.z );
   }
 
-  
-  LIQDEBUGPRINTF( "-> adding vertex token\n" );
-  tokenPointerArray.push_back( vertexPointerPair );
   // End Vertex positions
   ////////////
 
@@ -160,6 +159,10 @@ liqRibMayaSubdivisionData::liqRibMayaSubdivisionData( MObject mesh )
   // the face/vertex uv's
   // Oh so dirty.  Must wash my hands.  At least there are no mem leaks here
   
+  // The st, u and v tokens are built in place, so make room for them first
+  unsigned token = tokenPointerArray.size();
+  tokenPointerArray.resize( token + ( liqglo_outputMeshUVs ? 3 : 1 ) );
+  liqTokenPointer &stTexCordPair = tokenPointerArray[ token ];
   liqTokenPointer* pFaceVertexSPointer = NULL;
   liqTokenPointer* pFaceVertexTPointer = NULL;
   
@@ -177,7 +180,6 @@ liqRibMayaSubdivisionData::liqRibMayaSubdivisionData( MObject mesh )
     uVal.clear(); vVal.clear();
   }
   
-  liqTokenPointer stTexCordPair;
   stTexCordPair.set( "st", rFloat, false, uMap.length(), 2 );
 #ifndef DELIGHT
   stTexCordPair.setDetailType( rFaceVarying );
@@ -186,8 +188,8 @@ liqRibMayaSubdivisionData::liqRibMayaSubdivisionData( MObject mesh )
 #endif
     
   if( liqglo_outputMeshUVs ) {
-    pFaceVertexSPointer = new liqTokenPointer;
-    pFaceVertexTPointer = new liqTokenPointer;
+    pFaceVertexSPointer = &tokenPointerArray[ token + 1 ];
+    pFaceVertexTPointer = &tokenPointerArray[ token + 2 ];
     // Match MTOR, which also outputs face-varying STs as well for some reason - Paul
     // There should be a flag in the globals to disable/enable this as it creates
     // bloated RIBs for no reason if you're not concerned about MtoR - Moritz
@@ -234,13 +236,12 @@ liqRibMayaSubdivisionData::liqRibMayaSubdivisionData( MObject mesh )
     }
     uVal.clear(); vVal.clear(); children.clear();
   }
-  liqTokenPointer stTexCordPair;
   stTexCordPair.set( "st", rFloat, false, sMap.size(), 2 );
   stTexCordPair.setDetailType( rVertex );
   
   if( liqglo_outputMeshUVs ) {
-    pFaceVertexSPointer = new liqTokenPointer;
-    pFaceVertexTPointer = new liqTokenPointer;
+    pFaceVertexSPointer = &tokenPointerArray[ token + 1 ];
+    pFaceVertexTPointer = &tokenPointerArray[ token + 2 ];
     // Match MTOR, which also outputs face-varying STs as well for some reason - Paul
     // There should be a flag in the globals to disable/enable this as it creates
     // bloated RIBs for no reason if you're not concerned about MtoR - Moritz
@@ -264,18 +265,6 @@ liqRibMayaSubdivisionData::liqRibMayaSubdivisionData( MObject mesh )
     }
   }
 #endif // #if defined(PRMAN) || defined(DELIGHT)
-
-  tokenPointerArray.push_back( stTexCordPair );
-  
-  if( pFaceVertexSPointer != NULL ) {
-    tokenPointerArray.push_back( *pFaceVertexSPointer );
-    delete pFaceVertexSPointer;
-  }
-
-  if( pFaceVertexTPointer != NULL ) {
-    tokenPointerArray.push_back( *pFaceVertexTPointer );
-    delete pFaceVertexTPointer;
-  }  
   // End Texture coordinates
   ////////////
 
@@ -314,8 +303,8 @@ liqRibMayaSubdivisionData::~liqRibMayaSubdivisionData()
 // Description: class destructor
 {
   if ( debugMode ) { printf("-> killing maya subdivision surface\n"); }
-  lfree( nverts ); nverts = NULL;
-  lfree( verts ); verts = NULL;
+  lafree( nverts ); nverts = NULL;
+  lafree( verts ); verts = NULL;
 }
 
 void liqRibMayaSubdivisionData::write()
@@ -439,6 +428,23 @@ bool liqRibMayaSubdivisionData::compare( const liqRibData & otherObj ) const
   return true;  
 }
 
+bool liqRibMayaSubdivisionData::hash( liqHash &h ) const
+// Description: Add the mesh and its creases to a fingerprint
+{
+  hashTokens( h );
+  h.add( ( int )npolys );
+  unsigned totalPolyVerts = 0;
+  for ( unsigned i = 0; i < npolys; ++i ) totalPolyVerts += nverts[i];
+  h.add( nverts, sizeof( RtInt ) * npolys );
+  h.add( verts, sizeof( RtInt ) * totalPolyVerts );
+  h.add( ( int )hasCreases );
+  h.add( ( int )hasCorners );
+  unsigned i;
+  for ( i = 0; i < creases.length(); i++ ) h.add( creases[i] );
+  for ( i = 0; i < corners.length(); i++ ) h.add( corners[i] );
+  return true;
+}
+
 ObjectType liqRibMayaSubdivisionData::type() const
 // Description: return the geometry type
 {
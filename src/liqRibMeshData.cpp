@@ -56,6 +56,7 @@ extern "C" {
 
 extern int debugMode;
 extern bool liqglo_outputMeshUVs;
+extern bool liqglo_polygonLOD;
 
 
 liqRibMeshData::liqRibMeshData( MObject mesh )
@@ -69,7 +70,8 @@ liqRibMeshData::liqRibMeshData( MObject mesh )
   nverts( NULL ),
   verts( NULL ),
   vertexParam( NULL ),
-  normalParam( NULL )
+  normalParam( NULL ),
+  lod( NULL )
 {
   areaLight = false;
   LIQDEBUGPRINTF( "-> creating mesh\n" );
@@ -133,13 +135,12 @@ liqRibMeshData::liqRibMeshData( MObject mesh )
   float S;
   float T;
   MPoint point;
-  liqTokenPointer pointsPointerPair;
-  liqTokenPointer normalsPointerPair;
+  liqTokenPointer* pointsPointerPair;
+  liqTokenPointer* normalsPointerPair;
   liqTokenPointer* pVertexSTPointerPair = NULL;
   liqTokenPointer* pFaceVertexSPointer = NULL;
   liqTokenPointer* pFaceVertexTPointer = NULL;
-  liqTokenPointer* pFaceVertexUPointer = NULL;
-  liqTokenPointer* pFaceVertexVPointer = NULL;
+  liqTokenPointer* pUVSetsPointers = NULL;
 
   //cout <<"   + vertices : "<<numPoints<<endl;
   //cout <<"   + normals  : "<<numNormals<<endl;
@@ -150,61 +151,66 @@ liqRibMeshData::liqRibMeshData( MObject mesh )
 
   // Allocate memory and tokens
   numFaces = numFaces;
-  nverts = (RtInt*) lmalloc( sizeof( RtInt ) * numFaces );
-  verts = (RtInt*) lmalloc( sizeof( RtInt ) * numFaceVertices );
+  nverts = (RtInt*) lamalloc( sizeof( RtInt ) * numFaces );
+  verts = (RtInt*) lamalloc( sizeof( RtInt ) * numFaceVertices );
 
-  pointsPointerPair.set( "P", rPoint, false, numPoints );
-  pointsPointerPair.setDetailType( rVertex );
+  // The tokens are built in place in tokenPointerArray, which is sized
+  // up front so the pointers below stay valid
+  unsigned numTokens = 2;
+  if ( numSTs > 0 ) {
+    numTokens += 1 + ( liqglo_outputMeshUVs ? 2 : 0 ) + 2 * extraUVSetNames.length();
+  }
+  unsigned token = tokenPointerArray.size();
+  tokenPointerArray.resize( token + numTokens );
 
+  pointsPointerPair = &tokenPointerArray[ token++ ];
+  pointsPointerPair->set( "P", rPoint, false, numPoints );
+  pointsPointerPair->setDetailType( rVertex );
+
+  normalsPointerPair = &tokenPointerArray[ token++ ];
   if ( numNormals == numPoints ) {
-    normalsPointerPair.set( "N", rNormal, false, numPoints );
-    normalsPointerPair.setDetailType( rVertex );
+    normalsPointerPair->set( "N", rNormal, false, numPoints );
+    normalsPointerPair->setDetailType( rVertex );
   } else {
-    normalsPointerPair.set( "N", rNormal, false, numFaceVertices );
-    normalsPointerPair.setDetailType( rFaceVarying );
+    normalsPointerPair->set( "N", rNormal, false, numFaceVertices );
+    normalsPointerPair->setDetailType( rFaceVarying );
   }
 
-  std::vector<liqTokenPointer> UVSetsArray;
-
   if ( numSTs > 0 ) {
 
-    pVertexSTPointerPair = new liqTokenPointer;
+    pVertexSTPointerPair = &tokenPointerArray[ token++ ];
     pVertexSTPointerPair->set( "st", rFloat, false, numFaceVertices, 2 );
     pVertexSTPointerPair->setDetailType( rFaceVarying );
 
     if( liqglo_outputMeshUVs ) {
 
-      pFaceVertexSPointer = new liqTokenPointer;
+      pFaceVertexSPointer = &tokenPointerArray[ token++ ];
       pFaceVertexSPointer->set( "u", rFloat, false, true, false, numFaceVertices );
       pFaceVertexSPointer->setDetailType( rFaceVarying );
 
-      pFaceVertexTPointer = new liqTokenPointer;
+      pFaceVertexTPointer = &tokenPointerArray[ token++ ];
       pFaceVertexTPointer->set( "v", rFloat, false, true, false, numFaceVertices );
       pFaceVertexTPointer->setDetailType( rFaceVarying );
 
     }
 
+    pUVSetsPointers = &tokenPointerArray[ token ];
     for ( unsigned j=0; j<extraUVSetNames.length(); j++) {
 
       MString setName = "u_" + extraUVSetNames[j];
-      pFaceVertexUPointer = new liqTokenPointer;
-      pFaceVertexUPointer->set( setName.asChar(), rFloat, false, true, false, numFaceVertices );
-      pFaceVertexUPointer->setDetailType( rFaceVarying );
+      tokenPointerArray[ token ].set( setName.asChar(), rFloat, false, true, false, numFaceVertices );
+      tokenPointerArray[ token++ ].setDetailType( rFaceVarying );
 
       setName = "v_" + extraUVSetNames[j];
-      pFaceVertexVPointer = new liqTokenPointer;
-      pFaceVertexVPointer->set( setName.asChar(), rFloat, false, true, false, numFaceVertices );
-      pFaceVertexVPointer->setDetailType( rFaceVarying );
-
-      UVSetsArray.push_back( *pFaceVertexUPointer );
-      UVSetsArray.push_back( *pFaceVertexVPointer );
+      tokenPointerArray[ token ].set( setName.asChar(), rFloat, false, true, false, numFaceVertices );
+      tokenPointerArray[ token++ ].setDetailType( rFaceVarying );
 
     }
 
   }
 
-  vertexParam = pointsPointerPair.getTokenFloatArray();
-  normalParam = normalsPointerPair.getTokenFloatArray();
+  vertexParam = pointsPointerPair->getTokenFloatArray();
+  normalParam = normalsPointerPair->getTokenFloatArray();
 
   // Read the mesh from Maya
   MFloatVectorArray normals;
@@ -219,13 +225,13 @@ liqRibMeshData::liqRibMeshData( MObject mesh )
       vertex = polyIt.vertexIndex( count );
       verts[faceVertex] = vertex;
       point = polyIt.point( count, MSpace::kObject );
-      pointsPointerPair.setTokenFloat( vertex, point.x, point.y, point.z );
+      pointsPointerPair->setTokenFloat( vertex, point.x, point.y, point.z );
       normal = polyIt.normalIndex( count );
 
       if( numNormals == numPoints ) {
-        normalsPointerPair.setTokenFloat( vertex, normals[normal].x, normals[normal].y, normals[normal].z );
+        normalsPointerPair->setTokenFloat( vertex, normals[normal].x, normals[normal].y, normals[normal].z );
       } else {
-        normalsPointerPair.setTokenFloat( faceVertex, normals[normal].x, normals[normal].y, normals[normal].z );
+        normalsPointerPair->setTokenFloat( faceVertex, normals[normal].x, normals[normal].y, normals[normal].z );
       }
 
       if( numSTs > 0 ) {
@@ -243,8 +249,8 @@ liqRibMeshData::liqRibMeshData( MObject mesh )
 
           fnMesh.getPolygonUV( face, count, S, T, &extraUVSetNames[j] );
 
-          (&UVSetsArray[2*j])->setTokenFloat( faceVertex, S );
-          (&UVSetsArray[2*j+1])->setTokenFloat( faceVertex, 1 - T );
+          pUVSetsPointers[2*j].setTokenFloat( faceVertex, S );
+          pUVSetsPointers[2*j+1].setTokenFloat( faceVertex, 1 - T );
 
         }
 
@@ -256,36 +262,16 @@ liqRibMeshData::liqRibMeshData( MObject mesh )
     ++face;
   }
 
-  // Add tokens to array and clean up after
-  tokenPointerArray.push_back( pointsPointerPair );
-  tokenPointerArray.push_back( normalsPointerPair );
-
-  if( pVertexSTPointerPair != NULL ) {
-    tokenPointerArray.push_back( *pVertexSTPointerPair );
-    delete pVertexSTPointerPair;
-  }
-
-  if( pFaceVertexSPointer != NULL ) {
-    tokenPointerArray.push_back( *pFaceVertexSPointer );
-    delete pFaceVertexSPointer;
-  }
-
-  if( pFaceVertexTPointer != NULL ) {
-    tokenPointerArray.push_back( *pFaceVertexTPointer );
-    delete pFaceVertexTPointer;
-  }
-
-  if( pFaceVertexUPointer != NULL && pFaceVertexVPointer != NULL ) {
-    for ( unsigned j=0; j<extraUVSetNames.length(); j++ ) {
-      tokenPointerArray.push_back( UVSetsArray[2*j] );
-      tokenPointerArray.push_back( UVSetsArray[2*j+1] );
-    }
-    delete pFaceVertexUPointer;
-    delete pFaceVertexVPointer;
+  // Simplified versions for RiDetailRange, either for all meshes or for
+  // the ones with a liqLOD attribute turned on
+  bool useLOD = liqglo_polygonLOD;
+  MPlug lodPlug = fnMesh.findPlug( "liqLOD", &astatus );
+  if ( astatus == MS::kSuccess ) lodPlug.getValue( useLOD );
+  if ( useLOD && !areaLight ) {
+    lod = liqMeshLOD::get( numPoints, numFaces, nverts, verts, vertexParam );
+    if ( lod->numLevels() == 0 ) lod = NULL;
   }
 
-  //delete &UVSetsArray;
-
   addAdditionalSurfaceParameters( mesh );
 }
 
@@ -298,8 +284,8 @@ liqRibMeshData::~liqRibMeshData()
 {
   LIQDEBUGPRINTF( "-> killing mesh\n" );
   //cerr <<"-> killing mesh"<<endl<<flush;
-  lfree( nverts ); nverts = NULL;
-  lfree( verts );  verts = NULL;
+  lafree( nverts ); nverts = NULL;
+  lafree( verts );  verts = NULL;
 }
 
 void liqRibMeshData::write()
@@ -342,6 +328,58 @@ void liqRibMeshData::write()
   } else cerr <<"Liquid : skipping degenerate mesh output..."<<endl<<flush;
 }
 
+unsigned liqRibMeshData::detailLevels() const
+//
+//  Description:
+//      the full mesh and its decimated levels
+//
+{
+  return ( lod != NULL )? 1 + lod->numLevels() : 1;
+}
+
+void liqRibMeshData::detailRange( unsigned level, RtFloat fullDetailArea, RtFloat range[4] ) const
+{
+  lod->detailRange( level, fullDetailArea, range );
+}
+
+void liqRibMeshData::writeDetailLevel( unsigned level )
+//
+//  Description:
+//      Write the RIB for one of the decimated levels of this mesh
+//
+{
+  if ( level == 0 || lod == NULL ) {
+    write();
+    return;
+  }
+
+  LIQDEBUGPRINTF( "-> writing mesh detail level\n" );
+  const liqMeshLOD::level &lev = lod->getLevel( level - 1 );
+
+  // the mesh goes out in every job that sees it, remap its primvars once
+  if ( levelTokens.size() != lod->numLevels() ) levelTokens.resize( lod->numLevels() );
+  std::vector<liqTokenPointer> &levelTokenArray = levelTokens[ level - 1 ];
+  if ( levelTokenArray.size() != tokenPointerArray.size() ) {
+    levelTokenArray.resize( tokenPointerArray.size() );
+    for ( unsigned t = 0; t < tokenPointerArray.size(); ++t ) {
+      lod->remap( level - 1, tokenPointerArray[t], levelTokenArray[t] );
+    }
+  }
+
+  unsigned levelFaces = lev.nverts.size();
+  RtInt * nloops = (RtInt*)alloca( sizeof( RtInt ) * levelFaces );
+  for ( unsigned i = 0; i < levelFaces; ++i ) {
+    nloops[i] = 1;
+  }
+
+  unsigned numTokens = levelTokenArray.size();
+  RtToken *tokenArray = (RtToken *)alloca( sizeof(RtToken) * numTokens );
+  RtPointer *pointerArray = (RtPointer *)alloca( sizeof(RtPointer) * numTokens );
+
+  assignTokenArraysV( &levelTokenArray, tokenArray, pointerArray );
+  RiPointsGeneralPolygonsV( levelFaces, nloops, (RtInt*)&lev.nverts[0], (RtInt*)&lev.verts[0], numTokens, tokenArray, pointerArray );
+}
+
 bool liqRibMeshData::compare( const liqRibData & otherObj ) const
 //
 //  Description:
@@ -396,6 +434,30 @@ bool liqRibMeshData::compare( const liqRibData & otherObj ) const
   return true;
 }
 
+bool liqRibMeshData::hash( liqHash &h ) const
+//
+//  Description:
+//      Add the mesh to a fingerprint
+//
+{
+  hashTokens( h );
+  h.add( ( int )numFaces );
+  h.add( ( int )numPoints );
+  unsigned numFaceVertices = 0;
+  for ( unsigned i = 0; i < numFaces; ++i ) numFaceVertices += nverts[i];
+  h.add( nverts, sizeof( RtInt ) * numFaces );
+  h.add( verts, sizeof( RtInt ) * numFaceVertices );
+  h.add( ( int )areaLight );
+  if ( areaLight ) {
+    h.add( name );
+    h.add( areaIntensity );
+    h.add( transformationMatrix, sizeof( RtMatrix ) );
+  }
+  // the levels only depend on what is hashed above
+  h.add( ( int )( lod != NULL ) );
+  return true;
+}
+
 ObjectType liqRibMeshData::type() const
 //
 //  Description:
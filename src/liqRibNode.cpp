@@ -92,6 +92,8 @@ liqRibNode::liqRibNode( liqRibNode * instanceOfNode,
 
   name.clear();
   mayaMatteMode             = false;
+  hasWorldBound             = false;
+  noCull                    = false;
 
   shading.shadingRate       = -1.0f;
   shading.diceRasterOrient  = true;
@@ -286,6 +288,13 @@ void liqRibNode::set( const MDagPath &path, int sample, ObjectType objType, int
         }
       }
 
+      if ( !noCull ) {
+        status.clear();
+        nPlug = nodePeeker.findPlug( MString( "liqNoCull" ), &status );
+        if ( status == MS::kSuccess )
+          nPlug.getValue( noCull );
+      }
+
       // trace group ----------------------------------------------------------
       if ( trace.sampleMotion == false ) {
         status.clear();
@@ -729,8 +738,10 @@ void liqRibNode::set( const MDagPath &path, int sample, ObjectType objType, int
 
   while( dagSearcher.length() > 0 );
 
-  // Raytracing Sets membership handling
-  if ( grouping.membership == "" ) {
+  // Raytracing Sets membership handling, objects of a liqNoCull set are
+  // never culled either
+  bool membership = grouping.membership == "";
+  if ( membership || !noCull ) {
     MObjectArray setArray;
     MGlobal::getAssociatedSets( hierarchy, setArray );
 
@@ -738,7 +749,7 @@ void liqRibNode::set( const MDagPath &path, int sample, ObjectType objType, int
       MFnDependencyNode depNodeFn( setArray[ i ] );
       status.clear();
       MPlug plug = depNodeFn.findPlug( "liqTraceSet", &status );
-      if ( status == MS::kSuccess ) {
+      if ( membership && status == MS::kSuccess ) {
         bool value = false;
         plug.getValue( value );
 
@@ -747,6 +758,13 @@ void liqRibNode::set( const MDagPath &path, int sample, ObjectType objType, int
           grouping.membership += " +" + depNodeFn.name( &status );
         }
       }
+      status.clear();
+      plug = depNodeFn.findPlug( "liqNoCull", &status );
+      if ( status == MS::kSuccess ) {
+        bool value = false;
+        plug.getValue( value );
+        if ( value ) noCull = true;
+      }
     }
 
     status.clear();
@@ -909,7 +927,7 @@ void liqRibNode::set( const MDagPath &path, int sample, ObjectType objType, int
   LIQDEBUGPRINTF( "-> creating rib object for given path\n");
 
   MObject obj = path.node();
-  liqRibObj *no = new liqRibObj( path, objType );
+  liqRibObj *no = new liqRibObj( path, objType, ( sample > 0 )? objects[ 0 ] : NULL );
   LIQDEBUGPRINTF( "-> creating rib object for reference\n");
   no->ref();
 
@@ -929,6 +947,22 @@ void liqRibNode::set( const MDagPath &path, int sample, ObjectType objType, int
     name += "RIBGEN";
   }
 
+  // object and world bounds of the shape over the shutter, only for the
+  // geometry that doesn't reach past its Maya bounding box
+  if ( sample == 0 ) {
+    hasWorldBound = ( objType == MRT_Mesh || objType == MRT_Nurbs || objType == MRT_Subdivision || objType == MRT_MayaSubdivision );
+  }
+  if ( hasWorldBound ) {
+    MBoundingBox sampleBound = fnNode.boundingBox( &status );
+    if ( status == MS::kSuccess ) {
+      if ( sample == 0 ) objectBound = sampleBound;
+      else objectBound.expand( sampleBound );
+      sampleBound.transformUsing( path.inclusiveMatrix() );
+      if ( sample == 0 ) worldBound = sampleBound;
+      else worldBound.expand( sampleBound );
+    } else hasWorldBound = false;
+  }
+
   LIQDEBUGPRINTF( "-> inserting object into ribnode's obj sample table\n" );
   if ( objects[ sample ] == NULL ) {
     objects[ sample ] = no;
@@ -1292,3 +1326,104 @@ bool liqRibNode::hasNObjects( unsigned n )
   }
   return true;
 }
+
+static bool hasRibString( const MString &value )
+{
+  return value != "" && value != "-";
+}
+
+static void hashColor( liqHash &h, const MColor &color )
+{
+  h.add( color.r );
+  h.add( color.g );
+  h.add( color.b );
+  h.add( color.a );
+}
+
+/**
+ * Adds what the translator writes for this node to a fingerprint. Archives,
+ * generators and ribgens bring in RIB that isn't known before rendering.
+ */
+bool liqRibNode::hash( liqHash &h )
+{
+  if ( hasRibGenAttr || hasRibString( rib.generator ) || hasRibString( shadowRib.generator ) ||
+       hasRibString( rib.readArchive ) || hasRibString( rib.delayedReadArchive ) ||
+       hasRibString( shadowRib.readArchive ) || hasRibString( shadowRib.delayedReadArchive ) ) return false;
+
+  h.add( name );
+  h.add( instanceStr );
+  h.add( ( int )matXForm );
+  h.add( ( int )bodyXForm );
+  int instance = DagPath.instanceNumber();
+  for ( unsigned i = 0; i < LIQMAXMOTIONSAMPLES && objects[i] != NULL; i++ ) {
+    if ( !objects[i]->hash( h, instance ) ) return false;
+  }
+
+  hashColor( h, color );
+  hashColor( h, opacity );
+  h.add( ( int )mayaMatteMode );
+  h.add( ( int )doubleSided );
+  h.add( ( int )reversedNormals );
+  h.add( shaderName );
+  h.add( dispName );
+  h.add( volumeName );
+  h.add( ( int )overrideColor );
+  h.add( ( int )doDef );
+  h.add( ( int )doMotion );
+  h.add( ( int )invisible );
+  h.add( ( int )ignoreShapes );
+  h.add( ( int )instanceInheritPPColor );
+  for ( unsigned i = 0; i < ignoredLightBits.size(); i++ ) h.add( ( int )ignoredLightBits[i] );
+
+  h.add( shading.shadingRate );
+  h.add( ( int )shading.diceRasterOrient );
+  hashColor( h, shading.color );
+  hashColor( h, shading.opacity );
+  h.add( shading.matte );
+  h.add( ( int )trace.sampleMotion );
+  h.add( ( int )trace.displacements );
+  h.add( trace.bias );
+  h.add( trace.maxDiffuseDepth );
+  h.add( trace.maxSpecularDepth );
+  h.add( ( int )visibility.camera );
+  h.add( ( int )visibility.trace );
+  h.add( ( int )visibility.diffuse );
+  h.add( ( int )visibility.specular );
+  h.add( ( int )visibility.photon );
+  h.add( ( int )visibility.midpoint );
+  h.add( ( int )visibility.newtransmission );
+  h.add( ( int )visibility.transmission );
+  h.add( ( int )hitmode.camera );
+  h.add( ( int )hitmode.diffuse );
+  h.add( ( int )hitmode.specular );
+  h.add( ( int )hitmode.transmission );
+  h.add( irradiance.shadingRate );
+  h.add( irradiance.nSamples );
+  h.add( irradiance.maxError );
+  h.add( irradiance.maxPixelDist );
+  h.add( irradiance.handle );
+  h.add( ( int )irradiance.fileMode );
+  h.add( photon.globalMap );
+  h.add( photon.causticMap );
+  h.add( ( int )photon.shadingModel );
+  h.add( photon.estimator );
+  h.add( ( int )motion.transformationBlur );
+  h.add( ( int )motion.deformationBlur );
+  h.add( motion.samples );
+  h.add( motion.factor );
+  h.add( rib.box );
+  h.add( shadowRib.box );
+  h.add( grouping.membership );
+  h.add( delight.subSurface.groupName );
+  hashColor( h, delight.subSurface.scattering );
+  hashColor( h, delight.subSurface.absorption );
+  h.add( delight.subSurface.refraction );
+  h.add( delight.subSurface.scale );
+  h.add( delight.subSurface.shadingRate );
+  h.add( ( int )subdivMesh.render );
+  h.add( ( int )subdivMesh.interpBounday );
+  h.add( ( int )subdivMesh.edgeCreasing );
+  h.add( ( int )curve.render );
+  h.add( curve.constantwidth );
+  return true;
+}
@@ -70,10 +70,10 @@ liqRibNuCurveData::liqRibNuCurveData( MObject curve )
 	// Extract the order and number of CVs in the surface keeping
 	// in mind that UV order is switched between Renderman and Maya
 	ncurves = 1;  //RiNuCurves can be passed many curves but right now it only passes one from maya at a time
-	nverts = (RtInt*)lmalloc( sizeof( RtInt ) * ( ncurves ) );
-	order = (RtInt*)lmalloc( sizeof( RtInt ) * ( ncurves ) );
-	min = (RtFloat*)lmalloc( sizeof( RtFloat ) * ( ncurves ) );
-	max = (RtFloat*)lmalloc( sizeof( RtFloat ) * ( ncurves ) );
+	nverts = (RtInt*)lamalloc( sizeof( RtInt ) * ( ncurves ) );
+	order = (RtInt*)lamalloc( sizeof( RtInt ) * ( ncurves ) );
+	min = (RtFloat*)lamalloc( sizeof( RtFloat ) * ( ncurves ) );
+	max = (RtFloat*)lamalloc( sizeof( RtFloat ) * ( ncurves ) );
 
 	order[0] = nurbs.degree() + 1;
 	nverts[0] = nurbs.numCVs() + 4;
@@ -102,7 +102,7 @@ liqRibNuCurveData::liqRibNuCurveData( MObject curve )
 	// Allocate CV and knot storage
 	//
 //	CVs   = (RtFloat*)lmalloc( sizeof( RtFloat ) * ( nverts[0] * 4 ) );
-	CVs   = (RtFloat*)lmalloc( sizeof( RtFloat ) * ( nverts[0] * 3 ) );
+	CVs   = (RtFloat*)lamalloc( sizeof( RtFloat ) * ( nverts[0] * 3 ) );
 //	knot = (RtFloat*)lmalloc( sizeof( RtFloat ) * ( Knots.length() + 2 ) );
 
 /*  unsigned k;
@@ -146,13 +146,13 @@ liqRibNuCurveData::liqRibNuCurveData( MObject curve )
 	*cvPtr = (RtFloat)pt.y; cvPtr++;
 	*cvPtr = (RtFloat)pt.z; cvPtr++;
 
-	liqTokenPointer pointsPointerPair;
 	liqTokenPointer* pConstWidthPointerPair = NULL;
 
+	tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+	liqTokenPointer &pointsPointerPair = tokenPointerArray.back();
 	pointsPointerPair.set( "P", rPoint, false, true, false, nverts[0] );
 	pointsPointerPair.setDetailType( rVertex );
 	pointsPointerPair.setTokenFloats( CVs );
-	tokenPointerArray.push_back( pointsPointerPair );
 
 	// Constant width, MToor style - Paul
 	MPlug curveWidthPlug = nurbs.findPlug( "liquidCurveWidth", &status );
@@ -160,7 +160,8 @@ liqRibNuCurveData::liqRibNuCurveData( MObject curve )
 	if ( status == MS::kSuccess ) {
 		float curveWidth;
 		curveWidthPlug.getValue( curveWidth );
-		pConstWidthPointerPair = new liqTokenPointer;
+		tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+		pConstWidthPointerPair = &tokenPointerArray.back();
 #ifndef DELIGHT
 		pConstWidthPointerPair->set( "constantwidth", rFloat, false, false, false, 0 );
 		pConstWidthPointerPair->setDetailType( rUniform );
@@ -172,8 +173,6 @@ liqRibNuCurveData::liqRibNuCurveData( MObject curve )
 			pConstWidthPointerPair->setTokenFloat( i, curveWidth );
 		}
 #endif
-		tokenPointerArray.push_back( *pConstWidthPointerPair );
-		delete pConstWidthPointerPair;
 
 	}
 
@@ -190,12 +189,12 @@ liqRibNuCurveData::~liqRibNuCurveData()
 	// if ( knot != NULL ) { lfree( knot ); knot = NULL; }
 	// this is freed with the ribdata destructor
 	// this is not true anymore
-	if ( CVs != NULL ) { lfree( CVs ); CVs = NULL; }
-	if ( NuCurveWidth != NULL ) { lfree( NuCurveWidth ); NuCurveWidth = NULL; }
-	if ( nverts != NULL ) { lfree( nverts ); nverts = NULL; }
-	if ( order != NULL ) { lfree( order ); order = NULL; }
-	if ( min != NULL ) { lfree( min ); min = NULL; }
-	if ( max != NULL ) { lfree( max ); max = NULL; }
+	if ( CVs != NULL ) { lafree( CVs ); CVs = NULL; }
+	if ( NuCurveWidth != NULL ) { lafree( NuCurveWidth ); NuCurveWidth = NULL; }
+	if ( nverts != NULL ) { lafree( nverts ); nverts = NULL; }
+	if ( order != NULL ) { lafree( order ); order = NULL; }
+	if ( min != NULL ) { lafree( min ); min = NULL; }
+	if ( max != NULL ) { lafree( max ); max = NULL; }
 }
 
 void liqRibNuCurveData::write()
@@ -249,6 +248,18 @@ bool liqRibNuCurveData::compare( const liqRibData & otherObj ) const
   return true;
 }
 
+bool liqRibNuCurveData::hash( liqHash &h ) const
+//
+//  Description:
+//      Add the curve to a fingerprint
+//
+{
+  hashTokens( h );
+  h.add( ( int )ncurves );
+  h.add( nverts, sizeof( RtInt ) * ncurves );
+  return true;
+}
+
 ObjectType liqRibNuCurveData::type() const
 //
 //  Description:
@@ -67,10 +67,12 @@ extern int debugMode;
 extern bool liqglo_useMtorSubdiv;
 
 
-liqRibObj::liqRibObj( const MDagPath &path, ObjectType objType )
+liqRibObj::liqRibObj( const MDagPath &path, ObjectType objType, const liqRibObj *firstSample )
 //
 //  Description:
 //      Create a RIB representation of the given node in the DAG as a ribgen!
+//      firstSample is the shutter open sample when this is a later motion
+//      sample, some geometry can share data with it.
 //
 : instanceMatrices( NULL ),
   objectHandle( NULL ),
@@ -137,6 +139,10 @@ liqRibObj::liqRibObj( const MDagPath &path, ObjectType objType )
     // don't bother storing it if it's not going to be visible!
     LIQDEBUGPRINTF( "-> about to create rep\n");
 
+    // geometry buffers live until the hash table goes away
+    larenaScope arena;
+    lmemCategory category( obj.apiTypeStr() );
+
     if ( !ignore || !ignoreShadow ) {
       if ( objType == MRT_RibGen ) {
         type = MRT_RibGen;
@@ -160,7 +166,8 @@ liqRibObj::liqRibObj( const MDagPath &path, ObjectType objType )
           else data = new liqRibCustomNode( skip, customNode );
         } else if ( obj.hasFn(MFn::kNurbsSurface) ) {
           type = MRT_Nurbs;
-          if ( !ignoreShapes ) data = new liqRibSurfaceData( obj );
+          const liqRibSurfaceData *firstSurface = ( firstSample && firstSample->type == MRT_Nurbs )? ( const liqRibSurfaceData* )firstSample->data : NULL;
+          if ( !ignoreShapes ) data = new liqRibSurfaceData( obj, firstSurface );
           else data = new liqRibSurfaceData( skip );
         } else if ( obj.hasFn(MFn::kSubdiv) ) {
           type = MRT_Subdivision;
@@ -294,6 +301,15 @@ RtLightHandle liqRibObj::lightHandle() const
   return lHandle;
 }
 
+liqRibGenData *liqRibObj::ribGenData() const
+//
+//  Description:
+//      return the ribgen of this object, NULL if it isn't one
+//
+{
+  return ( type == MRT_RibGen )? (liqRibGenData*)data : NULL;
+}
+
 AnimType liqRibObj::compareMatrix(const liqRibObj *o, int instance )
 //
 //  Description:
@@ -326,7 +342,7 @@ AnimType liqRibObj::compareBody(const liqRibObj *o)
   return cmp;
 }
 
-void liqRibObj::writeObject()
+void liqRibObj::writeObject( unsigned detailLevel )
 //
 //  Description:
 //      write the object directly.  We do not get a RIB handle in this case
@@ -343,11 +359,29 @@ void liqRibObj::writeObject()
           surfData->writeTrimCurves();
         }
       }
-      data->write();
+      data->writeDetailLevel( detailLevel );
     }
   }
 }
 
+unsigned liqRibObj::detailLevels() const
+//
+//  Description:
+//      number of RiDetailRange levels the geometry can be written at
+//
+{
+  return ( NULL != data && MRT_Light != type )? data->detailLevels() : 1;
+}
+
+void liqRibObj::detailRange( unsigned detailLevel, RtFloat fullDetailArea, RtFloat range[4] ) const
+//
+//  Description:
+//      screen area range of the given level, for RiDetailRange
+//
+{
+  data->detailRange( detailLevel, fullDetailArea, range );
+}
+
 MMatrix liqRibObj::matrix( int instance ) const
 //
 //  Description:
@@ -358,6 +392,20 @@ MMatrix liqRibObj::matrix( int instance ) const
   return instanceMatrices[instance];
 }
 
+bool liqRibObj::hash( liqHash &h, int instance ) const
+//
+//  Description:
+//      add this sample of the object to a fingerprint
+//
+{
+  h.add( type );
+  h.add( ( int )ignore );
+  h.add( ( int )ignoreShadow );
+  h.add( ( int )ignoreShapes );
+  h.add( matrix( instance ) );
+  return data == NULL || data->hash( h );
+}
+
 void liqRibObj::setMatrix( int instance, MMatrix matrix )
 {
   assert(instance>=0);
@@ -50,6 +50,7 @@ extern "C" {
 // Maya's Headers
 #include <maya/MFnVectorArrayData.h>
 #include <maya/MFnDoubleArrayData.h>
+#include <maya/MFnTypedAttribute.h>
 #include <maya/MPlug.h>
 #include <maya/MVectorArray.h>
 #include <maya/MFloatArray.h>
@@ -61,6 +62,7 @@ extern "C" {
 #include <liquid.h>
 #include <liqRibParticleData.h>
 #include <liqGlobalHelpers.h>
+#include <liqRenderer.h>
 
 extern int debugMode;
 
@@ -69,6 +71,10 @@ extern liquidlong liqglo_motionSamples;
 extern bool liqglo_doDef;
 extern bool liqglo_doMotion;
 extern structJob liqglo_currentJob;
+extern liqRenderer liquidRenderer;
+extern bool liqglo_useParticleCache;
+extern MString liqglo_particleCacheDir;
+extern MString liqglo_projectDir;
 
 
 // these classes are needed to produce a list of particles sorted by their ids
@@ -113,6 +119,7 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
 //
 {
   LIQDEBUGPRINTF( "-> creating particles\n");
+  m_spheresAsPoints = false;
   MStatus status = MS::kSuccess;
   MFnParticleSystem  fnNode;
   fnNode.setObject( partobj );
@@ -124,14 +131,25 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
 
   LIQDEBUGPRINTF( "-> Reading Particle Count\n");
 
-  // first get the particle position data
-  MPlug  posPlug = fnNode.findPlug( "position", &status );
-  MObject  posObject;
-
-  posPlug.getValue( posObject );
+  MTime exportTime = MAnimControl::currentTime();
+
+  // if the particles were cached to disk we read their state from there
+  // rather than asking Maya to run the dynamics up to this frame
+  m_haveCache = false;
+  MString cacheDir;
+  if ( liqglo_useParticleCache ) {
+    cacheDir = liqglo_particleCacheDir;
+    if ( cacheDir == "" ) cacheDir = "particles/" + liquidTransGetSceneName();
+    if ( cacheDir.index( '/' ) != 0 && cacheDir.index( ':' ) != 1 ) cacheDir = liqglo_projectDir + cacheDir;
+    m_haveCache = m_cache.load( cacheDir, fnNode.particleName(), exportTime );
+    if ( !m_haveCache ) {
+      MGlobal::displayWarning( "Liquid : no particle disk cache for " + fnNode.particleName() + " in " + cacheDir + ", reading the particle node instead." );
+    }
+  }
 
-  MFnVectorArrayData posArray( posObject, &status );
-  status.clear();
+  // first get the particle position data
+  MVectorArray posArray;
+  getVectorArray( fnNode, "position", posArray );
 
   m_numParticles = posArray.length();
 
@@ -156,7 +174,6 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
   {
     MTime shutterOpen ( (double)liqglo_sampleTimes[0], MTime::uiUnit() );
     MTime shutterClose ( (double)liqglo_sampleTimes[liqglo_motionSamples - 1], MTime::uiUnit() );
-    MTime exportTime = MAnimControl::currentTime();
 
 
 #ifdef _WIN32
@@ -173,73 +190,101 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
 
 #endif
 
-    bool isCaching;
-    MPlug cachePlug = fnNode.findPlug( "cacheData", &status );
-    cachePlug.getValue( isCaching );
-    status.clear();
-    if ( !isCaching && ( exportTime == shutterOpen ) )
+    if ( m_haveCache )
     {
-      MGlobal::displayWarning( fnNode.particleName() + " has Cache Data switched off! Exported motion blur information will likely be wrong." );
-    }
+      // the disk cache gives us both shutter times without moving the scene
+      liqParticleCache shutterCache;
+      MDoubleArray idArray;
+      unsigned i;
 
-    // Shutter open
-    //
-    {
-      if ( exportTime != shutterOpen )
+      if ( shutterCache.load( cacheDir, fnNode.particleName(), shutterOpen ) &&
+           shutterCache.getDoubleArray( "id", idArray ) )
       {
-        MGlobal::viewFrame( shutterOpen );
+        for ( i = 0; i < idArray.length(); i++ ) soParticles[static_cast<int>(idArray[i])] = 1;
       }
-      fnNode.setObject(partobj);
-      idPlug = fnNode.findPlug( "id", &status );
-      idPlug.getValue( idObject );
-      MFnDoubleArrayData idArray( idObject, &status );
-      for ( int i = 0; i < idArray.length(); i++ )
+      if ( shutterCache.load( cacheDir, fnNode.particleName(), shutterClose ) &&
+           shutterCache.getDoubleArray( "id", idArray ) )
       {
-        soParticles[static_cast<int>(idArray[i])] = 1;
+        for ( i = 0; i < idArray.length(); i++ ) scParticles[static_cast<int>(idArray[i])] = 1;
+      }
+      getDoubleArray( fnNode, "id", idArray );
+      for ( i = 0; i < idArray.length(); i++ )
+      {
+        if ( soParticles[static_cast<int>(idArray[i])] == 1 &&
+           scParticles[static_cast<int>(idArray[i])] == 1 )
+        {
+          particlesForSorting.push_back(new liq_particleInfo(i, static_cast<int>(idArray[i])));
+        }
       }
     }
-
-    // Shutter close
-    //
+    else
     {
-      MGlobal::viewFrame( shutterClose );
-      fnNode.setObject(partobj);
-      idPlug = fnNode.findPlug( "id", &status );
-      idPlug.getValue( idObject );
-      MFnDoubleArrayData idArray( idObject, &status );
-      for ( int i = 0; i < idArray.length(); i++ )
+      bool isCaching;
+      MPlug cachePlug = fnNode.findPlug( "cacheData", &status );
+      cachePlug.getValue( isCaching );
+      status.clear();
+      if ( !isCaching && ( exportTime == shutterOpen ) )
       {
-        scParticles[static_cast<int>(idArray[i])] = 1;
+        MGlobal::displayWarning( fnNode.particleName() + " has Cache Data switched off! Exported motion blur information will likely be wrong." );
       }
-    }
 
-    // Export time
-    //
-    {
-      if ( exportTime != shutterClose )
+      // Shutter open
+      //
+      {
+        if ( exportTime != shutterOpen )
+        {
+          MGlobal::viewFrame( shutterOpen );
+        }
+        fnNode.setObject(partobj);
+        idPlug = fnNode.findPlug( "id", &status );
+        idPlug.getValue( idObject );
+        MFnDoubleArrayData idArray( idObject, &status );
+        for ( int i = 0; i < idArray.length(); i++ )
+        {
+          soParticles[static_cast<int>(idArray[i])] = 1;
+        }
+      }
+
+      // Shutter close
+      //
       {
-        MGlobal::viewFrame( exportTime );
+        MGlobal::viewFrame( shutterClose );
+        fnNode.setObject(partobj);
+        idPlug = fnNode.findPlug( "id", &status );
+        idPlug.getValue( idObject );
+        MFnDoubleArrayData idArray( idObject, &status );
+        for ( int i = 0; i < idArray.length(); i++ )
+        {
+          scParticles[static_cast<int>(idArray[i])] = 1;
+        }
       }
-      fnNode.setObject(partobj);
-      idPlug = fnNode.findPlug( "id", &status );
-      idPlug.getValue( idObject );
-      MFnDoubleArrayData idArray( idObject, &status );
-      for ( int i = 0; i < idArray.length(); i++ )
+
+      // Export time
+      //
       {
-        if ( soParticles[static_cast<int>(idArray[i])] == 1 &&
-           scParticles[static_cast<int>(idArray[i])] == 1 )
+        if ( exportTime != shutterClose )
         {
-          particlesForSorting.push_back(new liq_particleInfo(i, static_cast<int>(idArray[i])));
+          MGlobal::viewFrame( exportTime );
+        }
+        fnNode.setObject(partobj);
+        idPlug = fnNode.findPlug( "id", &status );
+        idPlug.getValue( idObject );
+        MFnDoubleArrayData idArray( idObject, &status );
+        for ( int i = 0; i < idArray.length(); i++ )
+        {
+          if ( soParticles[static_cast<int>(idArray[i])] == 1 &&
+             scParticles[static_cast<int>(idArray[i])] == 1 )
+          {
+            particlesForSorting.push_back(new liq_particleInfo(i, static_cast<int>(idArray[i])));
+          }
         }
       }
     }
   }
   else
   {
-    fnNode.setObject(partobj);
-    idPlug = fnNode.findPlug( "id", &status );
-    idPlug.getValue( idObject );
-    MFnDoubleArrayData idArray( idObject, &status );
+    MDoubleArray idArray;
+    getDoubleArray( fnNode, "id", idArray );
     for ( int i = 0; i < idArray.length(); i++ )
     {
       particlesForSorting.push_back(new liq_particleInfo(i, static_cast<int>(idArray[i])));
@@ -289,10 +334,8 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
 
   // Get the velocity information (used for streak, multi-streak).
   //
-  MPlug velPlug = fnNode.findPlug( "velocity", &status );
-  MObject velObject;
-  velPlug.getValue( velObject );
-  MFnVectorArrayData velArray( velObject, &status );
+  MVectorArray velArray;
+  getVectorArray( fnNode, "velocity", velArray );
 
   // Check for the tail size parameter (only for streak, multi-streak).
   //
@@ -318,22 +361,11 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
   LIQDEBUGPRINTF( "-> Reading Particle Radius\n");
 
   MDoubleArray radiusArray;
-  MPlug  radiusPPPlug = fnNode.findPlug( "radiusPP", &status );
-  bool  haveRadiusArray = false;
   float  radius = 1.0;
 
   // check if there's a per-particle radius attribute
-  if ( status == MS::kSuccess ) {
-    MObject radiusPPObject;
-
-    radiusPPPlug.getValue( radiusPPObject );
-
-    MFnDoubleArrayData radiusArrayData( radiusPPObject, &status );
-
-    radiusArray = radiusArrayData.array();
-
-    haveRadiusArray = true;
-  } else {
+  bool  haveRadiusArray = getDoubleArray( fnNode, "radiusPP", radiusArray );
+  if ( !haveRadiusArray ) {
     // no per-particle radius. Try for a global radius
 
     MPlug radiusPlug = fnNode.findPlug( "radius", &status );
@@ -366,20 +398,7 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
   LIQDEBUGPRINTF( "-> Reading Particle Color\n");
 
   MVectorArray rgbArray;
-  MPlug  rgbPPPlug = fnNode.findPlug( "rgbPP", &status );
-  bool  haveRgbArray = false;
-
-  if ( status == MS::kSuccess ) {
-    MObject rgbPPObject;
-
-    rgbPPPlug.getValue( rgbPPObject );
-
-    MFnVectorArrayData rgbArrayData( rgbPPObject, &status );
-
-    rgbArray = rgbArrayData.array();
-
-    haveRgbArray = true;
-  }
+  bool  haveRgbArray = getVectorArray( fnNode, "rgbPP", rgbArray );
 
   status.clear();
 
@@ -388,17 +407,7 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
   LIQDEBUGPRINTF( "-> Reading Particle Opacity\n");
 
   MDoubleArray opacityArray;
-  MPlug  opacityPPPlug = fnNode.findPlug( "opacityPP", &status );
-  bool  haveOpacityArray = false;
-
-  if ( status == MS::kSuccess ) {
-    MObject opacityPPObject;
-    opacityPPPlug.getValue( opacityPPObject );
-    MFnDoubleArrayData opacityArrayData( opacityPPObject, &status );
-
-    opacityArray = opacityArrayData.array();
-    haveOpacityArray = true;
-  }
+  bool  haveOpacityArray = getDoubleArray( fnNode, "opacityPP", opacityArray );
 
   status.clear();
 
@@ -482,33 +491,28 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
 
 
 
-  // 3Delight supports rendering RiPoints as spheres
+  // Renderers that can draw RiPoints as spheres get the whole system in
+  // one primitive. Everyone else falls back to one RiSphere per particle
+  // in write().
 
   case MPTSpheres:
   {
+    m_spheresAsPoints = liquidRenderer.supports_POINT_SPHERES;
 
-#ifdef DELIGHT
-
-    liqTokenPointer typeParameter;
-
-    typeParameter.set( "type", rString, false );
-
-    typeParameter.setTokenString( 0, "sphere", 6 );
-
-    tokenPointerArray.push_back( typeParameter );
-
-
-
-#else // Write real spheres
-    liqTokenPointer Pparameter;
-    liqTokenPointer radiusParameter;
+    unsigned token = tokenPointerArray.size();
+    tokenPointerArray.resize( token + 2 );
+    liqTokenPointer &Pparameter = tokenPointerArray[ token ];
+    liqTokenPointer &radiusParameter = tokenPointerArray[ token + 1 ];
 
     Pparameter.set( "P", rPoint, false, true, false, m_numValidParticles );
     Pparameter.setDetailType( rVertex );
 
-    radiusParameter.set("radius", rFloat, false, true, false, m_numValidParticles);
+    // RiPoints wants a diameter, the fallback path wants a radius
+    radiusParameter.set( m_spheresAsPoints ? "width" : "radius", rFloat, false, true, false, m_numValidParticles );
     radiusParameter.setDetailType( rVertex );
 
+    float radiusScale = m_spheresAsPoints ? 2.0 : 1.0;
+
     for ( unsigned part_num = 0;
         part_num < m_numValidParticles;
         part_num++ )
@@ -521,20 +525,21 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
       if(haveRadiusArray)
       {
         radiusParameter.setTokenFloat(part_num,
-                    radiusArray[m_validParticles[part_num]]);
+                    radiusArray[m_validParticles[part_num]] * radiusScale);
       }
       else
       {
-        radiusParameter.setTokenFloat(part_num, radius);
+        radiusParameter.setTokenFloat(part_num, radius * radiusScale);
       }
     }
 
-    tokenPointerArray.push_back( Pparameter );
-    tokenPointerArray.push_back(radiusParameter);
-
-
-#endif // #ifdef DELIGHT
-
+    if ( m_spheresAsPoints ) {
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &typeParameter = tokenPointerArray.back();
+      typeParameter.set( "type", rString, false );
+      typeParameter.setDetailType( rConstant );
+      typeParameter.setTokenString( 0, "sphere", 6 );
+    }
   }
   break;
 
@@ -544,7 +549,8 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
   case MPTPoints:
 
   {
-    liqTokenPointer Pparameter;
+    tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+    liqTokenPointer &Pparameter = tokenPointerArray.back();
 
     Pparameter.set( "P", rPoint, false, true, false, m_numValidParticles*m_multiCount );
 
@@ -588,13 +594,12 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
       }
     }
 
-    tokenPointerArray.push_back( Pparameter );
-
 
     // TODO: have we got to do some unit conversion here? what units
     // are the radii in?  What unit is Maya in?
     if (haveRadiusArray) {
-      liqTokenPointer widthParameter;
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &widthParameter = tokenPointerArray.back();
 
       widthParameter.set( "width",
                 rFloat,
@@ -612,11 +617,10 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
         widthParameter.setTokenFloat( part_num,
                         radiusArray[m_validParticles[part_num/m_multiCount]]*2);
       }
-
-      tokenPointerArray.push_back( widthParameter );
     } else {
 
-      liqTokenPointer constantwidthParameter;
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &constantwidthParameter = tokenPointerArray.back();
 
       constantwidthParameter.set("constantwidth",
                      rFloat,
@@ -626,8 +630,6 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
                      0);
       constantwidthParameter.setDetailType(rConstant);
       constantwidthParameter.setTokenFloat(0, radius*2);
-
-      tokenPointerArray.push_back( constantwidthParameter );
     }
   }
   break;
@@ -639,7 +641,8 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
     //
     m_multiCount *= 2;
 
-    liqTokenPointer Pparameter;
+    tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+    liqTokenPointer &Pparameter = tokenPointerArray.back();
     Pparameter.set( "P", rPoint, false, true, false, m_numValidParticles*m_multiCount );
 
     Pparameter.setDetailType( rVertex );
@@ -695,12 +698,12 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
                       posArray[ m_validParticles[ part_num ] ].z + rad * zDir );
       }
     }
-    tokenPointerArray.push_back( Pparameter );
 
     // TODO: have we got to do some unit conversion here? what units
     // are the radii in?  What unit is Maya in?
     if (haveRadiusArray) {
-      liqTokenPointer widthParameter;
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &widthParameter = tokenPointerArray.back();
 
       widthParameter.set( "width",
                           rFloat,
@@ -721,11 +724,10 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
         widthParameter.setTokenFloat( part_num,
                         radiusArray[m_validParticles[part_num/m_multiCount]]*2);
       }
-
-      tokenPointerArray.push_back( widthParameter );
     } else {
 
-      liqTokenPointer constantwidthParameter;
+      tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+      liqTokenPointer &constantwidthParameter = tokenPointerArray.back();
 
       constantwidthParameter.set( "constantwidth",
                                   rFloat,
@@ -735,8 +737,6 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
                                   0);
       constantwidthParameter.setDetailType(rConstant);
       constantwidthParameter.setTokenFloat(0, radius*2);
-
-      tokenPointerArray.push_back( constantwidthParameter );
     }
   }
   break;
@@ -744,42 +744,13 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
   case MPTSprites: {
 
 
-    liqTokenPointer Pparameter;
-    liqTokenPointer spriteNumParameter;
-    liqTokenPointer spriteTwistParameter;
-    liqTokenPointer spriteScaleXParameter;
-    liqTokenPointer spriteScaleYParameter;
-
-    Pparameter.set( "P", rPoint, false, true, false, m_numValidParticles );
-    Pparameter.setDetailType( rVertex );
-
-    spriteNumParameter.set("spriteNum", rFloat, false, true, false, m_numValidParticles);
-    spriteNumParameter.setDetailType( rUniform );
-
-    spriteTwistParameter.set("spriteTwist", rFloat, false, true, false, m_numValidParticles);
-    spriteTwistParameter.setDetailType( rUniform );
-
-    spriteScaleXParameter.set("spriteScaleX", rFloat, false, true, false, m_numValidParticles);
-    spriteScaleXParameter.setDetailType( rUniform );
-
-    spriteScaleYParameter.set("spriteScaleY", rFloat, false, true, false, m_numValidParticles);
-    spriteScaleYParameter.setDetailType( rUniform );
-
     bool haveSpriteNums = false;
-    bool haveSpriteNumsArray = false;
-    MObject      spriteNumObject;
-    MFnDoubleArrayData spriteNumArray;
+    MDoubleArray spriteNumArray;
     float        spriteNum;
-    MPlug        spriteNumPlug = fnNode.findPlug( "spriteNumPP", &status );
-    if ( status == MS::kSuccess )
-    {
-      haveSpriteNumsArray = true;
-      spriteNumPlug.getValue( spriteNumObject );
-      spriteNumArray.setObject( spriteNumObject );
-    }
-    else
+    bool haveSpriteNumsArray = getDoubleArray( fnNode, "spriteNumPP", spriteNumArray );
+    if ( !haveSpriteNumsArray )
     {
-      spriteNumPlug = fnNode.findPlug( "spriteNum", &status );
+      MPlug spriteNumPlug = fnNode.findPlug( "spriteNum", &status );
       if ( status == MS::kSuccess )
       {
         haveSpriteNums = true;
@@ -788,20 +759,12 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
     }
 
     bool haveSpriteTwist = false;
-    bool haveSpriteTwistArray = false;
-    MObject      spriteTwistObject;
-    MFnDoubleArrayData spriteTwistArray;
+    MDoubleArray spriteTwistArray;
     float        spriteTwist;
-    MPlug        spriteTwistPlug = fnNode.findPlug( "spriteTwistPP", &status );
-    if ( status == MS::kSuccess )
+    bool haveSpriteTwistArray = getDoubleArray( fnNode, "spriteTwistPP", spriteTwistArray );
+    if ( !haveSpriteTwistArray )
     {
-      haveSpriteTwistArray = true;
-      spriteTwistPlug.getValue( spriteTwistObject );
-      spriteTwistArray.setObject( spriteTwistObject );
-    }
-    else
-    {
-      spriteTwistPlug = fnNode.findPlug( "spriteTwist", &status );
+      MPlug spriteTwistPlug = fnNode.findPlug( "spriteTwist", &status );
       if ( status == MS::kSuccess )
       {
         haveSpriteTwist = true;
@@ -810,20 +773,12 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
     }
 
     bool haveSpriteScaleX = false;
-    bool haveSpriteScaleXArray = false;
-    MObject      spriteScaleXObject;
-    MFnDoubleArrayData spriteScaleXArray;
+    MDoubleArray spriteScaleXArray;
     float        spriteScaleX;
-    MPlug        spriteScaleXPlug = fnNode.findPlug( "spriteScaleXPP", &status );
-    if ( status == MS::kSuccess )
+    bool haveSpriteScaleXArray = getDoubleArray( fnNode, "spriteScaleXPP", spriteScaleXArray );
+    if ( !haveSpriteScaleXArray )
     {
-      haveSpriteScaleXArray = true;
-      spriteScaleXPlug.getValue( spriteScaleXObject );
-      spriteScaleXArray.setObject( spriteScaleXObject );
-    }
-    else
-    {
-      spriteScaleXPlug = fnNode.findPlug( "spriteScaleX", &status );
+      MPlug spriteScaleXPlug = fnNode.findPlug( "spriteScaleX", &status );
       if ( status == MS::kSuccess )
       {
         haveSpriteScaleX = true;
@@ -832,21 +787,12 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
     }
 
     bool haveSpriteScaleY = false;
-    bool haveSpriteScaleYArray = false;
-    MObject      spriteScaleYObject;
-    MFnDoubleArrayData spriteScaleYArray;
+    MDoubleArray spriteScaleYArray;
     float        spriteScaleY;
-    MPlug        spriteScaleYPlug = fnNode.findPlug( "spriteScaleYPP", &status );
-    if ( status == MS::kSuccess )
+    bool haveSpriteScaleYArray = getDoubleArray( fnNode, "spriteScaleYPP", spriteScaleYArray );
+    if ( !haveSpriteScaleYArray )
     {
-
-      haveSpriteScaleYArray = true;
-      spriteScaleYPlug.getValue( spriteScaleYObject );
-      spriteScaleYArray.setObject( spriteScaleYObject );
-    }
-    else
-    {
-      spriteScaleYPlug = fnNode.findPlug( "spriteScaleY", &status );
+      MPlug spriteScaleYPlug = fnNode.findPlug( "spriteScaleY", &status );
       if ( status == MS::kSuccess )
       {
         haveSpriteScaleY = true;
@@ -854,6 +800,45 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
       }
     }
 
+    // Only the sprite attributes the particles actually have are output,
+    // so count them before making room for the tokens
+    bool haveSpriteNumParameter    = haveSpriteNumsArray || haveSpriteNums;
+    bool haveSpriteTwistParameter  = haveSpriteTwistArray || haveSpriteTwist;
+    bool haveSpriteScaleXParameter = haveSpriteScaleXArray || haveSpriteScaleX;
+    bool haveSpriteScaleYParameter = haveSpriteScaleYArray || haveSpriteScaleY;
+    unsigned token = tokenPointerArray.size();
+    tokenPointerArray.resize( token + 1 + haveSpriteNumParameter + haveSpriteTwistParameter +
+                              haveSpriteScaleXParameter + haveSpriteScaleYParameter );
+
+    liqTokenPointer &Pparameter = tokenPointerArray[ token++ ];
+    liqTokenPointer *spriteNumParameter    = haveSpriteNumParameter    ? &tokenPointerArray[ token++ ] : NULL;
+    liqTokenPointer *spriteTwistParameter  = haveSpriteTwistParameter  ? &tokenPointerArray[ token++ ] : NULL;
+    liqTokenPointer *spriteScaleXParameter = haveSpriteScaleXParameter ? &tokenPointerArray[ token++ ] : NULL;
+    liqTokenPointer *spriteScaleYParameter = haveSpriteScaleYParameter ? &tokenPointerArray[ token++ ] : NULL;
+
+    Pparameter.set( "P", rPoint, false, true, false, m_numValidParticles );
+    Pparameter.setDetailType( rVertex );
+
+    if ( spriteNumParameter ) {
+      spriteNumParameter->set("spriteNum", rFloat, false, true, false, m_numValidParticles);
+      spriteNumParameter->setDetailType( rUniform );
+    }
+
+    if ( spriteTwistParameter ) {
+      spriteTwistParameter->set("spriteTwist", rFloat, false, true, false, m_numValidParticles);
+      spriteTwistParameter->setDetailType( rUniform );
+    }
+
+    if ( spriteScaleXParameter ) {
+      spriteScaleXParameter->set("spriteScaleX", rFloat, false, true, false, m_numValidParticles);
+      spriteScaleXParameter->setDetailType( rUniform );
+    }
+
+    if ( spriteScaleYParameter ) {
+      spriteScaleYParameter->set("spriteScaleY", rFloat, false, true, false, m_numValidParticles);
+      spriteScaleYParameter->setDetailType( rUniform );
+    }
+
 
     for ( unsigned part_num = 0;
         part_num < m_numValidParticles;
@@ -866,64 +851,45 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
                     posArray[m_validParticles[part_num]].z );
       if(haveSpriteNumsArray)
       {
-        spriteNumParameter.setTokenFloat(part_num,
+        spriteNumParameter->setTokenFloat(part_num,
                          spriteNumArray[m_validParticles[part_num]]);
       }
       else if(haveSpriteNums)
       {
-        spriteNumParameter.setTokenFloat(part_num, spriteNum);
+        spriteNumParameter->setTokenFloat(part_num, spriteNum);
       }
 
       if(haveSpriteTwistArray)
       {
-        spriteTwistParameter.setTokenFloat(part_num,
+        spriteTwistParameter->setTokenFloat(part_num,
                            spriteTwistArray[m_validParticles[part_num]]);
       }
       else if(haveSpriteTwist)
       {
-        spriteTwistParameter.setTokenFloat(part_num, spriteTwist);
+        spriteTwistParameter->setTokenFloat(part_num, spriteTwist);
       }
 
       if (haveSpriteScaleXArray)
       {
-        spriteScaleXParameter.setTokenFloat(part_num,
+        spriteScaleXParameter->setTokenFloat(part_num,
                           spriteScaleXArray[m_validParticles[part_num]]);
       }
       else if (haveSpriteScaleX)
       {
-        spriteScaleXParameter.setTokenFloat(part_num, spriteScaleX);
+        spriteScaleXParameter->setTokenFloat(part_num, spriteScaleX);
       }
 
       if (haveSpriteScaleYArray)
       {
-        spriteScaleYParameter.setTokenFloat(part_num,
+        spriteScaleYParameter->setTokenFloat(part_num,
                           spriteScaleYArray[m_validParticles[part_num]]);
       }
       else if (haveSpriteScaleY)
       {
-        spriteScaleYParameter.setTokenFloat(part_num, spriteScaleY);
+        spriteScaleYParameter->setTokenFloat(part_num, spriteScaleY);
       }
     }
 
-
-    tokenPointerArray.push_back( Pparameter );
-    if(haveSpriteNumsArray || haveSpriteNums)
-    {
-      tokenPointerArray.push_back( spriteNumParameter );
-    }
-    if(haveSpriteTwistArray || haveSpriteTwist)
-    {
-      tokenPointerArray.push_back( spriteTwistParameter );
-    }
-    if(haveSpriteScaleXArray || haveSpriteScaleX)
-    {
-      tokenPointerArray.push_back( spriteScaleXParameter );
-    }
-    if(haveSpriteScaleYArray || haveSpriteScaleY)
-    {
-      tokenPointerArray.push_back( spriteScaleYParameter );
-    }
-
   }
   break;
 
@@ -940,7 +906,8 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
   // else
   if (haveRgbArray)
   {
-    liqTokenPointer CsParameter;
+    tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+    liqTokenPointer &CsParameter = tokenPointerArray.back();
 
     CsParameter.set( "Cs", rColor, false, true, false, m_numValidParticles*m_multiCount );
     CsParameter.setDetailType( rVertex );
@@ -959,8 +926,6 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
                      rgbArray[m_validParticles[part_chunk]].y,
                      rgbArray[m_validParticles[part_chunk]].z );
     }
-
-    tokenPointerArray.push_back( CsParameter );
   }
 
 
@@ -968,7 +933,8 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
   //
   if (haveOpacityArray)
   {
-    liqTokenPointer OsParameter;
+    tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+    liqTokenPointer &OsParameter = tokenPointerArray.back();
 
     OsParameter.set( "Os", rColor, false, true, false, m_numValidParticles*m_multiCount );
     OsParameter.setDetailType( rVarying );
@@ -1000,10 +966,26 @@ liqRibParticleData::liqRibParticleData( MObject partobj )
                        opacityArray[m_validParticles[part_chunk]]);
       }
     }
-
-    tokenPointerArray.push_back( OsParameter );
   }
   addAdditionalParticleParameters( partobj );
+
+  // everything has been read, release the cache files
+  m_cache.clear();
+
+  // Sprites are written as one polygon per particle, so everything we
+  // collected per particle is per face ("uniform") on the sprite mesh.
+  if ( particleType == MPTSprites )
+  {
+    std::vector<liqTokenPointer>::iterator iter;
+    for ( iter = tokenPointerArray.begin(); iter != tokenPointerArray.end(); ++iter )
+    {
+      if ( strcmp( iter->getTokenName(), "P" ) &&
+           ( iter->getDetailType() == rVertex || iter->getDetailType() == rVarying ) )
+      {
+        iter->setDetailType( rUniform );
+      }
+    }
+  }
 }
 
 liqRibParticleData::~liqRibParticleData()
@@ -1061,13 +1043,6 @@ void liqRibParticleData::write()
 
   case MPTMultiPoint:
   case MPTPoints:
-
-#ifdef DELIGHT
-
-  case MPTSpheres:
-
-#endif
-
   {
     assignTokenArraysV( &tokenPointerArray, tokenArray, pointerArray );
     RiPointsV( m_numValidParticles*m_multiCount, numTokens, tokenArray, pointerArray );
@@ -1088,15 +1063,21 @@ void liqRibParticleData::write()
   break;
 
 
-#ifndef DELIGHT
   case MPTSpheres: {
+    assignTokenArraysV( &tokenPointerArray, tokenArray, pointerArray );
+
+    if ( m_spheresAsPoints )
+    {
+      RiPointsV( m_numValidParticles, numTokens, tokenArray, pointerArray );
+      break;
+    }
+
+    // The renderer can't draw RiPoints as spheres: one RiSphere per particle
     int posAttr=-1,
       radAttr=-1,
       colAttr=-1,
       opacAttr=-1;
 
-    assignTokenArraysV( &tokenPointerArray, tokenArray, pointerArray );
-
     for ( i = 0; i < tokenPointerArray.size(); i++ )
     {
       char *tokenName = tokenPointerArray[i].getTokenName();
@@ -1139,22 +1120,17 @@ void liqRibParticleData::write()
     }
   }
   break;
-#endif // #ifndef DELIGHT
 
 
   case MPTSprites: {
 
-
-
+    // All sprites go out as a single RiPointsPolygons with one camera
+    // facing quad per particle. Every other token was made uniform in the
+    // constructor so spriteNum, Cs, Os, etc. travel per face.
     int posAttr   = -1,
-        numAttr    = -1,
         twistAttr  = -1,
         scaleXAttr = -1,
-        scaleYAttr = -1,
-        colAttr    = -1,
-        opacAttr   = -1;
-
-    assignTokenArraysV( &tokenPointerArray, tokenArray, pointerArray );
+        scaleYAttr = -1;
 
     for ( i = 0; i < tokenPointerArray.size(); i++ )
     {
@@ -1163,10 +1139,6 @@ void liqRibParticleData::write()
       {
         posAttr = i;
       }
-      else if ( strcmp(tokenName, "spriteNum") == 0 )
-      {
-        numAttr = i;
-      }
       else if ( strcmp(tokenName, "spriteTwist") == 0 )
       {
         twistAttr = i;
@@ -1179,14 +1151,11 @@ void liqRibParticleData::write()
       {
         scaleYAttr = i;
       }
-      else if ( strcmp(tokenName, "Cs") == 0 )
-      {
-        colAttr = i;
-      }
-      else if ( strcmp(tokenName, "Os") == 0 )
-      {
-        opacAttr = i;
-      }
+    }
+
+    if ( posAttr == -1 || m_numValidParticles == 0 )
+    {
+      break;
     }
 
     MVector camUp( 0, 1, 0 );
@@ -1197,67 +1166,84 @@ void liqRibParticleData::write()
     camRight *= liqglo_currentJob.camera[0].mat.inverse();
     camEye   *= liqglo_currentJob.camera[0].mat.inverse();
 
-    for( unsigned ui = 0; ui < m_numValidParticles; ui++ )
-    {
+    const RtFloat *P      = tokenPointerArray[ posAttr ].getTokenFloatArray();
+    const RtFloat *twist  = ( twistAttr  != -1 )? tokenPointerArray[ twistAttr ].getTokenFloatArray()  : NULL;
+    const RtFloat *scaleX = ( scaleXAttr != -1 )? tokenPointerArray[ scaleXAttr ].getTokenFloatArray() : NULL;
+    const RtFloat *scaleY = ( scaleYAttr != -1 )? tokenPointerArray[ scaleYAttr ].getTokenFloatArray() : NULL;
+
+    liqTokenPointer quadP;
+    quadP.set( "P", rPoint, false, m_numValidParticles * 4 );
+    quadP.setDetailType( rVertex );
+
+    liqTokenPointer quadST;
+    quadST.set( "st", rFloat, false, m_numValidParticles * 4, 2 );
+    quadST.setDetailType( rVarying );
 
-      MString str = MString( "I: " ) + ( (double) ui );
+    RtInt *nverts = new RtInt[ m_numValidParticles ];
+    RtInt *verts  = new RtInt[ m_numValidParticles * 4 ];
 
-      MGlobal::displayInfo( str );
+    // corner order around each quad and the matching texture coordinates
+    // (the same parameterisation a bilinear RiPatch would have)
+    static const float cornerX[ 4 ] = { -1,  1,  1, -1 };
+    static const float cornerY[ 4 ] = {  1,  1, -1, -1 };
+    static const float cornerS[ 4 ] = {  0,  1,  1,  0 };
+    static const float cornerT[ 4 ] = {  0,  0,  1,  1 };
+
+    for( unsigned ui = 0; ui < m_numValidParticles; ui++ )
+    {
       MVector up  = camUp;
       MVector right = camRight;
 
       float spriteRadiusX = 0.5;
       float spriteRadiusY = 0.5;
 
-      if ( colAttr != -1 )
-      {
-        RiColor( &((RtFloat*)pointerArray[colAttr])[ui*3] );
-      }
-      if ( opacAttr != -1 )
+      if ( twist )
       {
-        RiOpacity( &((RtFloat*)pointerArray[opacAttr])[ui*3] );
-      }
-      if ( twistAttr != -1 )
-      {
-        float twist = -((RtFloat*)pointerArray[twistAttr])[ui] * M_PI/180;
-        MQuaternion twistQ( twist, camEye );
+        MQuaternion twistQ( -twist[ ui ] * M_PI / 180, camEye );
         right = camRight.rotateBy( twistQ );
         up  = camUp.rotateBy( twistQ );
       }
-      if ( scaleXAttr != -1 )
+      if ( scaleX )
       {
-        spriteRadiusX *= ((RtFloat*)pointerArray[scaleXAttr])[ui];
+        spriteRadiusX *= scaleX[ ui ];
       }
-      if ( scaleYAttr != -1 )
+      if ( scaleY )
       {
-        spriteRadiusY *= ((RtFloat*)pointerArray[scaleYAttr])[ui];
+        spriteRadiusY *= scaleY[ ui ];
       }
 
-      if ( posAttr != -1 )
+      right *= spriteRadiusX;
+      up    *= spriteRadiusY;
+
+      nverts[ ui ] = 4;
+      for ( unsigned c = 0; c < 4; c++ )
       {
-        float *P = &( (RtFloat*) pointerArray[ posAttr ] )[ ui * 3 ];
-        float spriteNum = numAttr == -1 ? 0 : ((RtFloat*)pointerArray[numAttr])[ui];
-
-        float x0 = P[ 0 ] - spriteRadiusX * right[ 0 ] + spriteRadiusY * up[ 0 ];
-        float y0 = P[ 1 ] - spriteRadiusX * right[ 1 ] + spriteRadiusY * up[ 1 ];
-        float z0 = P[ 2 ] - spriteRadiusX * right[ 2 ] + spriteRadiusY * up[ 2 ];
-        float x1 = P[ 0 ] + spriteRadiusX * right[ 0 ] + spriteRadiusY * up[ 0 ];
-        float y1 = P[ 1 ] + spriteRadiusX * right[ 1 ] + spriteRadiusY * up[ 1 ];
-        float z1 = P[ 2 ] + spriteRadiusX * right[ 2 ] + spriteRadiusY * up[ 2 ];
-        float x2 = P[ 0 ] - spriteRadiusX * right[ 0 ] - spriteRadiusY * up[ 0 ];
-        float y2 = P[ 1 ] - spriteRadiusX * right[ 1 ] - spriteRadiusY * up[ 1 ];
-        float z2 = P[ 2 ] - spriteRadiusX * right[ 2 ] - spriteRadiusY * up[ 2 ];
-        float x3 = P[ 0 ] + spriteRadiusX * right[ 0 ] - spriteRadiusY * up[ 0 ];
-        float y3 = P[ 1 ] + spriteRadiusX * right[ 1 ] - spriteRadiusY * up[ 1 ];
-        float z3 = P[ 2 ] + spriteRadiusX * right[ 2 ] - spriteRadiusY * up[ 2 ];
-
-        float patch[ 12 ] = { x0, y0, z0,
-                               x1, y1, z1,
-                               x2, y2, z2,
-                               x3, y3, z3 };
-        RiPatch( "bilinear", "P", &patch, "float spriteNum", &spriteNum, RI_NULL );
+        unsigned v = ui * 4 + c;
+        verts[ v ] = v;
+        quadP.setTokenFloat( v,
+                             P[ ui * 3 + 0 ] + cornerX[ c ] * right[ 0 ] + cornerY[ c ] * up[ 0 ],
+                             P[ ui * 3 + 1 ] + cornerX[ c ] * right[ 1 ] + cornerY[ c ] * up[ 1 ],
+                             P[ ui * 3 + 2 ] + cornerX[ c ] * right[ 2 ] + cornerY[ c ] * up[ 2 ] );
+        quadST.setTokenFloat( v, 0, cornerS[ c ] );
+        quadST.setTokenFloat( v, 1, cornerT[ c ] );
       }
     }
+
+    // swap the particle positions for the quad corners and add st
+    std::vector<liqTokenPointer> quadTokenPointerArray( tokenPointerArray );
+    quadTokenPointerArray[ posAttr ].swap( quadP );
+    quadTokenPointerArray.resize( quadTokenPointerArray.size() + 1 );
+    quadTokenPointerArray.back().swap( quadST );
+
+    unsigned numQuadTokens = quadTokenPointerArray.size();
+    RtToken *quadTokenArray = (RtToken *)alloca( sizeof(RtToken) * numQuadTokens );
+    RtPointer *quadPointerArray = (RtPointer *)alloca( sizeof(RtPointer) * numQuadTokens );
+    assignTokenArraysV( &quadTokenPointerArray, quadTokenArray, quadPointerArray );
+
+    RiPointsPolygonsV( m_numValidParticles, nverts, verts, numQuadTokens, quadTokenArray, quadPointerArray );
+
+    delete [] nverts;
+    delete [] verts;
   }
   break;
 
@@ -1291,6 +1277,26 @@ bool liqRibParticleData::compare( const liqRibData & otherObj ) const
   return true;
 }
 
+bool liqRibParticleData::hash( liqHash &h ) const
+//
+//  Description:
+//    Add the particles to a fingerprint
+//
+{
+  hashTokens( h );
+  h.add( ( int )particleType );
+  h.add( m_numParticles );
+  h.add( m_numValidParticles );
+  h.add( ( int )m_multiCount );
+  h.add( ( int )m_spheresAsPoints );
+  if ( particleType == MPTBlobbies ) {
+    h.add( bCodeArray, sizeof( RtInt ) * bCodeArraySize );
+    h.add( bFloatArray, sizeof( RtFloat ) * bFloatArraySize );
+    for ( int i = 0; i < bStringArraySize; i++ ) h.add( bStringArray[i] );
+  }
+  return true;
+}
+
 ObjectType liqRibParticleData::type() const
 //
 //  Description:
@@ -1319,6 +1325,14 @@ void liqRibParticleData::addAdditionalParticleParameters( MObject node )
   addAdditionalColorParameters( nodeFn );
 }
 
+// Tell per particle attributes from the definition rather than the value,
+// getting the value of those runs the dynamics
+static bool isPerParticle( const MPlug &plug, MFnData::Type type )
+{
+  MObject attr = plug.attribute();
+  return attr.hasFn( MFn::kTypedAttribute ) && MFnTypedAttribute( attr ).attrType() == type;
+}
+
 void liqRibParticleData::addAdditionalFloatParameters( MFnDependencyNode nodeFn )
 {
   MStringArray foundAttributes = findAttributesByPrefix( "rmanF", nodeFn );
@@ -1330,12 +1344,10 @@ void liqRibParticleData::addAdditionalFloatParameters( MFnDependencyNode nodeFn
     MString  cutString = currAttribute.substring(5, currAttribute.length());
 
     MPlug  fPlug = nodeFn.findPlug( currAttribute );
-    MObject  plugObj;
-
-    status = fPlug.getValue( plugObj );
 
-    if ( plugObj.apiType() == MFn::kDoubleArrayData ) {
-      MFnDoubleArrayData  attributeData( plugObj );
+    if ( isPerParticle( fPlug, MFnData::kDoubleArray ) ) {
+      MDoubleArray  attributeData;
+      if ( !getDoubleArray( nodeFn, currAttribute, attributeData ) ) continue;
 
       floatParameter.set( cutString.asChar(),
                 rFloat,
@@ -1364,7 +1376,7 @@ void liqRibParticleData::addAdditionalFloatParameters( MFnDependencyNode nodeFn
       floatParameter.setTokenFloat( 0, floatValue );
     }
 
-    tokenPointerArray.push_back( floatParameter );
+    addToken( floatParameter );
   }
 }
 
@@ -1381,10 +1393,9 @@ void liqRibParticleData::addAdditionalPointParameters( MFnDependencyNode nodeFn
     MPlug  pPlug = nodeFn.findPlug( currAttribute );
     MObject  plugObj;
 
-    status = pPlug.getValue( plugObj );
-
-    if ( plugObj.apiType() == MFn::kVectorArrayData ) {
-      MFnVectorArrayData  attributeData( plugObj );
+    if ( isPerParticle( pPlug, MFnData::kVectorArray ) ) {
+      MVectorArray  attributeData;
+      if ( !getVectorArray( nodeFn, currAttribute, attributeData ) ) continue;
 
       pointParameter.set( cutString.asChar(),
                 rPoint,
@@ -1401,8 +1412,8 @@ void liqRibParticleData::addAdditionalPointParameters( MFnDependencyNode nodeFn
                         attributeData[m_validParticles[part_num]].z );
       }
 
-      tokenPointerArray.push_back( pointParameter );
-    } else if (plugObj.apiType() == MFn::kData3Double) {
+      addToken( pointParameter );
+    } else if ( pPlug.getValue( plugObj ) == MS::kSuccess && plugObj.apiType() == MFn::kData3Double ) {
       float x, y, z;
       pPlug.child(0).getValue( x );
       pPlug.child(1).getValue( y );
@@ -1412,7 +1423,7 @@ void liqRibParticleData::addAdditionalPointParameters( MFnDependencyNode nodeFn
       pointParameter.setTokenFloat( 0, x, y, z );
       pointParameter.setDetailType( rConstant );
 
-      tokenPointerArray.push_back( pointParameter );
+      addToken( pointParameter );
     }
     // else ignore this attribute
   }
@@ -1431,10 +1442,9 @@ void liqRibParticleData::addAdditionalVectorParameters( MFnDependencyNode nodeFn
     MPlug  vPlug = nodeFn.findPlug( currAttribute );
     MObject  plugObj;
 
-    status = vPlug.getValue( plugObj );
-
-    if ( plugObj.apiType() == MFn::kVectorArrayData ) {
-      MFnVectorArrayData  attributeData( plugObj );
+    if ( isPerParticle( vPlug, MFnData::kVectorArray ) ) {
+      MVectorArray  attributeData;
+      if ( !getVectorArray( nodeFn, currAttribute, attributeData ) ) continue;
 
       vectorParameter.set( cutString.asChar(),
                  rVector,
@@ -1451,8 +1461,8 @@ void liqRibParticleData::addAdditionalVectorParameters( MFnDependencyNode nodeFn
                          attributeData[m_validParticles[part_num]].z );
       }
 
-      tokenPointerArray.push_back( vectorParameter );
-    } else if (plugObj.apiType() == MFn::kData3Double) {
+      addToken( vectorParameter );
+    } else if ( vPlug.getValue( plugObj ) == MS::kSuccess && plugObj.apiType() == MFn::kData3Double ) {
 
       float x, y, z;
       vPlug.child(0).getValue( x );
@@ -1463,7 +1473,7 @@ void liqRibParticleData::addAdditionalVectorParameters( MFnDependencyNode nodeFn
       vectorParameter.setTokenFloat( 0, x, y, z );
       vectorParameter.setDetailType( rConstant );
 
-      tokenPointerArray.push_back( vectorParameter );
+      addToken( vectorParameter );
     }
     // else ignore this attribute
   }
@@ -1482,10 +1492,9 @@ void liqRibParticleData::addAdditionalColorParameters( MFnDependencyNode nodeFn
     MPlug  cPlug = nodeFn.findPlug( currAttribute );
     MObject  plugObj;
 
-    status = cPlug.getValue( plugObj );
-
-    if ( plugObj.apiType() == MFn::kVectorArrayData ) {
-      MFnVectorArrayData  attributeData( plugObj );
+    if ( isPerParticle( cPlug, MFnData::kVectorArray ) ) {
+      MVectorArray  attributeData;
+      if ( !getVectorArray( nodeFn, currAttribute, attributeData ) ) continue;
 
       colorParameter.set( cutString.asChar(),
                 rColor,
@@ -1502,8 +1511,8 @@ void liqRibParticleData::addAdditionalColorParameters( MFnDependencyNode nodeFn
                         attributeData[m_validParticles[part_num]].z );
       }
 
-      tokenPointerArray.push_back( colorParameter );
-    } else if (plugObj.apiType() == MFn::kData3Double) {
+      addToken( colorParameter );
+    } else if ( cPlug.getValue( plugObj ) == MS::kSuccess && plugObj.apiType() == MFn::kData3Double ) {
       float r, g, b;
       cPlug.child(0).getValue( r );
       cPlug.child(1).getValue( g );
@@ -1513,8 +1522,57 @@ void liqRibParticleData::addAdditionalColorParameters( MFnDependencyNode nodeFn
       colorParameter.setTokenFloat( 0, r, g, b );
       colorParameter.setDetailType( rConstant );
 
-      tokenPointerArray.push_back( colorParameter );
+      addToken( colorParameter );
     }
     // else ignore this attribute
   }
 }
+
+bool liqRibParticleData::getDoubleArray( MFnDependencyNode &nodeFn, const MString &attr, MDoubleArray &array )
+//
+//  Description:
+//    read a per particle double array, from the disk cache if we have one
+//
+{
+  MStatus status;
+  MPlug plug = nodeFn.findPlug( attr, &status );
+
+  // reading the node would run the dynamics the cache is there to spare
+  if ( m_haveCache ) {
+    if ( m_cache.getDoubleArray( attr, array ) ) return true;
+    if ( status == MS::kSuccess ) MGlobal::displayWarning( "Liquid : " + attr + " is not in the particle disk cache of " + nodeFn.name() + ", ignored." );
+    return false;
+  }
+
+  if ( status != MS::kSuccess ) return false;
+  MObject plugObj;
+  plug.getValue( plugObj );
+  MFnDoubleArrayData arrayData( plugObj, &status );
+  if ( status != MS::kSuccess ) return false;
+  array = arrayData.array();
+  return true;
+}
+
+bool liqRibParticleData::getVectorArray( MFnDependencyNode &nodeFn, const MString &attr, MVectorArray &array )
+//
+//  Description:
+//    read a per particle vector array, from the disk cache if we have one
+//
+{
+  MStatus status;
+  MPlug plug = nodeFn.findPlug( attr, &status );
+
+  if ( m_haveCache ) {
+    if ( m_cache.getVectorArray( attr, array ) ) return true;
+    if ( status == MS::kSuccess ) MGlobal::displayWarning( "Liquid : " + attr + " is not in the particle disk cache of " + nodeFn.name() + ", ignored." );
+    return false;
+  }
+
+  if ( status != MS::kSuccess ) return false;
+  MObject plugObj;
+  plug.getValue( plugObj );
+  MFnVectorArrayData arrayData( plugObj, &status );
+  if ( status != MS::kSuccess ) return false;
+  array = arrayData.array();
+  return true;
+}
@@ -116,7 +116,7 @@ liqRibPfxHairData::liqRibPfxHairData( MObject pfxHair )
 
       if ( ncurves > 0 ) {
 
-        nverts = (RtInt*)lmalloc( sizeof( RtInt ) * ( ncurves ) );
+        nverts = (RtInt*)lamalloc( sizeof( RtInt ) * ( ncurves ) );
         RtFloat* cvPtr      = CVs;
         RtFloat* widthPtr   = curveWidth;
         RtFloat* colorPtr   = cvColor;
@@ -224,7 +224,8 @@ liqRibPfxHairData::liqRibPfxHairData( MObject pfxHair )
 
         // store for output
         //cout <<"store P for output... ";
-        liqTokenPointer points_pointerPair;
+        tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+        liqTokenPointer &points_pointerPair = tokenPointerArray.back();
         int test = points_pointerPair.set( "P", rPoint, false, true, false, totalNumberOfVertices );
         if ( test == 0 ) {
           MString err("liqRibPfxHairData: liqTokenPointer failed to allocate CV memory !");
@@ -234,14 +235,14 @@ liqRibPfxHairData::liqRibPfxHairData( MObject pfxHair )
         }// else cout <<"points_pointerPair = "<<test<<endl;
         points_pointerPair.setDetailType( rVertex );
         points_pointerPair.setTokenFloats( CVs );
-        tokenPointerArray.push_back( points_pointerPair );
         if ( CVs != NULL ) { lfree( CVs ); CVs = NULL; }
         //cout <<"Done !"<<endl;
 
 
         // store width params
         //cout <<"store width for output... ";
-        liqTokenPointer width_pointerPair;
+        tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+        liqTokenPointer &width_pointerPair = tokenPointerArray.back();
         test = width_pointerPair.set( "width", rFloat, false, true, false, totalNumberOfSpans );
         if ( test == 0 ) {
           MString err("liqRibPfxHairData: liqTokenPointer failed to allocate width memory !");
@@ -251,13 +252,13 @@ liqRibPfxHairData::liqRibPfxHairData( MObject pfxHair )
         }// else cout <<"width_pointerPair = "<<test<<endl;
         width_pointerPair.setDetailType( rVarying );
         width_pointerPair.setTokenFloats( curveWidth );
-        tokenPointerArray.push_back( width_pointerPair );
         if ( curveWidth != NULL ) { lfree( curveWidth ); curveWidth = NULL; }
         //cout <<"Done !"<<endl;
 
         // store color params
         //cout <<"store color for output... ";
-        liqTokenPointer color_pointerPair;
+        tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+        liqTokenPointer &color_pointerPair = tokenPointerArray.back();
         test = color_pointerPair.set( "pfxHair_vtxColor", rColor, false, true, false, totalNumberOfVertices );
         if ( test == 0 ) {
           MString err("liqRibPfxHairData: liqTokenPointer failed to allocate color memory !");
@@ -267,13 +268,13 @@ liqRibPfxHairData::liqRibPfxHairData( MObject pfxHair )
         } //else cout <<"color_pointerPair = "<<test<<endl;
         color_pointerPair.setDetailType( rVertex );
         color_pointerPair.setTokenFloats( cvColor );
-        tokenPointerArray.push_back( color_pointerPair );
         if ( cvColor != NULL ) { lfree( cvColor ); cvColor = NULL; }
         //cout <<"Done !"<<endl;
 
         // store opacity params
         //cout <<"store opacity for output... ";
-        liqTokenPointer opacity_pointerPair;
+        tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+        liqTokenPointer &opacity_pointerPair = tokenPointerArray.back();
         test = opacity_pointerPair.set( "pfxHair_vtxOpacity", rColor, false, true, false, totalNumberOfVertices );
         if ( test == 0 ) {
           MString err("liqRibPfxHairData: liqTokenPointer failed to allocate opacity memory !");
@@ -283,7 +284,6 @@ liqRibPfxHairData::liqRibPfxHairData( MObject pfxHair )
         } //else cout <<"opacity_pointerPair = "<<test<<endl;
         opacity_pointerPair.setDetailType( rVertex );
         opacity_pointerPair.setTokenFloats( cvOpacity );
-        tokenPointerArray.push_back( opacity_pointerPair );
         if ( cvOpacity != NULL ) { lfree( cvOpacity ); cvOpacity = NULL; }
         //cout <<"Done !"<<endl;
 
@@ -314,7 +314,7 @@ liqRibPfxHairData::~liqRibPfxHairData()
     // Free all arrays
     LIQDEBUGPRINTF( "-> killing pfxHair curves\n" );
     if ( CVs != NULL )        { lfree( CVs );         CVs = NULL;         }
-    if ( nverts != NULL )     { lfree( nverts );      nverts = NULL;      }
+    if ( nverts != NULL )     { lafree( nverts );      nverts = NULL;      }
     if ( curveWidth != NULL ) { lfree( curveWidth );  curveWidth = NULL;  }
     if ( cvColor != NULL )    { lfree( cvColor );     cvColor = NULL;     }
     if ( cvOpacity != NULL )  { lfree( cvOpacity );   cvOpacity = NULL;   }
@@ -365,6 +365,18 @@ bool liqRibPfxHairData::compare( const liqRibData & otherObj ) const
   return false;
 }
 
+bool liqRibPfxHairData::hash( liqHash &h ) const
+//
+//  Description:
+//      Add the curves to a fingerprint
+//
+{
+  hashTokens( h );
+  h.add( ( int )ncurves );
+  if ( ncurves > 0 ) h.add( nverts, sizeof( RtInt ) * ncurves );
+  return true;
+}
+
 ObjectType liqRibPfxHairData::type() const
 //
 //  Description:
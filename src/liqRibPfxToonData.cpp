@@ -136,7 +136,7 @@ liqRibPfxToonData::liqRibPfxToonData( MObject pfxToon )
 
       if ( ncurves > 0 ) {
 
-        nverts = (RtInt*)lmalloc( sizeof( RtInt ) * ( ncurves ) );
+        nverts = (RtInt*)lamalloc( sizeof( RtInt ) * ( ncurves ) );
         RtFloat* cvPtr      = CVs;
         RtFloat* widthPtr   = curveWidth;
         RtFloat* colorPtr   = cvColor;
@@ -216,7 +216,8 @@ liqRibPfxToonData::liqRibPfxToonData( MObject pfxToon )
 
         // store for output
         // cout <<"store P for output... ";
-        liqTokenPointer points_pointerPair;
+        tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+        liqTokenPointer &points_pointerPair = tokenPointerArray.back();
         int test = points_pointerPair.set( "P", rPoint, false, true, false, totalNumberOfVertices );
         if ( test == 0 ) {
           MString err("liqRibPfxToonData: liqTokenPointer failed to allocate CV memory !");
@@ -226,14 +227,14 @@ liqRibPfxToonData::liqRibPfxToonData( MObject pfxToon )
         } //else cout <<"points_pointerPair = "<<test<<endl;
         points_pointerPair.setDetailType( rVertex );
         points_pointerPair.setTokenFloats( CVs );
-        tokenPointerArray.push_back( points_pointerPair );
         if ( CVs != NULL ) { lfree( CVs ); CVs = NULL; }
         // cout <<"Done !"<<endl;
 
 
         // store width params
         // cout <<"store width for output... ";
-        liqTokenPointer width_pointerPair;
+        tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+        liqTokenPointer &width_pointerPair = tokenPointerArray.back();
         test = width_pointerPair.set( "width", rFloat, false, true, false, totalNumberOfVertices );
         if ( test == 0 ) {
           MString err("liqRibPfxToonData: liqTokenPointer failed to allocate width memory !");
@@ -243,13 +244,13 @@ liqRibPfxToonData::liqRibPfxToonData( MObject pfxToon )
         }// else cout <<"width_pointerPair = "<<test<<endl;
         width_pointerPair.setDetailType( rVarying );
         width_pointerPair.setTokenFloats( curveWidth );
-        tokenPointerArray.push_back( width_pointerPair );
         if ( curveWidth != NULL ) { lfree( curveWidth ); curveWidth = NULL; }
         // cout <<"Done !"<<endl;
 
         // store color params
         // cout <<"store color for output... ";
-        liqTokenPointer color_pointerPair;
+        tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+        liqTokenPointer &color_pointerPair = tokenPointerArray.back();
         test = color_pointerPair.set( "pfxToon_vtxColor", rColor, false, true, false, totalNumberOfVertices );
         if ( test == 0 ) {
           MString err("liqRibPfxToonData: liqTokenPointer failed to allocate color memory !");
@@ -259,13 +260,13 @@ liqRibPfxToonData::liqRibPfxToonData( MObject pfxToon )
         } //else cout <<"color_pointerPair = "<<test<<endl;
         color_pointerPair.setDetailType( rVertex );
         color_pointerPair.setTokenFloats( cvColor );
-        tokenPointerArray.push_back( color_pointerPair );
         if ( cvColor != NULL ) { lfree( cvColor ); cvColor = NULL; }
         // cout <<"Done !"<<endl;
 
         // store opacity params
         // cout <<"store opacity for output... ";
-        liqTokenPointer opacity_pointerPair;
+        tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+        liqTokenPointer &opacity_pointerPair = tokenPointerArray.back();
         test = opacity_pointerPair.set( "pfxToon_vtxOpacity", rColor, false, true, false, totalNumberOfVertices );
         if ( test == 0 ) {
           MString err("liqRibPfxToonData: liqTokenPointer failed to allocate opacity memory !");
@@ -275,7 +276,6 @@ liqRibPfxToonData::liqRibPfxToonData( MObject pfxToon )
         } //else cout <<"opacity_pointerPair = "<<test<<endl;
         opacity_pointerPair.setDetailType( rVertex );
         opacity_pointerPair.setTokenFloats( cvOpacity );
-        tokenPointerArray.push_back( opacity_pointerPair );
         if ( cvOpacity != NULL ) { lfree( cvOpacity ); cvOpacity = NULL; }
         // cout <<"Done !"<<endl;
 
@@ -303,7 +303,7 @@ liqRibPfxToonData::~liqRibPfxToonData()
     // Free all arrays
     LIQDEBUGPRINTF( "-> killing pfxToon curves\n" );
     if ( CVs != NULL )        { lfree( CVs );         CVs = NULL;         }
-    if ( nverts != NULL )     { lfree( nverts );      nverts = NULL;      }
+    if ( nverts != NULL )     { lafree( nverts );      nverts = NULL;      }
     if ( curveWidth != NULL ) { lfree( curveWidth );  curveWidth = NULL;  }
     if ( cvColor != NULL )    { lfree( cvColor );     cvColor = NULL;     }
     if ( cvOpacity != NULL )  { lfree( cvOpacity );   cvOpacity = NULL;   }
@@ -351,6 +351,18 @@ bool liqRibPfxToonData::compare( const liqRibData & otherObj ) const
   return true;
 }
 
+bool liqRibPfxToonData::hash( liqHash &h ) const
+//
+//  Description:
+//      Add the curves to a fingerprint
+//
+{
+  hashTokens( h );
+  h.add( ( int )ncurves );
+  if ( ncurves > 0 ) h.add( nverts, sizeof( RtInt ) * ncurves );
+  return true;
+}
+
 ObjectType liqRibPfxToonData::type() const
 //
 //  Description:
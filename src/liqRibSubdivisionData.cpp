@@ -125,25 +125,32 @@ liqRibSubdivisionData::liqRibSubdivisionData( MObject mesh )
   float S;
   float T;
   MPoint point;
-  liqTokenPointer pointsPointerPair;
+  liqTokenPointer* pointsPointerPair;
   liqTokenPointer* pVertexSTPointerPair = NULL;
   liqTokenPointer* pFaceVertexSPointer = NULL;
   liqTokenPointer* pFaceVertexTPointer = NULL;
-  liqTokenPointer* pFaceVertexUPointer = NULL;
-  liqTokenPointer* pFaceVertexVPointer = NULL;
+  liqTokenPointer* pUVSetsPointers = NULL;
 
   // Allocate memory and tokens
   numFaces = numFaces;
-  nverts = (RtInt*) lmalloc( sizeof( RtInt ) * numFaces );
-  verts = (RtInt*) lmalloc( sizeof( RtInt ) * numFaceVertices );
+  nverts = (RtInt*) lamalloc( sizeof( RtInt ) * numFaces );
+  verts = (RtInt*) lamalloc( sizeof( RtInt ) * numFaceVertices );
 
-  pointsPointerPair.set( "P", rPoint, false, numPoints );
-  pointsPointerPair.setDetailType( rVertex );
+  // The tokens are built in place in tokenPointerArray, which is sized
+  // up front so the pointers below stay valid
+  unsigned numTokens = 1;
+  if ( numSTs > 0 ) {
+    numTokens += 1 + 2 * extraUVSetNames.length() + ( liqglo_outputMeshUVs ? 2 : 0 );
+  }
+  unsigned token = tokenPointerArray.size();
+  tokenPointerArray.resize( token + numTokens );
 
-  std::vector<liqTokenPointer> UVSetsArray;
+  pointsPointerPair = &tokenPointerArray[ token++ ];
+  pointsPointerPair->set( "P", rPoint, false, numPoints );
+  pointsPointerPair->setDetailType( rVertex );
 
   if ( numSTs > 0 ) {
-    pVertexSTPointerPair = new liqTokenPointer;
+    pVertexSTPointerPair = &tokenPointerArray[ token++ ];
     pVertexSTPointerPair->set( "st", rFloat, false, numFaceVertices, 2 );
 #ifdef DELIGHT
     pVertexSTPointerPair->setDetailType( rFaceVertex );
@@ -151,34 +158,30 @@ liqRibSubdivisionData::liqRibSubdivisionData( MObject mesh )
     pVertexSTPointerPair->setDetailType( rFaceVarying );
 #endif
 
+    pUVSetsPointers = &tokenPointerArray[ token ];
     for ( unsigned j=0; j<extraUVSetNames.length(); j++) {
 
       MString setName = "u_" + extraUVSetNames[j];
-      pFaceVertexUPointer = new liqTokenPointer;
-      pFaceVertexUPointer->set( setName.asChar(), rFloat, false, true, false, numFaceVertices );
+      tokenPointerArray[ token ].set( setName.asChar(), rFloat, false, true, false, numFaceVertices );
 #ifdef DELIGHT
-      pFaceVertexUPointer->setDetailType( rFaceVertex );
+      tokenPointerArray[ token++ ].setDetailType( rFaceVertex );
 #else
-      pFaceVertexUPointer->setDetailType( rFaceVarying );
+      tokenPointerArray[ token++ ].setDetailType( rFaceVarying );
 #endif
 
       setName = "v_" + extraUVSetNames[j];
-      pFaceVertexVPointer = new liqTokenPointer;
-      pFaceVertexVPointer->set( setName.asChar(), rFloat, false, true, false, numFaceVertices );
+      tokenPointerArray[ token ].set( setName.asChar(), rFloat, false, true, false, numFaceVertices );
 #ifdef DELIGHT
-      pFaceVertexVPointer->setDetailType( rFaceVertex );
+      tokenPointerArray[ token++ ].setDetailType( rFaceVertex );
 #else
-      pFaceVertexVPointer->setDetailType( rFaceVarying );
+      tokenPointerArray[ token++ ].setDetailType( rFaceVarying );
 #endif
 
-      UVSetsArray.push_back( *pFaceVertexUPointer );
-      UVSetsArray.push_back( *pFaceVertexVPointer );
-
     }
 
     if( liqglo_outputMeshUVs ) {
-      pFaceVertexSPointer = new liqTokenPointer;
-      pFaceVertexTPointer = new liqTokenPointer;
+      pFaceVertexSPointer = &tokenPointerArray[ token++ ];
+      pFaceVertexTPointer = &tokenPointerArray[ token++ ];
       // Match MTOR, which also outputs face-varying STs as well for some reason - Paul
       // not anymore - Philippe
       pFaceVertexSPointer->set( "u", rFloat, false, numFaceVertices );
@@ -196,7 +199,7 @@ liqRibSubdivisionData::liqRibSubdivisionData( MObject mesh )
     }
   }
 
-  vertexParam = pointsPointerPair.getTokenFloatArray();
+  vertexParam = pointsPointerPair->getTokenFloatArray();
 
   // Read the mesh from Maya
   for ( MItMeshPolygon polyIt ( mesh ); polyIt.isDone() == false; polyIt.next() ) {
@@ -208,7 +211,7 @@ liqRibSubdivisionData::liqRibSubdivisionData( MObject mesh )
       vertex = polyIt.vertexIndex( count );
       verts[faceVertex] = vertex;
       point = polyIt.point( count, MSpace::kObject );
-      pointsPointerPair.setTokenFloat( vertex, point.x, point.y, point.z );
+      pointsPointerPair->setTokenFloat( vertex, point.x, point.y, point.z );
 
       if( numSTs > 0 ) {
         fnMesh.getPolygonUV( face, count, S, T );
@@ -220,8 +223,8 @@ liqRibSubdivisionData::liqRibSubdivisionData( MObject mesh )
 
           fnMesh.getPolygonUV( face, count, S, T, &extraUVSetNames[j] );
 
-          (&UVSetsArray[2*j])->setTokenFloat( faceVertex, S );
-          (&UVSetsArray[2*j+1])->setTokenFloat( faceVertex, 1 - T );
+          pUVSetsPointers[2*j].setTokenFloat( faceVertex, S );
+          pUVSetsPointers[2*j+1].setTokenFloat( faceVertex, 1 - T );
 
         }
 
@@ -238,33 +241,6 @@ liqRibSubdivisionData::liqRibSubdivisionData( MObject mesh )
     ++face;
   }
 
-  // Add tokens to array and clean up after
-  tokenPointerArray.push_back( pointsPointerPair );
-
-  if( pVertexSTPointerPair != NULL ) {
-    tokenPointerArray.push_back( *pVertexSTPointerPair );
-    delete pVertexSTPointerPair;
-  }
-
-  if( pFaceVertexUPointer != NULL && pFaceVertexVPointer != NULL) {
-    for ( unsigned j=0; j<extraUVSetNames.length(); j++ ) {
-      tokenPointerArray.push_back( UVSetsArray[2*j] );
-      tokenPointerArray.push_back( UVSetsArray[2*j+1] );
-    }
-    delete pFaceVertexUPointer;
-    delete pFaceVertexVPointer;
-  }
-
-  if( pFaceVertexSPointer != NULL ) {
-    tokenPointerArray.push_back( *pFaceVertexSPointer );
-    delete pFaceVertexSPointer;
-  }
-
-  if( pFaceVertexTPointer != NULL ) {
-    tokenPointerArray.push_back( *pFaceVertexTPointer );
-    delete pFaceVertexTPointer;
-  }
-
   addAdditionalSurfaceParameters( mesh );
 }
 
@@ -272,8 +248,8 @@ liqRibSubdivisionData::~liqRibSubdivisionData()
 // Description: class destructor
 {
   LIQDEBUGPRINTF( "-> killing subdivision surface\n" );
-  lfree( nverts );
-  lfree( verts );
+  lafree( nverts );
+  lafree( verts );
   nverts = NULL;
   verts  = NULL;
 }
@@ -390,6 +366,24 @@ bool liqRibSubdivisionData::compare( const liqRibData & otherObj ) const
   return true;
 }
 
+bool liqRibSubdivisionData::hash( liqHash &h ) const
+// Description: Add the mesh and its tags to a fingerprint
+{
+  hashTokens( h );
+  h.add( ( int )numFaces );
+  h.add( ( int )numPoints );
+  unsigned numFaceVertices = 0;
+  for ( unsigned i = 0; i < numFaces; ++i ) numFaceVertices += nverts[i];
+  h.add( nverts, sizeof( RtInt ) * numFaces );
+  h.add( verts, sizeof( RtInt ) * numFaceVertices );
+  h.add( ( unsigned )v_tags.size() );
+  for ( unsigned i = 0; i < v_tags.size(); i++ ) h.add( v_tags[i] );
+  if ( !v_nargs.empty() )     h.add( &v_nargs[0], sizeof( RtInt ) * v_nargs.size() );
+  if ( !v_intargs.empty() )   h.add( &v_intargs[0], sizeof( RtInt ) * v_intargs.size() );
+  if ( !v_floatargs.empty() ) h.add( &v_floatargs[0], sizeof( RtFloat ) * v_floatargs.size() );
+  return true;
+}
+
 ObjectType liqRibSubdivisionData::type() const
 // Description: return the geometry type
 {
@@ -46,7 +46,6 @@ extern "C" {
 #include<maya/MDoubleArray.h>
 #include<maya/MPointArray.h>
 #include<maya/MFloatArray.h>
-#include<maya/MItSurfaceCV.h>
 #include<maya/MFnNurbsSurface.h>
 #include<maya/MIntArray.h>
 
@@ -59,14 +58,8 @@ extern "C" {
 extern int debugMode;
 extern liqRenderer liquidRenderer;
 
-liqRibSurfaceData::liqRibSurfaceData( MObject surface )
-//  Description:
-//      create a RIB compatible representation of a Maya nurbs surface
-
-:   hasTrims( false ),
-    uknot( NULL ),
-    vknot( NULL ),
-    CVs( NULL ),
+liqRibTrimData::liqRibTrimData()
+:   nloops( 0 ),
     ncurves( NULL ),
     order( NULL ),
     n( NULL ),
@@ -75,7 +68,46 @@ liqRibSurfaceData::liqRibSurfaceData( MObject surface )
     maxKnot( NULL ),
     u( NULL ),
     v( NULL ),
-    w( NULL )
+    w( NULL ),
+    referenceCount( 1 )
+{
+}
+
+liqRibTrimData::~liqRibTrimData()
+{
+  if ( ncurves != NULL ) lafree( ncurves );
+  if ( order != NULL ) lafree( order );
+  if ( n != NULL ) lafree( n );
+  if ( knot != NULL ) lafree( knot );
+  if ( minKnot != NULL ) lafree( minKnot );
+  if ( maxKnot != NULL ) lafree( maxKnot );
+  if ( u != NULL ) lafree( u );
+  if ( v != NULL ) lafree( v );
+  if ( w != NULL ) lafree( w );
+}
+
+void liqRibTrimData::ref()
+{
+  referenceCount++;
+}
+
+void liqRibTrimData::unref()
+{
+  if ( --referenceCount <= 0 ) delete this;
+}
+
+
+liqRibSurfaceData::liqRibSurfaceData( MObject surface, const liqRibSurfaceData *firstSample )
+//  Description:
+//      create a RIB compatible representation of a Maya nurbs surface.
+//      firstSample is the shutter open sample of the same surface when
+//      this is a later motion sample; its trims are reused.
+
+:   hasTrims( false ),
+    uknot( NULL ),
+    vknot( NULL ),
+    CVs( NULL ),
+    trims( NULL )
 
 {
   LIQDEBUGPRINTF( "-> creating nurbs surface\n" );
@@ -154,10 +186,9 @@ liqRibSurfaceData::liqRibSurfaceData( MObject surface )
     vKnotMult = 1 / ( vmax - vmin );
   }
 
-  // Allocate CV and knot storage
-  CVs   = ( RtFloat* )lmalloc( sizeof( RtFloat ) * ( nu * nv * 4 ) );
-  uknot = ( RtFloat* )lmalloc( sizeof( RtFloat ) * ( uKnots.length() + 2 ) );
-  vknot = ( RtFloat* )lmalloc( sizeof( RtFloat ) * ( vKnots.length() + 2 ) );
+  // Allocate knot storage
+  uknot = ( RtFloat* )lamalloc( sizeof( RtFloat ) * ( uKnots.length() + 2 ) );
+  vknot = ( RtFloat* )lamalloc( sizeof( RtFloat ) * ( vKnots.length() + 2 ) );
 
   unsigned k;
   if ( normalizeNurbsUV && ( status != MS::kSuccess ) ) {
@@ -195,144 +226,133 @@ liqRibSurfaceData::liqRibSurfaceData( MObject surface )
 
   // Read CV information
   //
-  MItSurfaceCV cvs( surface, liquidRenderer.requires_SWAPPED_UVS == false );
-  RtFloat* cvPtr = CVs;
-
-  while( !cvs.isDone() ) {
-    while( !cvs.isRowDone() ) {
-      MPoint pt = cvs.position( MSpace::kObject );
-      *cvPtr = ( RtFloat )pt.x; cvPtr++;
-      *cvPtr = ( RtFloat )pt.y; cvPtr++;
-      *cvPtr = ( RtFloat )pt.z; cvPtr++;
-      *cvPtr = ( RtFloat )pt.w; cvPtr++;
-      cvs.next();
+  // getCVs() returns the CVs with v varying fastest, RiNuPatch wants
+  // them with its own u varying fastest.
+  //
+  MPointArray cvArray;
+  nurbs.getCVs( cvArray, MSpace::kObject );
+  CVs = ( RtFloat* )lamalloc( sizeof( RtFloat ) * ( nu * nv * 4 ) );
+  {
+    unsigned mayaNumCVsInV = nurbs.numCVsInV();
+    RtFloat* cvPtr = CVs;
+    for ( unsigned cv = 0; cv < ( unsigned )nv; cv++ ) {
+      for ( unsigned cu = 0; cu < ( unsigned )nu; cu++ ) {
+        const MPoint &pt = liquidRenderer.requires_SWAPPED_UVS ? cvArray[ cv * mayaNumCVsInV + cu ] : cvArray[ cu * mayaNumCVsInV + cv ];
+        *cvPtr++ = ( RtFloat )pt.x;
+        *cvPtr++ = ( RtFloat )pt.y;
+        *cvPtr++ = ( RtFloat )pt.z;
+        *cvPtr++ = ( RtFloat )pt.w;
+      }
     }
-    cvs.nextRow();
   }
+  cvArray.clear();
 
   // Store trim information
   //
-  if (nurbs.isTrimmedSurface()) {
+  if ( nurbs.isTrimmedSurface() ) {
     hasTrims = true;
-    LIQDEBUGPRINTF( "-> storing trim information\n" );
 
-    unsigned numRegions, numBoundaries, numEdges, numCurves;
+    unsigned numRegions = nurbs.numRegions();
     unsigned r, b, e, c;
 
     // Get the number of loops
     //
-    numRegions = nurbs.numRegions();
-    nloops = 0;
+    RtInt nloops = 0;
     for ( r = 0; r < numRegions; r++ ) {
-      numBoundaries = nurbs.numBoundaries( r );
-      nloops += numBoundaries;
+      nloops += nurbs.numBoundaries( r );
     }
 
-    MIntArray numCurvesPerLoop, orderArray, numCVsArray;
-    MFloatArray knotArray, minArray, maxArray;
-    MPointArray cvArray;
-
-    // Get the number of trim curves in each loop and gather curve
-    // information
-    //
-    for ( r = 0; r < (unsigned) nloops; r++ ) {
-      numBoundaries = nurbs.numBoundaries( r );
-      for ( b = 0; b < numBoundaries; b++ ) {
-        numCurves = 0;
-        numEdges = nurbs.numEdges( r, b );
-        for ( e = 0; e < numEdges; e++ ) {
-          MObjectArray curves = nurbs.edge( r, b, e, true );
-          numCurves += curves.length();
-
-          // Gather extra stats for each curve
-          //
-          for ( c = 0; c < curves.length(); c++ ) {
-            unsigned i;
-
-            // Read the # of CVs in and the order of each curve
-            //
-            MFnNurbsCurve curveFn(curves[c]);
-            orderArray.append( curveFn.degree() + 1 );
-            numCVsArray.append( curveFn.numCVs() );
-
-            // Read the CVs for each curve
-            //
-            MPoint pnt;
-            unsigned last = curveFn.numCVs();
-            for ( i = 0; i < last; ++i ) {
-              curveFn.getCV( i, pnt );
-              cvArray.append( pnt );
-            }
-
-            // Read the knot array for each curve
-            //
-            MDoubleArray knotsTmpArray;
-            curveFn.getKnots( knotsTmpArray );
-            last = knotsTmpArray.length();
-            knotArray.append( knotsTmpArray[0] );
-            for ( i = 0; i < last; ++i ) {
-              knotArray.append( (float)knotsTmpArray[i] );
+    if ( firstSample && firstSample->trims && firstSample->trims->nloops == nloops ) {
+      LIQDEBUGPRINTF( "-> sharing trim information of first motion sample\n" );
+      trims = firstSample->trims;
+      trims->ref();
+    } else {
+      LIQDEBUGPRINTF( "-> storing trim information\n" );
+      trims = new liqRibTrimData;
+      trims->nloops = nloops;
+      trims->ncurves = ( RtInt* )lamalloc( sizeof( RtInt ) * nloops );
+
+      // Collect the trim curves of all loops first so the RIB arrays can be
+      // sized up front
+      //
+      MObjectArray curves;
+      unsigned loop = 0;
+      for ( r = 0; r < numRegions; r++ ) {
+        unsigned numBoundaries = nurbs.numBoundaries( r );
+        for ( b = 0; b < numBoundaries; b++ ) {
+          unsigned numCurves = 0;
+          unsigned numEdges = nurbs.numEdges( r, b );
+          for ( e = 0; e < numEdges; e++ ) {
+            MObjectArray edgeCurves = nurbs.edge( r, b, e, true );
+            for ( c = 0; c < edgeCurves.length(); c++ ) {
+              curves.append( edgeCurves[ c ] );
             }
-            knotArray.append( knotsTmpArray[last-1] );
-
-            // Read the knot domain for each curve
-            //
-            double start, end;
-            curveFn.getKnotDomain( start, end );
-            minArray.append( start );
-            maxArray.append( end );
+            numCurves += edgeCurves.length();
           }
+          trims->ncurves[ loop++ ] = numCurves;
         }
-        numCurvesPerLoop.append( numCurves );
       }
-    }
-
-    // Store the trim information in RIB format
-    //
-    ncurves = ( RtInt* )lmalloc( sizeof( RtInt ) * numCurvesPerLoop.length() );
-    numCurvesPerLoop.get( (int*)ncurves );
-
-    order = ( RtInt* )lmalloc( sizeof( RtInt ) * orderArray.length() );
-    orderArray.get( ( int* )order );
-
-    n = ( RtInt* )lmalloc( sizeof( RtInt ) * numCVsArray.length() );
-    numCVsArray.get( ( int* )n );
 
-    knot = ( RtFloat* )lmalloc( sizeof( RtFloat ) * knotArray.length() );
-    knotArray.get( knot );
+      unsigned numCurves = curves.length();
+      unsigned numCVs = 0, numKnots = 0;
+      MFnNurbsCurve curveFn;
+      for ( c = 0; c < numCurves; c++ ) {
+        curveFn.setObject( curves[ c ] );
+        numCVs   += curveFn.numCVs();
+        numKnots += curveFn.numKnots() + 2;
+      }
 
-    minKnot = ( RtFloat* )lmalloc( sizeof( RtFloat ) * minArray.length() );
-    minArray.get( minKnot );
+      trims->order   = ( RtInt* )lamalloc( sizeof( RtInt ) * numCurves );
+      trims->n       = ( RtInt* )lamalloc( sizeof( RtInt ) * numCurves );
+      trims->minKnot = ( RtFloat* )lamalloc( sizeof( RtFloat ) * numCurves );
+      trims->maxKnot = ( RtFloat* )lamalloc( sizeof( RtFloat ) * numCurves );
+      trims->knot    = ( RtFloat* )lamalloc( sizeof( RtFloat ) * numKnots );
+      trims->u       = ( RtFloat* )lamalloc( sizeof( RtFloat ) * numCVs );
+      trims->v       = ( RtFloat* )lamalloc( sizeof( RtFloat ) * numCVs );
+      trims->w       = ( RtFloat* )lamalloc( sizeof( RtFloat ) * numCVs );
+
+      RtFloat *knotPtr = trims->knot;
+      RtFloat *uPtr = trims->u, *vPtr = trims->v, *wPtr = trims->w;
+      MDoubleArray curveKnots;
+      for ( c = 0; c < numCurves; c++ ) {
+        curveFn.setObject( curves[ c ] );
+        trims->order[ c ] = curveFn.degree() + 1;
+        trims->n[ c ]     = curveFn.numCVs();
+
+        curveFn.getCVs( cvArray );
+        unsigned i, last = cvArray.length();
+        for ( i = 0; i < last; ++i ) {
+          const MPoint &pt = cvArray[ i ];
+          *uPtr++ = ( RtFloat )( pt.y * pt.w );
+          *vPtr++ = ( RtFloat )( pt.x * pt.w );
+          *wPtr++ = ( RtFloat )pt.w;
+        }
 
-    maxKnot = ( RtFloat* )lmalloc( sizeof( RtFloat ) * maxArray.length() );
-    maxArray.get( maxKnot );
+        // Maya doesn't store the first and last knots either
+        //
+        curveFn.getKnots( curveKnots );
+        last = curveKnots.length();
+        *knotPtr++ = ( RtFloat )curveKnots[ 0 ];
+        for ( i = 0; i < last; ++i ) {
+          *knotPtr++ = ( RtFloat )curveKnots[ i ];
+        }
+        *knotPtr++ = ( RtFloat )curveKnots[ last - 1 ];
 
-    unsigned last = cvArray.length();
-    u = ( RtFloat* )lmalloc( sizeof( RtFloat ) * last );
-    v = ( RtFloat* )lmalloc( sizeof( RtFloat ) * last );
-    w = ( RtFloat* )lmalloc( sizeof( RtFloat ) * last );
-    for ( unsigned i = 0; i < last; ++i ) {
-      u[i] = ( RtFloat )( cvArray[ i ].y * cvArray[ i ].w ); // u
-      v[i] = ( RtFloat )( cvArray[ i ].x * cvArray[ i ].w ); // v
-      w[i] = ( RtFloat ) cvArray[ i ].w;                   // w
+        double start, end;
+        curveFn.getKnotDomain( start, end );
+        trims->minKnot[ c ] = ( RtFloat )start;
+        trims->maxKnot[ c ] = ( RtFloat )end;
+      }
     }
-
-    numCurvesPerLoop.clear();
-    orderArray.clear();
-    numCVsArray.clear();
-    knotArray.clear();
-    minArray.clear();
-    maxArray.clear();
-    cvArray.clear();
   }
 
   // now place our tokens and parameters into our tokenlist
 
-  liqTokenPointer tokenPointerPair;
+  tokenPointerArray.resize( tokenPointerArray.size() + 1 );
+  liqTokenPointer &tokenPointerPair = tokenPointerArray.back();
   tokenPointerPair.set( "Pw", rPoint, true, nu * nv );
   tokenPointerPair.setDetailType( rVertex );
   tokenPointerPair.setTokenFloats( CVs );
-  tokenPointerArray.push_back( tokenPointerPair );
 
   addAdditionalSurfaceParameters( surface );
   }
@@ -344,20 +364,12 @@ liqRibSurfaceData::~liqRibSurfaceData()
 {
   // free all arrays
   LIQDEBUGPRINTF( "-> killing nurbs surface\n" );
-  if ( uknot != NULL ) { lfree( uknot ); uknot = NULL; }
-  if ( vknot != NULL ) { lfree( vknot ); vknot = NULL; }
+  if ( uknot != NULL ) { lafree( uknot ); uknot = NULL; }
+  if ( vknot != NULL ) { lafree( vknot ); vknot = NULL; }
   // this is freed by the ribdata destructor
   // this is not true anymore
-  if ( CVs != NULL ) { lfree( CVs ); CVs = NULL; }
-  if ( ncurves != NULL ) { lfree( ncurves ); ncurves = NULL; }
-  if ( order != NULL ) { lfree( order ); order = NULL; }
-  if ( n != NULL ) { lfree( n ); n = NULL; }
-  if ( knot != NULL ) { lfree( knot ); knot = NULL; }
-  if ( minKnot != NULL ) { lfree( minKnot ); minKnot = NULL; }
-  if ( maxKnot != NULL ) { lfree( maxKnot ); maxKnot = NULL; }
-  if ( u != NULL ) { lfree( u ); u = NULL; }
-  if ( v != NULL ) { lfree( v ); v = NULL; }
-  if ( w != NULL ) { lfree( w ); w = NULL; }
+  if ( CVs != NULL ) { lafree( CVs ); CVs = NULL; }
+  if ( trims != NULL ) { trims->unref(); trims = NULL; }
   LIQDEBUGPRINTF( "-> finished killing nurbs surface\n" );
 }
 
@@ -444,6 +456,26 @@ bool liqRibSurfaceData::compare( const liqRibData & otherObj ) const
   return true;
 }
 
+bool liqRibSurfaceData::hash( liqHash &h ) const
+//
+//  Description:
+//      Add the surface to a fingerprint, the CVs are one of its tokens
+//
+{
+  hashTokens( h );
+  h.add( ( int )nu );
+  h.add( ( int )nv );
+  h.add( ( int )uorder );
+  h.add( ( int )vorder );
+  h.add( umin );
+  h.add( umax );
+  h.add( vmin );
+  h.add( vmax );
+  h.add( uknot, sizeof( RtFloat ) * ( nu + uorder ) );
+  h.add( vknot, sizeof( RtFloat ) * ( nv + vorder ) );
+  return true;
+}
+
 ObjectType liqRibSurfaceData::type() const
 //
 //  Description:
@@ -464,15 +496,15 @@ void liqRibSurfaceData::writeTrimCurves() const
 {
   LIQDEBUGPRINTF( "-> writing nurbs surface trims\n" );
   if ( hasTrims ) {
-    RiTrimCurve( nloops,
-                 ncurves,
-                 order,
-                 knot,
-                 minKnot,
-                 maxKnot,
-                 n,
-                 u,
-                 v,
-                 w );
+    RiTrimCurve( trims->nloops,
+                 trims->ncurves,
+                 trims->order,
+                 trims->knot,
+                 trims->minKnot,
+                 trims->maxKnot,
+                 trims->n,
+                 trims->u,
+                 trims->v,
+                 trims->w );
   }
 }
@@ -35,10 +35,11 @@
 #endif
 
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
 
 #ifndef _WIN32
 #include <sys/time.h>
-#include <sys/stat.h>
 #endif
 
 #ifndef _WIN32
@@ -87,8 +88,10 @@ static const char *LIQUIDVERSION =
 
 #ifdef _WIN32
 #  define RM_CMD "cmd.exe /c del"
+#  define CP_CMD "cmd.exe /c copy"
 #else
 #  define RM_CMD "/bin/rm"
+#  define CP_CMD "/bin/cp"
 #endif
 
 // Maya headers
@@ -110,6 +113,8 @@ static const char *LIQUIDVERSION =
 #include <maya/MFnIntArrayData.h>
 #include <maya/MDistance.h>
 #include <maya/MDagModifier.h>
+#include <maya/MBoundingBox.h>
+#include <maya/MVector.h>
 #include <maya/MPxNode.h>
 
 // Liquid headers
@@ -120,6 +125,11 @@ static const char *LIQUIDVERSION =
 #include <liqProcessLauncher.h>
 #include <liqRenderer.h>
 #include <liqCustomNode.h>
+#include <liqMeshLOD.h>
+#include <liqTextureCache.h>
+#include <liqRibManifest.h>
+#include <liqRibGenData.h>
+#include <liqRibGenRegistry.h>
 
 typedef int RtError;
 
@@ -152,6 +162,12 @@ bool         liqglo_relativeFileNames;                // true if we only want to
 MStringArray liqglo_DDimageName;
 double       liqglo_FPS;                              // Frame-rate (for particle streak length)
 bool         liqglo_outputMeshUVs;                    // true if we are writing uvs for subdivs/polys (in addition to "st")
+bool         liqglo_useParticleCache;                 // true if particles are read from their .pdc disk cache
+MString      liqglo_particleCacheDir;                 // where the .pdc files are, project/particles/scene if empty
+bool         liqglo_polygonLOD;                       // true if meshes are written with decimated RiDetailRange levels
+RtFloat      liqglo_polygonLODArea;                   // screen area in pixels under which meshes start to be decimated
+int          liqglo_ribGenThreads;                    // threads running thread safe ribgens, 1 runs them in place
+bool         liqglo_outputAllShaderParams;            // true if shader parameters left at their default are written too
 bool         liqglo_noSingleFrameShadows;             // allows you to skip single-frame shadows when you chunk a render
 bool         liqglo_singleFrameShadowsOnly;           // allows you to skip single-frame shadows when you chunk a render
 MString      liqglo_renderCamera;                     // a global copy for liqRibPfxToonData
@@ -211,19 +227,442 @@ int RiNColorSamples;
 void liqRibTranslator::freeShaders( void )
 {
   LIQDEBUGPRINTF( "-> freeing shader data.\n" );
-  std::vector<liqShader>::iterator iter = m_shaders.begin();
+  std::map<std::string, shaderCacheEntry*>::iterator iter = m_shaders.begin();
   while ( iter != m_shaders.end() ) {
-    int k = 0;
-    while ( k < iter->numTPV ) {
-      iter->freeShader();
-      k++;
-    }
+    MMessage::removeCallback( iter->second->callback );
+    delete iter->second->shader;
+    delete iter->second;
     ++iter;
   }
   m_shaders.clear();
   LIQDEBUGPRINTF( "-> finished freeing shader data.\n" );
 }
 
+void liqRibTranslator::shaderChangedCallback( MNodeMessage::AttributeMessage msg, MPlug &plug, MPlug &otherPlug, void *clientData )
+{
+  if ( msg & ( MNodeMessage::kAttributeSet | MNodeMessage::kConnectionMade | MNodeMessage::kConnectionBroken |
+               MNodeMessage::kAttributeArrayAdded | MNodeMessage::kAttributeArrayRemoved |
+               MNodeMessage::kAttributeAdded | MNodeMessage::kAttributeRemoved ) ) {
+    ( ( shaderCacheEntry * )clientData )->dirty = true;
+  }
+}
+
+/**
+ * Fingerprint of what a shadow map is rendered from : the settings of the
+ * map, the view of the light over the motion samples, the globals and the
+ * objects casting into it with their shaders. It leaves out the frame, a
+ * static light gives the same fingerprint on all frames. Empty if some of
+ * it can't be told from Maya.
+ */
+MString liqRibTranslator::shadowFingerprint( const structJob &job )
+{
+  // lights written in deep shadows aren't fingerprinted
+  if ( NULL == htable || ( job.deepShadows && m_outputLightsInDeepShadows ) ) return "";
+
+  liqHash h;
+  h.add( job.width );
+  h.add( job.height );
+  h.add( job.aspectRatio );
+  h.add( ( int )job.samples );
+  h.add( job.shadingRate );
+  h.add( job.shadingRateFactor );
+  h.add( job.shadowPixelSamples );
+  h.add( job.shadowVolumeInterpretation );
+  h.add( ( int )job.deepShadows );
+  h.add( ( int )job.isMinMaxShadow );
+  h.add( ( int )job.isMidPointShadow );
+  h.add( ( int )job.isPoint );
+  h.add( ( int )job.pointDir );
+  h.add( ( int )job.shadowType );
+  h.add( ( int )job.shadowHiderType );
+  h.add( ( int )job.volume );
+  h.add( job.deepShadowOption );
+  h.add( job.jobOptions );
+  h.add( job.jobFrameRib );
+  h.add( job.format );
+  h.add( job.imageMode );
+  h.add( job.shadowObjectSet );
+  h.add( ( int )fullShadowRib );
+
+  // the samples scanned, offset from the frame
+  int samples = ( doCameraMotion || liqglo_doMotion || liqglo_doDef ) ? liqglo_motionSamples : 1;
+  h.add( samples );
+  h.add( liqglo_shutterTime );
+  for ( int i = 0; i < samples && i < LIQMAXMOTIONSAMPLES; i++ ) {
+    h.add( liqglo_sampleTimesOffsets[i] );
+    const structCamera &camera = job.camera[i];
+    h.add( camera.mat );
+    h.add( camera.neardb );
+    h.add( camera.fardb );
+    h.add( camera.hFOV );
+    h.add( camera.isOrtho );
+    h.add( camera.orthoWidth );
+    h.add( camera.orthoHeight );
+    h.add( camera.horizontalFilmOffset );
+    h.add( camera.verticalFilmOffset );
+  }
+
+  hashGlobals( h );
+
+  // the casting objects, picked as in objectBlock() but regardless of
+  // culling : what is out of view changes the fingerprint too
+  MStatus status;
+  MObject shadowSetObj;
+  if ( job.shadowObjectSet != "" ) {
+    MObject tmp = getNodeByName( job.shadowObjectSet, &status );
+    if ( status == MS::kSuccess ) shadowSetObj = tmp;
+    status.clear();
+  }
+  MFnSet shadowSet( shadowSetObj, &status );
+  for ( RNMAP::iterator rniter = htable->RibNodeMap.begin(); rniter != htable->RibNodeMap.end(); rniter++ ) {
+    liqRibNode * ribNode = (*rniter).second;
+    if ( NULL == ribNode || ribNode->object(0)->type == MRT_Light || ribNode->object(0)->type == MRT_ClipPlane ) continue;
+    if ( ribNode->object(0)->type != MRT_Coord ) {
+      if ( ribNode->object(0)->ignoreShadow ) continue;
+      if ( !shadowSetObj.isNull() && !shadowSet.isMember( ribNode->path().transform(), &status ) ) continue;
+    } else if ( ribNode->object(0)->ignore ) continue;
+    if ( !ribNode->hash( h ) || !hashShaders( h, ribNode ) ) return "";
+  }
+  return h.str();
+}
+
+/**
+ * Add the globals to a fingerprint, as they would be saved with the scene.
+ */
+void liqRibTranslator::hashGlobals( liqHash &h )
+{
+  MFnDependencyNode globals( rGlobalObj );
+  for ( unsigned i = 0; i < globals.attributeCount(); i++ ) {
+    MPlug plug( rGlobalObj, globals.attribute( i ) );
+    MStringArray cmds;
+    plug.getSetAttrCmds( cmds );
+    for ( unsigned c = 0; c < cmds.length(); c++ ) h.add( cmds[c] );
+  }
+}
+
+/**
+ * Add the shaders of an object to a fingerprint, false if one of them is a
+ * custom node whose output isn't known.
+ */
+bool liqRibTranslator::hashShaders( liqHash &h, liqRibNode *ribNode )
+{
+  int type = ribNode->object(0)->type;
+  if ( type == MRT_Light || type == MRT_Coord || type == MRT_ClipPlane ) return true;
+
+  shaderAssignment shaders;
+  getShaderAssignment( ribNode, shaders );
+  if ( shaders.hasCustomSurfaceShader == liqCustomPxShaderNode ||
+       shaders.hasCustomDisplacementShader == liqCustomPxShaderNode ||
+       shaders.hasCustomVolumeShader == liqCustomPxShaderNode ) return false;
+  h.add( shaders.surfaceShaderRibBox );
+  h.add( shaders.displacementShaderRibBox );
+  h.add( shaders.volumeShaderRibBox );
+  if ( shaders.hasSurfaceShader && !shaders.hasCustomSurfaceShader ) liqGetShader( ribNode->assignedShader.object() ).hash( h );
+  if ( shaders.hasDisplacementShader && !shaders.hasCustomDisplacementShader ) liqGetShader( ribNode->assignedDisp.object() ).hash( h );
+  if ( shaders.hasVolumeShader && !shaders.hasCustomVolumeShader ) liqGetShader( ribNode->assignedVolume.object() ).hash( h );
+  return true;
+}
+
+/**
+ * Fingerprint of what the jobs of a scan are made from : the command
+ * arguments, the globals, the frame and its sample times, and all the
+ * objects of the scan with their shaders and light links. Empty if some
+ * of it can't be told from Maya.
+ */
+MString liqRibTranslator::scanFingerprint( long scanTime )
+{
+  if ( NULL == htable ) return "";
+
+  liqHash h;
+  h.add( m_outputArgs );
+  hashGlobals( h );
+  h.add( ( int )liqglo_lframe );
+  h.add( ( int )scanTime );
+  int samples = ( doCameraMotion || liqglo_doMotion || liqglo_doDef ) ? liqglo_motionSamples : 1;
+  h.add( samples );
+  for ( int i = 0; i < samples && i < LIQMAXMOTIONSAMPLES; i++ ) h.add( liqglo_sampleTimes[i] );
+
+  for ( RNMAP::iterator rniter = htable->RibNodeMap.begin(); rniter != htable->RibNodeMap.end(); rniter++ ) {
+    liqRibNode * ribNode = (*rniter).second;
+    if ( NULL == ribNode ) continue;
+    if ( !ribNode->hash( h ) || !hashShaders( h, ribNode ) ) return "";
+  }
+  return h.str();
+}
+
+static void hashCamera( liqHash &h, const structCamera &camera )
+{
+  h.add( camera.mat );
+  h.add( camera.neardb );
+  h.add( camera.fardb );
+  h.add( camera.hFOV );
+  h.add( camera.isOrtho );
+  h.add( camera.orthoWidth );
+  h.add( camera.orthoHeight );
+  h.add( camera.name );
+  h.add( ( int )camera.motionBlur );
+  h.add( camera.shutter );
+  h.add( camera.fStop );
+  h.add( camera.focalDistance );
+  h.add( camera.focalLength );
+  h.add( camera.horizontalFilmOffset );
+  h.add( camera.verticalFilmOffset );
+}
+
+/**
+ * Fingerprint of what the RIB of a job is made from : the scan and the job
+ * with its cameras. A shadow archive is culled to the views of all the
+ * jobs reading it, theirs go in too. Empty if the scan has none.
+ */
+MString liqRibTranslator::jobFingerprint( const structJob &job )
+{
+  if ( m_scanInputs == "" ) return "";
+
+  liqHash h;
+  h.add( m_scanInputs );
+  h.add( job.name );
+  h.add( job.ribFileName );
+  h.add( job.imageName );
+  h.add( job.renderName );
+  h.add( job.format );
+  h.add( job.imageMode );
+  h.add( job.width );
+  h.add( job.height );
+  h.add( job.aspectRatio );
+  h.add( ( int )job.samples );
+  h.add( job.shadingRate );
+  h.add( job.shadingRateFactor );
+  h.add( ( int )job.pass );
+  h.add( ( int )job.isShadow );
+  h.add( ( int )job.isShadowPass );
+  h.add( ( int )job.isMinMaxShadow );
+  h.add( ( int )job.isMidPointShadow );
+  h.add( ( int )job.shadowType );
+  h.add( ( int )job.shadowHiderType );
+  h.add( ( int )job.volume );
+  h.add( job.deepShadowOption );
+  h.add( ( int )job.deepShadows );
+  h.add( job.shadowPixelSamples );
+  h.add( job.shadowVolumeInterpretation );
+  h.add( ( int )job.isPoint );
+  h.add( ( int )job.pointDir );
+  h.add( job.jobOptions );
+  h.add( job.jobFrameRib );
+  h.add( ( int )job.everyFrame );
+  h.add( ( int )job.renderFrame );
+  h.add( job.shadowObjectSet );
+  h.add( ( int )m_chunkFrame );
+  h.add( baseShadowName );
+  int samples = ( doCameraMotion || liqglo_doMotion || liqglo_doDef ) ? liqglo_motionSamples : 1;
+  for ( int i = 0; i < samples && i < LIQMAXMOTIONSAMPLES; i++ ) hashCamera( h, job.camera[i] );
+
+  if ( job.isShadow && !fullShadowRib ) {
+    std::vector<structJob>::iterator reader = jobList.begin();
+    for ( ; reader != jobList.end(); ++reader ) {
+      if ( !reader->isShadow ||
+           reader->shadowObjectSet != job.shadowObjectSet ||
+           reader->everyFrame != job.everyFrame ||
+           reader->renderFrame != job.renderFrame ) continue;
+      for ( int i = 0; i < samples && i < LIQMAXMOTIONSAMPLES; i++ ) hashCamera( h, reader->camera[i] );
+    }
+  }
+  return h.str();
+}
+
+// What is known of the map of a shadow : the fingerprint it is made from,
+// and the size and date of the map once rendered. Until the map changes
+// the record is pending and holds the map as it was before the render.
+struct shadowRecord {
+  std::string fingerprint;
+  bool        confirmed;
+  long        size;
+  long        mtime;
+};
+
+static bool readShadowRecord( const MString &recordName, shadowRecord &record )
+{
+  FILE *fp = fopen( recordName.asChar(), "r" );
+  if ( !fp ) return false;
+  char fingerprint[64] = "", state[16] = "";
+  bool read = fscanf( fp, "%63s %15s %ld %ld", fingerprint, state, &record.size, &record.mtime ) == 4;
+  fclose( fp );
+  record.fingerprint = fingerprint;
+  record.confirmed = !strcmp( state, "confirmed" );
+  return read;
+}
+
+static void writeShadowRecord( const MString &recordName, const shadowRecord &record )
+{
+  FILE *fp = fopen( recordName.asChar(), "w" );
+  if ( !fp ) return;
+  fprintf( fp, "%s %s %ld %ld\n", record.fingerprint.c_str(), record.confirmed ? "confirmed" : "pending", record.size, record.mtime );
+  fclose( fp );
+}
+
+// size and date of a map, a size of -1 if there is none
+static void mapState( const MString &mapName, long &size, long &mtime )
+{
+  struct stat mapStat;
+  if ( stat( mapName.asChar(), &mapStat ) ) {
+    size = -1;
+    mtime = 0;
+  } else {
+    size = ( long )mapStat.st_size;
+    mtime = ( long )mapStat.st_mtime;
+  }
+}
+
+/**
+ * Check the map of a shadow job against its fingerprint. The map is up to
+ * date if it was rendered from the same fingerprint and hasn't changed
+ * since, or if a map made from it earlier in the export can be copied.
+ * Otherwise the job is recorded as pending, with the map as it is before
+ * the render : the next export confirms it once the map changed.
+ */
+bool liqRibTranslator::shadowUpToDate( structJob &job, const MString &fingerprint )
+{
+  MString mapName = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, job.imageName, liqglo_projectDir );
+  MString recordName = mapName + ".fingerprint";
+  shadowRecord record;
+  long size, mtime;
+  mapState( mapName, size, mtime );
+  if ( readShadowRecord( recordName, record ) ) {
+    if ( !record.confirmed && size >= 0 && ( size != record.size || mtime != record.mtime ) ) {
+      record.confirmed = true;
+      record.size = size;
+      record.mtime = mtime;
+      writeShadowRecord( recordName, record );
+    }
+    if ( record.confirmed && size >= 0 && size == record.size && mtime == record.mtime && record.fingerprint == fingerprint.asChar() ) {
+      if ( !m_shadowSources.count( record.fingerprint ) ) {
+        shadowSource &source = m_shadowSources[ record.fingerprint ];
+        source.mapName = mapName;
+        source.imageName = job.imageName;
+        source.frame = liqglo_lframe;
+        source.current = true;
+      }
+      return true;
+    }
+  }
+
+  std::map<std::string, shadowSource>::iterator source = m_shadowSources.find( fingerprint.asChar() );
+  if ( source != m_shadowSources.end() && source->second.mapName != mapName ) {
+    if ( source->second.current ) {
+      if ( liquidCopyFile( source->second.mapName, mapName ) ) {
+        if ( debugMode ) printf( "-> shadow %s copied from %s\n", mapName.asChar(), source->second.mapName.asChar() );
+        record.fingerprint = fingerprint.asChar();
+        record.confirmed = true;
+        mapState( mapName, record.size, record.mtime );
+        writeShadowRecord( recordName, record );
+        return true;
+      }
+    } else if ( source->second.frame != liqglo_lframe ) {
+      // the render script copies the map once its frame rendered it
+      job.copyOf = source->second.imageName;
+      job.copyAfter = source->second.frame;
+    }
+  }
+
+  record.fingerprint = fingerprint.asChar();
+  record.confirmed = false;
+  record.size = size;
+  record.mtime = mtime;
+  writeShadowRecord( recordName, record );
+  if ( source == m_shadowSources.end() ) {
+    shadowSource &pending = m_shadowSources[ record.fingerprint ];
+    pending.mapName = mapName;
+    pending.imageName = job.imageName;
+    pending.frame = liqglo_lframe;
+    pending.current = false;
+  }
+  return false;
+}
+
+/**
+ * In incremental mode, true if a RIB was made from the same inputs by the
+ * previous export and needs not be written again.
+ */
+bool liqRibTranslator::ribUpToDate( const MString &ribName, const MString &inputs )
+{
+  if ( !m_incrementalRibs || !liqRibManifest::upToDate( ribName, inputs ) ) return false;
+  if ( debugMode ) printf( "-> %s is up to date\n", ribName.asChar() );
+  return true;
+}
+
+/**
+ * The file a RIB is written to : in incremental mode it is written aside
+ * and ribWritten() decides if it replaces the previous one.
+ */
+MString liqRibTranslator::ribOutputName( const MString &ribName )
+{
+  return m_incrementalRibs ? liqRibManifest::pendingName( ribName ) : ribName;
+}
+
+/**
+ * Keep the RIB just written if it differs from the previous export, and
+ * record the inputs it was made from.
+ */
+void liqRibTranslator::ribWritten( const MString &ribName, const MString &inputs )
+{
+  if ( !m_incrementalRibs ) return;
+  if ( liqRibManifest::commit( ribName, inputs ) ) {
+    cout << "Liquid : rewrote " << ribName.asChar() << endl;
+  } else if ( debugMode ) {
+    printf( "-> %s is unchanged\n", ribName.asChar() );
+  }
+}
+
+/**
+ * Skip the rendering of a shadow job whose rib was just written, if its
+ * map is up to date. A map to be copied from an earlier frame is noted in
+ * the shadow list for the render script.
+ */
+void liqRibTranslator::skipUpToDateShadow( structJob &job )
+{
+  MString fingerprint = shadowFingerprint( job );
+  if ( fingerprint == "" ) return;
+  bool upToDate = shadowUpToDate( job, fingerprint );
+
+  if ( debugMode && upToDate ) printf( "-> shadow %s is up to date\n", job.imageName.asChar() );
+  job.skip = upToDate;
+  std::vector<structJob>::iterator shadow = shadowList.begin();
+  while ( shadow != shadowList.end() ) {
+    if ( shadow->ribFileName != job.ribFileName ) ++shadow;
+    else if ( upToDate ) shadow = shadowList.erase( shadow );
+    else {
+      shadow->copyOf = job.copyOf;
+      shadow->copyAfter = job.copyAfter;
+      ++shadow;
+    }
+  }
+}
+
+/**
+ * Wait for the processes writing the jobs of a scan, then catch up with
+ * what they did : the shadow archives written and the shadows found up to
+ * date.
+ */
+bool liqRibTranslator::joinJobWorkers( std::vector<int> &workers, const std::vector<unsigned> &jobWorkers, unsigned groupBegin, unsigned groupEnd )
+{
+  bool succeeded = liqProcessLauncher::waitWorkers( workers );
+  workers.clear();
+  for ( unsigned j = groupBegin; j < groupEnd; j++ ) {
+    structJob &job = jobList[j];
+    if ( !jobWorkers[j] || job.skip || !job.isShadow ) continue;
+    if ( !fullShadowRib ) {
+      std::vector<structJob>::iterator iterCheck = jobList.begin();
+      for ( ; iterCheck != jobList.end(); ++iterCheck ) {
+        if ( iterCheck->shadowObjectSet == job.shadowObjectSet &&
+             iterCheck->everyFrame == job.everyFrame &&
+             iterCheck->renderFrame == job.renderFrame ) iterCheck->shadowArchiveRibDone = true;
+      }
+      m_alfShadowRibGen = true;
+    }
+    if ( succeeded && m_lazyCompute && !( m_chunkFrames > 1 && job.everyFrame ) ) skipUpToDateShadow( job );
+  }
+  return succeeded;
+}
+
 // Hmmmmm should change magic to Liquid
 MString liqRibTranslator::magic("##Liquid");
 
@@ -239,7 +678,7 @@ void *liqRibTranslator::creator()
 // replace expression with calculated values
 void liqRibTranslator::scanExpressions( liqShader & currentShader )
 {
-  for ( int i = 0; i < currentShader.numTPV; i++ ) {
+  for ( unsigned i = 0; i < currentShader.tokenPointerArray.size(); i++ ) {
     if ( currentShader.tokenPointerArray[i].getParameterType() == rString )
       processExpression( &currentShader.tokenPointerArray[i] );
     }
@@ -284,7 +723,7 @@ void liqRibTranslator::processExpression( liqTokenPointer *token, liqRibLightDat
         case exp_MakeTexture:
           {
             token->setTokenString( 0, expr.GetValue().asChar(), expr.GetValue().length() );
-            if ( !expr.destExists || !expr.destIsNewer ) {
+            if ( !expr.destUpToDate ) {
               LIQDEBUGPRINTF( "-> Making Texture: " );
 
               LIQDEBUGPRINTF( liquidRenderer.textureMaker.asChar() );
@@ -308,7 +747,7 @@ void liqRibTranslator::processExpression( liqTokenPointer *token, liqRibLightDat
                   break; // already have this job
                 ++iter;
               }
-              txtList.push_back( thisJob );
+              if ( iter == txtList.end() ) txtList.push_back( thisJob );
 
             }
           }
@@ -344,30 +783,41 @@ void liqRibTranslator::processExpression( liqTokenPointer *token, liqRibLightDat
 
 liqShader & liqRibTranslator::liqGetShader( MObject shaderObj )
 {
-  MString rmShaderStr;
-
   MFnDependencyNode shaderNode( shaderObj );
-  MPlug rmanShaderNamePlug = shaderNode.findPlug( MString( "rmanShaderLong" ) );
-  rmanShaderNamePlug.getValue( rmShaderStr );
-
-  LIQDEBUGPRINTF( "-> Using Renderman Shader " );
-
-  LIQDEBUGPRINTF( rmShaderStr.asChar() );
-  LIQDEBUGPRINTF( "\n" );
-
-
-  std::vector<liqShader>::iterator iter = m_shaders.begin();
-  while ( iter != m_shaders.end() ){
-    std::string shaderNodeName = shaderNode.name().asChar();
-    if ( iter->name == shaderNodeName ) {
-      // Already got it : nothing to do
-      return *iter;
+  double now = MAnimControl::currentTime().as( MTime::uiUnit() );
+
+  // shaders are kept by node name, and are never copied so the references
+  // handed out stay valid until the node changes or freeShaders()
+  std::string shaderNodeName = shaderNode.name().asChar();
+  std::map<std::string, shaderCacheEntry*>::iterator iter = m_shaders.find( shaderNodeName );
+  if ( iter != m_shaders.end() ) {
+    shaderCacheEntry *entry = iter->second;
+    if ( entry->node.isValid() && entry->node.object() == shaderObj ) {
+      if ( !entry->dirty && ( !entry->shader->isAnimated || entry->time == now ) ) {
+        return *entry->shader;
+      }
+      LIQDEBUGPRINTF( "-> updating shader %s\n", shaderNodeName.c_str() );
+      delete entry->shader;
+      entry->shader = new liqShader( shaderObj );
+      entry->dirty  = false;
+      entry->time   = now;
+      return *entry->shader;
     }
-    ++iter;
+    // another node took the name
+    MMessage::removeCallback( entry->callback );
+    delete entry->shader;
+    delete entry;
+    m_shaders.erase( iter );
   }
-  liqShader currentShader( shaderObj );
-  m_shaders.push_back( currentShader );
-  return m_shaders.back();
+
+  shaderCacheEntry *entry = new shaderCacheEntry;
+  entry->shader   = new liqShader( shaderObj );
+  entry->node     = MObjectHandle( shaderObj );
+  entry->dirty    = false;
+  entry->time     = now;
+  entry->callback = MNodeMessage::addAttributeChangedCallback( shaderObj, shaderChangedCallback, entry );
+  m_shaders[ shaderNodeName ] = entry;
+  return *entry->shader;
 }
 
 MStatus liqRibTranslator::liqShaderParseVectorAttr ( liqShader & currentShader, MFnDependencyNode & shaderNode, const char * argName, ParameterType pType )
@@ -376,11 +826,12 @@ MStatus liqRibTranslator::liqShaderParseVectorAttr ( liqShader & currentShader,
   MPlug triplePlug = shaderNode.findPlug( argName, &status );
   if ( status == MS::kSuccess ) {
     float x, y, z;
-    currentShader.tokenPointerArray[currentShader.numTPV].set( argName, pType, false, false, false, 0 );
+    liqTokenPointer &param = currentShader.nextParameter();
+    param.set( argName, pType, false, false, false, 0 );
     triplePlug.child( 0 ).getValue( x );
     triplePlug.child( 1 ).getValue( y );
     triplePlug.child( 2 ).getValue( z );
-    currentShader.tokenPointerArray[currentShader.numTPV].setTokenFloat( 0, x, y, z );
+    param.setTokenFloat( 0, x, y, z );
     currentShader.numTPV++;
   }
   return status;
@@ -458,6 +909,8 @@ liqRibTranslator::liqRibTranslator()
   liqglo_relativeFileNames = false;
 
   m_frameList.clear();
+  m_frameWorkers = 1;
+  m_frameWorker = 0;
   m_showProgress = false;
   m_deferredBlockSize = 1;
   m_deferredGen = false;
@@ -514,6 +967,7 @@ liqRibTranslator::liqRibTranslator()
   ignoreFilmGate = true;
   // renderAllCameras = true;               UN-USED GLOBAL
   m_lazyCompute = false;
+  m_cullShadowObjects = true;
   m_outputShadersInShadows = false;
   m_outputShadersInDeepShadows = false;
   m_outputLightsInDeepShadows = false;
@@ -555,6 +1009,18 @@ liqRibTranslator::liqRibTranslator()
   m_postFrameCommand.clear();
   m_preFrameCommand.clear();
   m_outputComments = false;
+  m_groupByMaterial = false;
+  m_textureProcesses = 4;
+  m_ribJobProcesses = 1;
+  m_jobWorker = 0;
+  m_cullCameraObjects = false;
+  m_cullMargin = 0.1;
+  m_cullDistance = 0.0;
+  m_shareGeometry = false;
+  m_incrementalRibs = false;
+  m_frameChunkSize = 1;
+  m_chunkFrames = 1;
+  m_chunkFrame = false;
   m_shaderDebug = false;
   // raytracing
   rt_useRayTracing = false;
@@ -666,6 +1132,12 @@ liqRibTranslator::liqRibTranslator()
   m_noDirCheck      = false;
   liqglo_ribDir = "rib";
   liqglo_textureDir = "rmantex";
+  liqglo_useParticleCache = false;
+  liqglo_particleCacheDir = "";
+  liqglo_polygonLOD = false;
+  liqglo_polygonLODArea = 10000.0;
+  liqglo_ribGenThreads = 1;
+  liqglo_outputAllShaderParams = false;
 
   m_beautyRibFile.clear();
   m_shadowRibFile.clear();
@@ -752,6 +1224,8 @@ MSyntax liqRibTranslator::syntax()
   syntax.addFlag("sdb",   "shaderDebug");
   syntax.addFlag("n",     "sequence",             MSyntax::kLong, MSyntax::kLong, MSyntax::kLong);
   syntax.addFlag("fl",    "frameList",            MSyntax::kString);
+  syntax.addFlag("fw",    "frameWorkers",         MSyntax::kLong);
+  syntax.addFlag("fcs",   "frameChunkSize",       MSyntax::kLong);
   syntax.addFlag("m",     "mbSamples",            MSyntax::kLong);
   syntax.addFlag("dbs",   "defBlock");
   syntax.addFlag("cam",   "camera",               MSyntax::kString);
@@ -823,6 +1297,20 @@ MStatus liqRibTranslator::liquidDoArgs( MArgList args )
     return MS::kFailure;
   }
 
+  // the arguments go in the RIB fingerprints, but for the frames to export
+  // and the processes exporting them
+  m_outputArgs.clear();
+  for ( unsigned i = 0; i < args.length(); i++ ) {
+    MString arg = args.asString( i, &status );
+    if ( status != MS::kSuccess ) {
+      arg.set( args.asDouble( i ) );
+      status.clear();
+    }
+    if ( arg == "-n" || arg == "-sequence" ) i += 3;
+    else if ( arg == "-fl" || arg == "-frameList" || arg == "-fw" || arg == "-frameWorkers" ) i++;
+    else m_outputArgs += arg + " ";
+  }
+
   // find the activeView for previews;
   m_activeView = M3dView::active3dView();
   width        = m_activeView.portWidth();
@@ -956,6 +1444,16 @@ MStatus liqRibTranslator::liquidDoArgs( MArgList args )
       LIQCHECKSTATUS(status, "error in -frameList parameter");  i++;
       m_frameList = args.asString( i, &status );
       LIQCHECKSTATUS(status, "error in -frameList parameter");
+    } else if ((arg == "-fw") || (arg == "-frameWorkers")) {
+      LIQCHECKSTATUS(status, "error in -frameWorkers parameter");  i++;
+      argValue = args.asString( i, &status );
+      m_frameWorkers = argValue.asInt();
+      LIQCHECKSTATUS(status, "error in -frameWorkers parameter");
+    } else if ((arg == "-fcs") || (arg == "-frameChunkSize")) {
+      LIQCHECKSTATUS(status, "error in -frameChunkSize parameter");  i++;
+      argValue = args.asString( i, &status );
+      m_frameChunkSize = argValue.asInt();
+      LIQCHECKSTATUS(status, "error in -frameChunkSize parameter");
     } else if ((arg == "-m") || (arg == "-mbSamples")) {
       LIQCHECKSTATUS(status, "error in -mbSamples parameter");   i++;
       argValue = args.asString( i, &status );
@@ -1959,6 +2457,33 @@ void liqRibTranslator::liquidReadGlobals()
   gPlug = rGlobalNode.findPlug( "shaderDebug", &gStatus );
   if ( gStatus == MS::kSuccess ) gPlug.getValue( m_shaderDebug );
   gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "groupByMaterial", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_groupByMaterial );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "textureProcesses", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_textureProcesses );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "ribJobProcesses", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_ribJobProcesses );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "cullCameraObjects", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_cullCameraObjects );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "cullMargin", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_cullMargin );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "cullDistance", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_cullDistance );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "shareGeometry", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_shareGeometry );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "incrementalRibs", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_incrementalRibs );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "frameChunkSize", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_frameChunkSize );
+  gStatus.clear();
   gPlug = rGlobalNode.findPlug( "deferredGen", &gStatus );
   if ( gStatus == MS::kSuccess ) gPlug.getValue( m_deferredGen );
   gStatus.clear();
@@ -2011,6 +2536,9 @@ void liqRibTranslator::liquidReadGlobals()
   gPlug = rGlobalNode.findPlug( "lazyCompute", &gStatus );
   if ( gStatus == MS::kSuccess ) gPlug.getValue( m_lazyCompute );
   gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "cullShadowObjects", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( m_cullShadowObjects );
+  gStatus.clear();
   gPlug = rGlobalNode.findPlug( "outputShadersInShadows", &gStatus );
   if ( gStatus == MS::kSuccess ) gPlug.getValue( m_outputShadersInShadows );
   gStatus.clear();
@@ -2024,6 +2552,29 @@ void liqRibTranslator::liquidReadGlobals()
   gPlug = rGlobalNode.findPlug( "outputMeshUVs", &gStatus );
   if ( gStatus == MS::kSuccess ) gPlug.getValue( liqglo_outputMeshUVs );
   gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "polygonLOD", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( liqglo_polygonLOD );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "polygonLODArea", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( liqglo_polygonLODArea );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "ribGenThreads", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( liqglo_ribGenThreads );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "outputAllShaderParams", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( liqglo_outputAllShaderParams );
+  gStatus.clear();
+  gPlug = rGlobalNode.findPlug( "useParticleCache", &gStatus );
+  if ( gStatus == MS::kSuccess ) gPlug.getValue( liqglo_useParticleCache );
+  gStatus.clear();
+  {
+    MString varVal;
+    gPlug = rGlobalNode.findPlug( "particleCacheDirectory", &gStatus );
+    if ( gStatus == MS::kSuccess ) gPlug.getValue( varVal );
+    gStatus.clear();
+    liqglo_particleCacheDir = removeEscapes( parseString( varVal ) );
+    if ( liqglo_particleCacheDir != "" ) LIQ_ADD_SLASH_IF_NEEDED( liqglo_particleCacheDir );
+  }
   gPlug = rGlobalNode.findPlug( "compressedOutput", &gStatus );
   if ( gStatus == MS::kSuccess ) gPlug.getValue( liqglo_doCompression );
   gStatus.clear();
@@ -2467,6 +3018,17 @@ MString liqRibTranslator::generateShadowArchiveName( bool renderAllFrames, long
   return baseShadowName;
 }
 
+MString liqRibTranslator::generateGeometryArchiveName( long frame )
+{
+  MString baseGeometryName = liqglo_ribDir + liqglo_sceneName + "_GEOMETRY";
+  baseGeometryName += LIQ_ANIM_EXT;
+  baseGeometryName += extension;
+
+  char *baseGeometryRibName = (char *)alloca( baseGeometryName.length() + 11 );
+  sprintf( baseGeometryRibName, baseGeometryName.asChar(), liqglo_doExtensionPadding ? liqglo_outPadding : 0, ( int )frame );
+  return MString( baseGeometryRibName );
+}
+
 MString liqRibTranslator::generateFileName( fileGenMode mode, const structJob& job )
 {
   MString filename("");
@@ -2591,6 +3153,20 @@ MString liqRibTranslator::generateFileName( fileGenMode mode, const structJob& j
   return filename;
 }
 
+// Stops the frame export processes still running when the main process
+// leaves doIt() early, by a return or an exception : their frames would
+// never be merged. The normal path waits for them and clears the list.
+struct frameWorkersGuard {
+  std::vector<int> &workers;
+  frameWorkersGuard( std::vector<int> &w ) : workers( w ) {}
+  ~frameWorkersGuard()
+  {
+    if ( workers.empty() ) return;
+    liqProcessLauncher::killWorkers( workers );
+    workers.clear();
+  }
+};
+
 /**
  * This method actually does the renderman output.
  */
@@ -2647,6 +3223,10 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
 
 
 
+  if ( m_shareGeometry && !liquidRenderer.supports_INLINE_ARCHIVES ) {
+    MGlobal::displayWarning( "Liquid : the renderer has no inline archives, geometry is not shared between passes." );
+  }
+
   if ( !liquidBin && !m_deferredGen ) liquidInfo("Creating RIB <Press ESC To Cancel> ...");
 
   // Remember the frame the scene was at so we can restore it later.
@@ -2813,8 +3393,42 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
 
     int currentBlock = 0;
 
+    // consecutive frames can be rendered from a single RIB per job, which
+    // declares the options once and reads in the RIB of each frame. The
+    // renderer is then started once per chunk instead of once per frame.
+    m_chunkFrames = 1;
+    m_chunkFrame = false;
+    m_chunkJobs.clear();
+    m_shadowSources.clear();
+    if ( m_frameChunkSize > 1 && allFrames.length() > 1 && !m_deferredGen && !m_exportReadArchive && ( useRenderScript || !launchRender ) ) {
+      m_chunkFrames = m_frameChunkSize;
+    }
+    unsigned frameChunks = ( allFrames.length() + m_chunkFrames - 1 ) / m_chunkFrames;
+
+    // liquidBin can export the frames from several processes forked once
+    // the scene is loaded, each one taking every n-th chunk of frames. The
+    // render script jobs of the others are merged back by the main process.
+    std::vector<int> frameWorkers;
+    frameWorkersGuard workersGuard( frameWorkers );
+    std::map<unsigned, liqRenderScript::Job> frameScriptJobs;
+    unsigned frameWorkerCount = 1;
+    if ( liquidBin && m_frameWorkers > 1 && frameChunks > 1 && !m_deferredGen && ( useRenderScript || !launchRender ) ) {
+      frameWorkerCount = ( frameChunks < ( unsigned )m_frameWorkers )? frameChunks : m_frameWorkers;
+      cout << flush;
+      m_frameWorker = liqProcessLauncher::forkWorkers( frameWorkerCount, frameWorkers );
+      if ( debugMode && !m_frameWorker ) printf( "-> %u frames exported by %u processes\n", allFrames.length(), ( unsigned )frameWorkers.size() + 1 );
+    }
+
     for( frameIndex=0; frameIndex<allFrames.length(); frameIndex++ ) {
 
+      // the frames of workers that could not be started are ours
+      unsigned frameOwner = ( frameIndex / m_chunkFrames ) % frameWorkerCount;
+      if ( frameOwner != m_frameWorker && ( m_frameWorker || frameOwner <= frameWorkers.size() ) ) continue;
+
+      unsigned chunkBegin = frameIndex - frameIndex % m_chunkFrames;
+      bool chunkEnd = m_chunkFrames > 1 && ( frameIndex + 1 - chunkBegin == m_chunkFrames || frameIndex + 1 == allFrames.length() );
+      if ( frameIndex == chunkBegin ) m_chunkJobs.clear();
+
       liqglo_lframe = allFrames[frameIndex];
 
       if ( m_showProgress ) printProgress( 1, frameFirst, frameLast, liqglo_lframe );
@@ -2848,7 +3462,7 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
               lastGenFrame = frameLast;
             }
             std::stringstream ribGenExtras;
-            ribGenExtras << " -progress -noDef -nop -noalfred -projectDir " << liqglo_projectDir.asChar() << " -ribName " << liqglo_sceneName.asChar() << " -mf " << tempDefname.asChar() << " -n " << liqglo_lframe << " " << lastGenFrame << " " << frameBy;
+            ribGenExtras << " -progress -noDef -nop -noalfred -fcs 1 -projectDir " << liqglo_projectDir.asChar() << " -ribName " << liqglo_sceneName.asChar() << " -mf " << tempDefname.asChar() << " -n " << liqglo_lframe << " " << lastGenFrame << " " << frameBy;
 
             std::stringstream titleStream;
             titleStream << liqglo_sceneName.asChar() << "FrameRIBGEN" << currentBlock;
@@ -2902,18 +3516,39 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
         if ( jobList.size() == 0 ) {
           MGlobal::displayWarning( "Liquid : Nothing to Render !" );
           cout <<"Liquid : Nothing to Render !"<<endl;
+          if ( m_frameWorker ) _exit( 0 );
+          liqMeshLOD::clearCache();
           return MS::kSuccess;
         }
 
         //cout <<"Job iteration start -------------------------------------"<<endl;
         //cout <<"    nsfs:"<<liqglo_noSingleFrameShadows<<"  sfso:"<<liqglo_singleFrameShadowsOnly<<endl;
 
+        // jobs of the current scan shared out to worker processes
+        std::vector<int>      workers;
+        std::vector<unsigned> jobWorkers;
+        unsigned groupBegin = 0, groupEnd = 0;
+
         std::vector<structJob>::iterator iter = jobList.begin();
         for (; iter != jobList.end(); ++iter ) {
 
           m_currentMatteMode = false;
           liqglo_currentJob = *iter;
 
+          unsigned jobIndex = iter - jobList.begin();
+          if ( groupEnd && jobIndex >= groupEnd ) {
+            if ( m_jobWorker ) {
+              fflush( NULL );
+              _exit( 0 );
+            }
+            bool joined = joinJobWorkers( workers, jobWorkers, groupBegin, groupEnd );
+            groupEnd = 0;
+            if ( !joined ) {
+              MGlobal::displayError( "Liquid : a RIB job process failed" );
+              break;
+            }
+          }
+
           if ( liqglo_currentJob.skip ) {
             //cout <<">> skipping "<<liqglo_currentJob.name<<endl;
             continue;
@@ -2939,7 +3574,6 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
             if ( hashTableInited && NULL != htable ) {
               //cout <<"delete old table... "<<flush;
               delete htable;
-              freeShaders();
               htable = NULL;
             }
 
@@ -2990,8 +3624,76 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
             // mark the frame as already scanned
             lastScannedFrame = scanTime;
             liqglo_currentJob = *iter;
+
+            // resolve the light linking once if a job of the frame needs it
+            for ( std::vector<structJob>::iterator linkJob = iter; linkJob != jobList.end() && linkJob->renderFrame == scanTime; ++linkJob ) {
+              if ( !linkJob->isShadow || linkJob->deepShadows && m_outputLightsInDeepShadows && !m_ignoreLights ) {
+                lightLinks();
+                break;
+              }
+            }
+
+            // in incremental mode, the jobs made from the same scan as
+            // their RIB on disk are not written again
+            m_scanInputs = m_incrementalRibs ? scanFingerprint( scanTime ) : MString( "" );
+
+            // write the shapes once for all the jobs of the frame
+            m_geometryArchive.clear();
+            if ( m_shareGeometry && liquidRenderer.supports_INLINE_ARCHIVES ) geometryArchive( scanTime );
+
+            // in batch mode, the jobs using this scan are written by forked
+            // processes, each one with its own RIB context and copy of the
+            // scene. Jobs reading the same shadow archive stay together.
+            if ( m_ribJobProcesses > 1 && MGlobal::mayaState() != MGlobal::kInteractive ) {
+              groupBegin = groupEnd = jobIndex;
+              while ( groupEnd < jobList.size() && jobList[ groupEnd ].renderFrame == scanTime ) groupEnd++;
+              std::vector<std::string> keys;
+              jobWorkers.assign( jobList.size(), 0 );
+              for ( unsigned j = groupBegin; j < groupEnd; j++ ) {
+                if ( jobList[j].skip ) continue;
+                std::stringstream key;
+                if ( jobList[j].isShadow && !fullShadowRib ) key << jobList[j].shadowObjectSet.asChar() << "|" << jobList[j].everyFrame;
+                else key << "|job" << j;
+                unsigned k = std::find( keys.begin(), keys.end(), key.str() ) - keys.begin();
+                if ( k == keys.size() ) keys.push_back( key.str() );
+                jobWorkers[j] = k;
+              }
+              unsigned count = ( keys.size() < ( unsigned )m_ribJobProcesses )? keys.size() : m_ribJobProcesses;
+              if ( count > 1 ) {
+                for ( unsigned j = groupBegin; j < groupEnd; j++ ) jobWorkers[j] %= count;
+                cout << flush;
+                m_jobWorker = liqProcessLauncher::forkWorkers( count, workers );
+                if ( debugMode && !m_jobWorker ) printf( "-> %u jobs written by %u processes\n", groupEnd - groupBegin, ( unsigned )workers.size() + 1 );
+                // jobs of workers that could not be started are ours
+                if ( !m_jobWorker ) {
+                  for ( unsigned j = groupBegin; j < groupEnd; j++ ) {
+                    if ( jobWorkers[j] > workers.size() ) jobWorkers[j] = 0;
+                  }
+                }
+              } else {
+                groupEnd = 0;
+              }
+            }
+          }
+
+          // in chunk mode the job RIB only holds the frame, the chunk RIB
+          // written with the last frame of the chunk reads it in
+          m_chunkFrame = m_chunkFrames > 1 && liqglo_currentJob.everyFrame;
+          if ( m_chunkFrame ) {
+            chunkJob &chunk = m_chunkJobs[ jobIndex ];
+            if ( !chunk.frames.length() ) {
+              chunk.job = liqglo_currentJob;
+              MString ribFileName = liqglo_currentJob.ribFileName;
+              if ( ribFileName.length() > 4 && ribFileName.substring( ribFileName.length() - 4, ribFileName.length() - 1 ) == ".rib" ) {
+                ribFileName = ribFileName.substring( 0, ribFileName.length() - 5 );
+              }
+              chunk.ribFileName = ribFileName + ".chunk.rib";
+            }
+            chunk.frames.append( liqglo_currentJob.ribFileName );
           }
 
+          if ( groupEnd && jobWorkers[ jobIndex ] != m_jobWorker ) continue;
+
 
           //
           // start scene parsing ------------------------------------------------------------------
@@ -3035,35 +3737,43 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
           // world RiReadArchives and Rib Boxes ************************************************
           //
 
+          // in incremental mode, a RIB made from the same inputs by the
+          // previous export is left as it is
+          MString jobInputs = jobFingerprint( liqglo_currentJob );
+
           if ( liqglo_currentJob.isShadow && !liqglo_currentJob.shadowArchiveRibDone && !fullShadowRib ) {
             //
             //  create the read-archive shadow files
             //
+            MString archiveName = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, baseShadowName, liqglo_projectDir );
+            if ( !ribUpToDate( archiveName, jobInputs ) ) {
 #if !defined(PRMAN) || defined(GENERIC_RIBLIB)
-            LIQDEBUGPRINTF( "-> beginning rib output\n" );
-            RiBegin( const_cast<char *>( LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, baseShadowName, liqglo_projectDir ).asChar() ) );
+              LIQDEBUGPRINTF( "-> beginning rib output\n" );
+              RiBegin( const_cast<char *>( ribOutputName( archiveName ).asChar() ) );
 #else
-            liqglo_ribFP = fopen( LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, baseShadowName, liqglo_projectDir ).asChar(), "w" );
-            if ( liqglo_ribFP ) {
-              LIQDEBUGPRINTF( "-> setting pipe option\n" );
-              RtInt ribFD = fileno( liqglo_ribFP );
-              RiOption( "rib", "pipe", &ribFD, RI_NULL );
-            }
-            LIQDEBUGPRINTF( "-> beginning rib output\n" );
-            RiBegin( RI_NULL );
+              liqglo_ribFP = fopen( ribOutputName( archiveName ).asChar(), "w" );
+              if ( liqglo_ribFP ) {
+                LIQDEBUGPRINTF( "-> setting pipe option\n" );
+                RtInt ribFD = fileno( liqglo_ribFP );
+                RiOption( "rib", "pipe", &ribFD, RI_NULL );
+              }
+              LIQDEBUGPRINTF( "-> beginning rib output\n" );
+              RiBegin( RI_NULL );
 #endif
-            if ( worldPrologue() != MS::kSuccess ) break;
-            if( liqglo_currentJob.isShadow && liqglo_currentJob.deepShadows && m_outputLightsInDeepShadows ) {
-              if ( lightBlock() != MS::kSuccess ) break;
-            }
-            if ( coordSysBlock() != MS::kSuccess ) break;
-            if ( objectBlock() != MS::kSuccess ) break;
-            if ( worldEpilogue() != MS::kSuccess ) break;
-            RiEnd();
+              if ( worldPrologue() != MS::kSuccess ) break;
+              if( liqglo_currentJob.isShadow && liqglo_currentJob.deepShadows && m_outputLightsInDeepShadows ) {
+                if ( lightBlock() != MS::kSuccess ) break;
+              }
+              if ( coordSysBlock() != MS::kSuccess ) break;
+              if ( objectBlock() != MS::kSuccess ) break;
+              if ( worldEpilogue() != MS::kSuccess ) break;
+              RiEnd();
 #if defined(PRMAN) && !defined(GENERIC_RIBLIB)
-            fclose( liqglo_ribFP );
+              fclose( liqglo_ribFP );
 #endif
-            liqglo_ribFP = NULL;
+              liqglo_ribFP = NULL;
+              ribWritten( archiveName, jobInputs );
+            }
             //m_shadowRibGen = true;      // UN-USED
 
             // mark all other jobs with the same set as done
@@ -3079,80 +3789,101 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
 
             m_alfShadowRibGen = true;
           }
+          MString ribName = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, liqglo_currentJob.ribFileName, liqglo_projectDir );
+          if ( !ribUpToDate( ribName, jobInputs ) ) {
 #if !defined(PRMAN) || defined(GENERIC_RIBLIB)
-          RiBegin( const_cast<char *>( LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, liqglo_currentJob.ribFileName, liqglo_projectDir ).asChar() ) );
+            RiBegin( const_cast<char *>( ribOutputName( ribName ).asChar() ) );
 
   #ifdef DELIGHT
-          LIQDEBUGPRINTF( "-> setting binary option\n" );
-          {
-            RtString format[1] = {"ascii"};
-            if ( liqglo_doBinary ) format[0] = "binary";
-            RiOption( "rib", "format", ( RtPointer )&format, RI_NULL);
-          }
+            LIQDEBUGPRINTF( "-> setting binary option\n" );
+            {
+              RtString format[1] = {"ascii"};
+              if ( liqglo_doBinary ) format[0] = "binary";
+              RiOption( "rib", "format", ( RtPointer )&format, RI_NULL);
+            }
   #endif
 #else
-          liqglo_ribFP = fopen( LIQ_GET_ABS_REL_FILE_NAME(liqglo_relativeFileNames, liqglo_currentJob.ribFileName, liqglo_projectDir ).asChar(), "w" );
-
-          if ( liqglo_ribFP ) {
-            RtInt ribFD = fileno( liqglo_ribFP );
-            RiOption( ( RtToken )"rib", ( RtToken )"pipe", &ribFD, RI_NULL );
-          } else {
-
-            // if this happens in interactive mode, Maya will crash !
-            // I completely removed the possibility to inadvertently output
-            // to stdout. if you want to do so, pass "-" as your RIB name.
-            MString error( "Error opening rib !" );
-            throw error;
+            liqglo_ribFP = fopen( ribOutputName( ribName ).asChar(), "w" );
 
-          }
-          RiBegin( RI_NULL );
-#endif
-          /* cout <<"* outputing "<<liqglo_currentJob.name.asChar()<<endl; */
+            if ( liqglo_ribFP ) {
+              RtInt ribFD = fileno( liqglo_ribFP );
+              RiOption( ( RtToken )"rib", ( RtToken )"pipe", &ribFD, RI_NULL );
+            } else {
 
-          if ( liqglo_currentJob.isShadow && !fullShadowRib ) {
+              // if this happens in interactive mode, Maya will crash !
+              // I completely removed the possibility to inadvertently output
+              // to stdout. if you want to do so, pass "-" as your RIB name.
+              MString error( "Error opening rib !" );
+              throw error;
 
-            // reference the correct shadow archive
-            //
-            /* cout <<"  * referencing shadow archive "<<baseShadowName.asChar()<<endl; */
-            if ( ribPrologue( liqglo_currentJob.isShadow ) == MS::kSuccess ) {
-              if ( framePrologue( scanTime ) != MS::kSuccess ) break;
-              MString realShadowName = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, baseShadowName, liqglo_projectDir );
-              RiArchiveRecord( RI_COMMENT, "Read Archive Data: \nReadArchive \"%s\"", realShadowName.asChar() );
-              if ( frameEpilogue( scanTime ) != MS::kSuccess ) break;
-              ribEpilogue();
             }
-          } else {
+            RiBegin( RI_NULL );
+#endif
+            /* cout <<"* outputing "<<liqglo_currentJob.name.asChar()<<endl; */
+
+            if ( liqglo_currentJob.isShadow && !fullShadowRib ) {
+
+              // reference the correct shadow archive
+              //
+              /* cout <<"  * referencing shadow archive "<<baseShadowName.asChar()<<endl; */
+              if ( ribPrologue( liqglo_currentJob.isShadow ) == MS::kSuccess ) {
+                if ( framePrologue( scanTime ) != MS::kSuccess ) break;
+                MString realShadowName = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, baseShadowName, liqglo_projectDir );
+                RiArchiveRecord( RI_COMMENT, "Read Archive Data: \nReadArchive \"%s\"", realShadowName.asChar() );
+                if ( frameEpilogue( scanTime ) != MS::kSuccess ) break;
+                ribEpilogue();
+              }
+            } else {
 
-            // full beauty/shadow rib generation
-            //
-            /* cout <<"  * build full rib"<<endl; */
-            if ( ribPrologue( liqglo_currentJob.isShadow ) == MS::kSuccess ) {
-              if ( framePrologue( scanTime ) != MS::kSuccess ) break;
-              if ( worldPrologue() != MS::kSuccess ) break;
-              if ( !liqglo_currentJob.isShadow || (liqglo_currentJob.isShadow && liqglo_currentJob.deepShadows && m_outputLightsInDeepShadows) ) {
-                if ( lightBlock() != MS::kSuccess ) break;
+              // full beauty/shadow rib generation
+              //
+              /* cout <<"  * build full rib"<<endl; */
+              if ( ribPrologue( liqglo_currentJob.isShadow ) == MS::kSuccess ) {
+                if ( framePrologue( scanTime ) != MS::kSuccess ) break;
+                if ( worldPrologue() != MS::kSuccess ) break;
+                if ( !liqglo_currentJob.isShadow || (liqglo_currentJob.isShadow && liqglo_currentJob.deepShadows && m_outputLightsInDeepShadows) ) {
+                  if ( lightBlock() != MS::kSuccess ) break;
+                }
+                if ( coordSysBlock() != MS::kSuccess ) break;
+                if ( objectBlock() != MS::kSuccess ) break;
+                if ( worldEpilogue() != MS::kSuccess ) break;
+                if ( frameEpilogue( scanTime ) != MS::kSuccess ) break;
+                ribEpilogue();
               }
-              if ( coordSysBlock() != MS::kSuccess ) break;
-              if ( objectBlock() != MS::kSuccess ) break;
-              if ( worldEpilogue() != MS::kSuccess ) break;
-              if ( frameEpilogue( scanTime ) != MS::kSuccess ) break;
-              ribEpilogue();
             }
-          }
 
-          RiEnd();
+            RiEnd();
 #if defined(PRMAN) && !defined(GENERIC_RIBLIB)
-          fclose( liqglo_ribFP );
+            fclose( liqglo_ribFP );
 #endif
-          liqglo_ribFP = NULL;
+            liqglo_ribFP = NULL;
+            ribWritten( ribName, jobInputs );
+          }
+
+          // in lazy compute mode, shadow maps rendered from the same rib
+          // as the one we just wrote are kept. Chunks are rendered whole.
+          if ( liqglo_currentJob.isShadow && m_lazyCompute && !m_chunkFrame ) skipUpToDateShadow( *iter );
           if ( m_showProgress ) printProgress( 3, frameFirst, frameLast, liqglo_lframe );
         }
 
+        // workers are done once out of the job loop, the main process
+        // still has to wait for them if the last jobs were shared out
+        if ( m_jobWorker ) {
+          fflush( NULL );
+          _exit( iter == jobList.end() ? 0 : 1 );
+        }
+        if ( groupEnd && !joinJobWorkers( workers, jobWorkers, groupBegin, groupEnd ) ) {
+          MGlobal::displayError( "Liquid : a RIB job process failed" );
+        }
+
         if ( hashTableInited && NULL != htable ) {
           delete htable;
-          freeShaders();
           htable = NULL;
         }
+        if ( debugMode ) lmemReport();
+
+        m_chunkFrame = false;
+        if ( chunkEnd && iter == jobList.end() && writeChunkRibs() != MS::kSuccess ) break;
       }
 
       // set the rib file for the 'view last rib' menu command
@@ -3214,6 +3945,17 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
             ts << "Shadows." << liqglo_lframe;
             shadowJob.title = ts.str();
             while ( iter != shadowList.end() ) {
+              // the shadows of a chunk are rendered with its last frame
+              MString ribFileName = iter->ribFileName;
+              const chunkJob *chunk = NULL;
+              if ( m_chunkFrames > 1 && iter->everyFrame ) {
+                chunk = chunkEnd ? chunkOf( ribFileName ) : NULL;
+                if ( !chunk ) {
+                  ++iter;
+                  continue;
+                }
+                ribFileName = chunk->ribFileName;
+              }
               alf_shadows = true;
               liqRenderScript::Job shadowSubtask;
               shadowSubtask.title = iter->name.asChar();
@@ -3234,17 +3976,30 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
                 shadowSubtask.childJobs.push_back(instanceJob);
               }
               std::stringstream ss;
-              if ( useNetRman ) {
+              if ( iter->copyOf != "" ) {
+                // made from the same inputs as a map of an earlier frame
+                std::stringstream ts;
+                ts << "Shadows." << iter->copyAfter;
+                liqRenderScript::Job instanceJob;
+                instanceJob.isInstance = true;
+                instanceJob.title = ts.str();
+                shadowSubtask.childJobs.push_back( instanceJob );
+#ifdef _WIN32
+                ss << framePreCommand.asChar() << " " << CP_CMD << " \"" << iter->copyOf.asChar() << "\" \"" << iter->imageName.asChar() << "\"";
+#else
+                ss << framePreCommand.asChar() << " " << CP_CMD << " " << iter->copyOf.asChar() << " " << iter->imageName.asChar();
+#endif
+              } else if ( useNetRman ) {
 #ifdef _WIN32
-                ss << framePreCommand.asChar() << " netrender %H -Progress \"" << iter->ribFileName.asChar() << "\"";
+                ss << framePreCommand.asChar() << " netrender %H -Progress \"" << ribFileName.asChar() << "\"";
 #else
-                ss << framePreCommand.asChar() << " netrender %H -Progress " << iter->ribFileName.asChar();
+                ss << framePreCommand.asChar() << " netrender %H -Progress " << ribFileName.asChar();
 #endif
               } else {
 #ifdef _WIN32
-                ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " \"" << iter->ribFileName.asChar() << "\"";
+                ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " \"" << ribFileName.asChar() << "\"";
 #else
-                ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " " << iter->ribFileName.asChar();
+                ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " " << ribFileName.asChar();
 #endif
               }
               liqRenderScript::Cmd cmd(ss.str(), (remoteRender && !useNetRman));
@@ -3258,12 +4013,21 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
               if (cleanRib)  {
                 std::stringstream ss;
 #ifdef _WIN32
-                ss << framePreCommand.asChar() << " " << RM_CMD << " \"" << iter->ribFileName.asChar() << "\"";
+                ss << framePreCommand.asChar() << " " << RM_CMD << " \"" << ribFileName.asChar() << "\"";
 #else
-                ss << framePreCommand.asChar() << " " << RM_CMD << " " << iter->ribFileName.asChar();
+                ss << framePreCommand.asChar() << " " << RM_CMD << " " << ribFileName.asChar();
 #endif
 
                 shadowSubtask.cleanupCommands.push_back( liqRenderScript::Cmd( ss.str(), remoteRender ) );
+                for ( unsigned f = 0; chunk && f < chunk->frames.length(); f++ ) {
+                  std::stringstream ss;
+#ifdef _WIN32
+                  ss << framePreCommand.asChar() << " " << RM_CMD << " \"" << chunk->frames[f].asChar() << "\"";
+#else
+                  ss << framePreCommand.asChar() << " " << RM_CMD << " " << chunk->frames[f].asChar();
+#endif
+                  shadowSubtask.cleanupCommands.push_back( liqRenderScript::Cmd( ss.str(), remoteRender ) );
+                }
               }
               shadowSubtask.chaserCommand = ( std::string( "sho \"" ) + iter->imageName.asChar() + "\"" );
 
@@ -3272,7 +4036,8 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
 
               shadowJob.childJobs.push_back( shadowSubtask );
             }
-            frameScriptJob.childJobs.push_back( shadowJob );
+            if ( shadowJob.childJobs.size() ) frameScriptJob.childJobs.push_back( shadowJob );
+            else alf_shadows = false;
           }
         }
         LIQDEBUGPRINTF( "-> finished writing out shadow information to render script file.\n" );
@@ -3344,27 +4109,51 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
         }
         LIQDEBUGPRINTF( "-> hero pass set.\n" );
 
-        LIQDEBUGPRINTF( "-> writing out pre frame command information to render script file.\n" );
-        if ( framePreFrameCommand != MString("") ) {
-          liqRenderScript::Cmd cmd(framePreFrameCommand.asChar(), (remoteRender && !useNetRman));
-          cmd.alfredServices = m_alfredServices.asChar();
-          cmd.alfredTags     = m_alfredTags.asChar();
-          frameScriptJob.commands.push_back(cmd);
-        }
+        // the passes of a chunk are rendered from the chunk RIBs with its
+        // last frame, once the jobs of the other frames are done
+        bool renderPasses = true;
+        MString heroRib, shadowPassRib;
+        const chunkJob *heroChunk = NULL;
+        const chunkJob *shadowPassChunk = NULL;
+        if ( m_outputHeroPass ) heroRib = frameJob->ribFileName;
+        if ( m_outputShadowPass ) shadowPassRib = shadowPassJob->ribFileName;
+        if ( m_chunkFrames > 1 ) {
+          renderPasses = chunkEnd;
+          if ( chunkEnd ) {
+            for ( unsigned f = chunkBegin; f < frameIndex; f++ ) {
+              std::stringstream ss;
+              ss << liqglo_sceneName.asChar() << "Frame" << allFrames[f];
+              liqRenderScript::Job instanceJob;
+              instanceJob.isInstance = true;
+              instanceJob.title = ss.str();
+              frameScriptJob.childJobs.push_back( instanceJob );
+            }
+            if ( m_outputHeroPass && ( heroChunk = chunkOf( heroRib ) ) ) heroRib = heroChunk->ribFileName;
+            if ( m_outputShadowPass && ( shadowPassChunk = chunkOf( shadowPassRib ) ) ) shadowPassRib = shadowPassChunk->ribFileName;
+          }
+        }
 
-        if ( m_outputHeroPass ) {
+        LIQDEBUGPRINTF( "-> writing out pre frame command information to render script file.\n" );
+        if ( framePreFrameCommand != MString("") ) {
+          liqRenderScript::Cmd cmd(framePreFrameCommand.asChar(), (remoteRender && !useNetRman));
+          cmd.alfredServices = m_alfredServices.asChar();
+          cmd.alfredTags     = m_alfredTags.asChar();
+          frameScriptJob.commands.push_back(cmd);
+        }
+
+        if ( m_outputHeroPass && renderPasses ) {
           std::stringstream ss;
           if ( useNetRman ) {
 #ifdef _WIN32
-            ss << framePreCommand.asChar() << " netrender %H -Progress \"" << frameJob->ribFileName.asChar() << "\"";
+            ss << framePreCommand.asChar() << " netrender %H -Progress \"" << heroRib.asChar() << "\"";
 #else
-            ss << framePreCommand.asChar() << " netrender %H -Progress " << frameJob->ribFileName.asChar();
+            ss << framePreCommand.asChar() << " netrender %H -Progress " << heroRib.asChar();
 #endif
           } else {
 #ifdef _WIN32
-            ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " \"" << frameJob->ribFileName.asChar() << "\"";
+            ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " \"" << heroRib.asChar() << "\"";
 #else
-            ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " " << frameJob->ribFileName.asChar();
+            ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " " << heroRib.asChar();
 #endif
           }
           liqRenderScript::Cmd cmd(ss.str(), (remoteRender && !useNetRman));
@@ -3377,19 +4166,19 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
         }
         LIQDEBUGPRINTF( "-> finished writing out hero information to alfred file.\n" );
 
-        if ( m_outputShadowPass ) {
+        if ( m_outputShadowPass && renderPasses ) {
           std::stringstream ss;
           if ( useNetRman ) {
 #ifdef _WIN32
-            ss << framePreCommand.asChar() << " netrender %H -Progress \"" << shadowPassJob->ribFileName.asChar() << "\"";
+            ss << framePreCommand.asChar() << " netrender %H -Progress \"" << shadowPassRib.asChar() << "\"";
 #else
-            ss << framePreCommand.asChar() << " netrender %H -Progress " << shadowPassJob->ribFileName.asChar();
+            ss << framePreCommand.asChar() << " netrender %H -Progress " << shadowPassRib.asChar();
 #endif
           } else {
 #ifdef _WIN32
-            ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " \"" << shadowPassJob->ribFileName.asChar() << "\"";
+            ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " \"" << shadowPassRib.asChar() << "\"";
 #else
-            ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " " << shadowPassJob->ribFileName.asChar();
+            ss << framePreCommand.asChar() << " " << frameRenderCommand.asChar() << " " << shadowPassRib.asChar();
 #endif
           }
           liqRenderScript::Cmd cmd(ss.str(), (remoteRender && !useNetRman));
@@ -3402,20 +4191,20 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
         }
 
         if ( cleanRib || ( framePostFrameCommand != MString( "" ) ) ) {
-          if ( cleanRib ) {
+          if ( cleanRib && renderPasses ) {
             std::stringstream ss;
             if ( m_outputHeroPass  ) {
 #ifdef _WIN32
-              ss << framePreCommand.asChar() << " " << RM_CMD << " \"" << frameJob->ribFileName.asChar() << "\"";
+              ss << framePreCommand.asChar() << " " << RM_CMD << " \"" << heroRib.asChar() << "\"";
 #else
-              ss << framePreCommand.asChar() << " " << RM_CMD << " " << frameJob->ribFileName.asChar();
+              ss << framePreCommand.asChar() << " " << RM_CMD << " " << heroRib.asChar();
 #endif
             }
             if ( m_outputShadowPass) {
 #ifdef _WIN32
-              ss << framePreCommand.asChar() << " " << RM_CMD << " \"" << shadowPassJob->ribFileName.asChar() << "\"";
+              ss << framePreCommand.asChar() << " " << RM_CMD << " \"" << shadowPassRib.asChar() << "\"";
 #else
-              ss << framePreCommand.asChar() << " " << RM_CMD << " " << shadowPassJob->ribFileName.asChar();
+              ss << framePreCommand.asChar() << " " << RM_CMD << " " << shadowPassRib.asChar();
 #endif
             }
             if ( m_alfShadowRibGen ) {
@@ -3426,16 +4215,28 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
 #endif
             }
             frameScriptJob.cleanupCommands.push_back(liqRenderScript::Cmd(ss.str(), remoteRender));
+            const chunkJob *chunks[2] = { heroChunk, shadowPassChunk };
+            for ( unsigned c = 0; c < 2; c++ ) {
+              for ( unsigned f = 0; chunks[c] && f < chunks[c]->frames.length(); f++ ) {
+                std::stringstream ss;
+#ifdef _WIN32
+                ss << framePreCommand.asChar() << " " << RM_CMD << " \"" << chunks[c]->frames[f].asChar() << "\"";
+#else
+                ss << framePreCommand.asChar() << " " << RM_CMD << " " << chunks[c]->frames[f].asChar();
+#endif
+                frameScriptJob.cleanupCommands.push_back( liqRenderScript::Cmd( ss.str(), remoteRender ) );
+              }
+            }
           }
           if ( framePostFrameCommand != MString("") ) {
             liqRenderScript::Cmd cmd(framePostFrameCommand.asChar(), (remoteRender && !useNetRman));
             frameScriptJob.cleanupCommands.push_back(cmd);
           }
         }
-        if ( m_outputHeroPass ) {
+        if ( m_outputHeroPass && renderPasses ) {
           frameScriptJob.chaserCommand = (std::string( "sho \"" ) + frameJob->imageName.asChar() + "\"" );
         }
-        if ( m_outputShadowPass ) {
+        if ( m_outputShadowPass && renderPasses ) {
           frameScriptJob.chaserCommand = (std::string( "sho \"" ) + shadowPassJob->imageName.asChar() + "\"" );
         }
         if ( m_outputShadowPass && !m_outputHeroPass ) {
@@ -3445,11 +4246,55 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
         }
       }
 
-      jobScript.addJob( frameScriptJob );
+      if ( frameWorkerCount > 1 ) frameScriptJobs[ frameIndex ] = frameScriptJob;
+      else jobScript.addJob( frameScriptJob );
 
       if ( ( ribStatus != kRibOK ) && !m_deferredGen ) break;
     } // frame for-loop
 
+    if ( frameWorkerCount > 1 ) {
+      MString framesName = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, renderScriptName, liqglo_projectDir ) + ".frames";
+      if ( m_frameWorker ) {
+        std::stringstream workerName;
+        workerName << framesName.asChar() << m_frameWorker;
+        std::ofstream framesFile( workerName.str().c_str() );
+        std::map<unsigned, liqRenderScript::Job>::const_iterator frameJob;
+        for ( frameJob = frameScriptJobs.begin(); frameJob != frameScriptJobs.end(); ++frameJob ) {
+          framesFile << " " << frameJob->first;
+          frameJob->second.save( framesFile );
+        }
+        framesFile.close();
+        fflush( NULL );
+        _exit( ( ribStatus == kRibOK && frameIndex == allFrames.length() && framesFile ) ? 0 : 1 );
+      }
+
+      unsigned workerCount = frameWorkers.size();
+      bool succeeded = liqProcessLauncher::waitWorkers( frameWorkers );
+      frameWorkers.clear();
+      for ( unsigned w = 1; w <= workerCount; w++ ) {
+        std::stringstream workerName;
+        workerName << framesName.asChar() << w;
+        std::ifstream framesFile( workerName.str().c_str() );
+        unsigned index;
+        while ( framesFile >> index ) {
+          if ( !frameScriptJobs[ index ].load( framesFile ) ) {
+            succeeded = false;
+            break;
+          }
+        }
+        framesFile.close();
+        remove( workerName.str().c_str() );
+      }
+      std::map<unsigned, liqRenderScript::Job>::const_iterator frameJob;
+      for ( frameJob = frameScriptJobs.begin(); frameJob != frameScriptJobs.end(); ++frameJob ) {
+        jobScript.addJob( frameJob->second );
+      }
+      if ( !succeeded ) {
+        MGlobal::displayError( "Liquid : a frame export process failed" );
+        ribStatus = kRibError;
+      }
+    }
+
     if ( useRenderScript ) {
       if ( m_preJobCommand != MString( "" ) ) {
         jobScript.addLeafDependency( preJobInstance );
@@ -3532,22 +4377,38 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
         cout <<endl;
         int exitstat = 0;
 
-        // write out make texture pass
-        std::vector<structJob>::iterator iter = txtList.begin();
-        while ( iter != txtList.end() ) {
+        // write out make texture pass, the conversions run side by side
+        if ( txtList.size() ) {
           MGlobal::displayInfo( "Making textures... " );
-          cout << "[!] Making textures: " << iter->imageName.asChar() << endl;
+          std::vector<MString> commands;
+          std::vector<structJob>::iterator iter = txtList.begin();
+          while ( iter != txtList.end() ) {
+            cout << "[!] Making textures: " << iter->imageName.asChar() << endl;
 #ifdef _WIN32
-          liqProcessLauncher::execute( iter->renderName, "\"" + iter->ribFileName + "\"", liqglo_projectDir, true );
+            commands.push_back( iter->renderName + " \"" + iter->ribFileName + "\"" );
 #else
-          liqProcessLauncher::execute( iter->renderName, iter->ribFileName, liqglo_projectDir, true );
+            commands.push_back( iter->renderName + " " + iter->ribFileName );
 #endif
-          ++iter;
+            ++iter;
+          }
+          std::vector<bool> succeeded;
+          liqProcessLauncher::execute( commands, liqglo_projectDir, m_textureProcesses, succeeded );
+          for ( unsigned i = 0; i < txtList.size(); i++ ) {
+            if ( succeeded[i] ) liqTextureCache::converted( liqglo_textureDir + txtList[i].imageName );
+            else cout << "[!] Could not make texture " << txtList[i].imageName.asChar() << endl;
+          }
         }
 
-        if ( liqglo_doShadows ) {
+        // shadow and reflection maps are rendered side by side on up to
+        // maxCPU processors, reflections waiting for the shadows they may see
+        liqRenderScript localScript;
+        liqRenderScript::Job mapsJob;
+        mapsJob.title = "Maps";
+        if ( liqglo_doShadows && shadowList.size() ) {
           MGlobal::displayInfo( "Rendering shadow maps... " );
           cout << endl << "[!] Rendering shadow maps... " << endl;
+          liqRenderScript::Job shadowJob;
+          shadowJob.title = "Shadows";
           std::vector<structJob>::iterator iter = shadowList.begin();
           while ( iter != shadowList.end() ) {
             if ( iter->skip ) {
@@ -3556,14 +4417,48 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
               continue;
             }
             cout << "    + " << iter->ribFileName.asChar() << endl;
+            liqRenderScript::Job shadowSubtask;
+            shadowSubtask.title = iter->ribFileName.asChar();
 #ifdef _WIN32
-            if( !liqProcessLauncher::execute( liquidRenderer.renderCommand, liquidRenderer.renderCmdFlags + " \"" + iter->ribFileName + "\"", liqglo_projectDir, true ) )
+            MString cmd = liquidRenderer.renderCommand + " " + liquidRenderer.renderCmdFlags + " \"" + iter->ribFileName + "\"";
 #else
-            if( !liqProcessLauncher::execute( liquidRenderer.renderCommand, liquidRenderer.renderCmdFlags + " " + iter->ribFileName, liqglo_projectDir, true ) )
+            MString cmd = liquidRenderer.renderCommand + " " + liquidRenderer.renderCmdFlags + " " + iter->ribFileName;
 #endif
-              break;
+            shadowSubtask.commands.push_back( liqRenderScript::Cmd( cmd.asChar(), false ) );
+            shadowJob.childJobs.push_back( shadowSubtask );
+            ++iter;
+          }
+          mapsJob.childJobs.push_back( shadowJob );
+        }
+        if ( refList.size() ) {
+          MGlobal::displayInfo( "Rendering reflection maps... " );
+          cout << "[!] Rendering reflection maps... " << endl;
+          liqRenderScript::Job shadowsInstance;
+          shadowsInstance.title = "Shadows";
+          shadowsInstance.isInstance = true;
+          std::vector<structJob>::iterator iter = refList.begin();
+          while ( iter != refList.end() ) {
+            cout << "    + " << iter->ribFileName.asChar() << endl;
+            liqRenderScript::Job reflectSubtask;
+            reflectSubtask.title = iter->ribFileName.asChar();
+            reflectSubtask.childJobs.push_back( shadowsInstance );
+            MString cmd = iter->renderName + " " + iter->ribFileName;
+            reflectSubtask.commands.push_back( liqRenderScript::Cmd( cmd.asChar(), false ) );
+            mapsJob.childJobs.push_back( reflectSubtask );
             ++iter;
-          } // while ( iter != shadowList.end() )
+          }
+        }
+        if ( mapsJob.childJobs.size() ) {
+          localScript.addJob( mapsJob );
+          std::set<std::string> failed;
+          if ( !localScript.execute( liqglo_projectDir, ( m_maxCPU > 1 )? m_maxCPU : 1, failed ) ) {
+            std::set<std::string>::const_iterator rib;
+            for ( rib = failed.begin(); rib != failed.end(); ++rib ) {
+              cout << "[!] Could not render " << rib->c_str() << endl;
+            }
+            MGlobal::displayError( "Liquid : maps failed to render, the hero pass is not rendered" );
+            exitstat = 1;
+          }
         }
         if ( !exitstat ) {
           MGlobal::displayInfo( "Rendering hero pass... " );
@@ -3596,6 +4491,15 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
       }
     } // if ( launchRender )
 
+    // decimated meshes and shaders are only shared within one export
+    liqMeshLOD::clearCache();
+    freeShaders();
+    liqTokenPointer::releaseNames();
+    liqTextureCache::save();
+    if ( m_incrementalRibs ) liqRibManifest::save();
+    liqRibGenRegistry::unloadAll();
+    larenaRelease();
+
     // return to the frame we were at before we ran the animation
     LIQDEBUGPRINTF( "-> setting frame to current frame.\n" );
     MGlobal::viewFrame (originalTime);
@@ -3618,15 +4522,22 @@ MStatus liqRibTranslator::doIt( const MArgList& args )
     } else {
       MGlobal::displayError( errorMessage );
     }
+    // a job RIB or frame process has nothing to clean up for the main one
+    if ( m_jobWorker || m_frameWorker ) _exit( 1 );
     if ( NULL != htable && hashTableInited ) delete htable;
+    liqMeshLOD::clearCache();
     freeShaders();
+    liqTokenPointer::releaseNames();
     if ( debugMode ) ldumpUnfreed();
     m_escHandler.endComputation();
     return MS::kFailure;
   } catch ( ... ) {
     cerr << "RIB Export: Unknown exception thrown\n" << endl;
+    if ( m_jobWorker || m_frameWorker ) _exit( 1 );
     if ( NULL != htable && hashTableInited ) delete htable;
+    liqMeshLOD::clearCache();
     freeShaders();
+    liqTokenPointer::releaseNames();
     if ( debugMode ) ldumpUnfreed();
     m_escHandler.endComputation();
     return MS::kFailure;
@@ -4048,14 +4959,6 @@ MStatus liqRibTranslator::buildJobs()
           }
 
 
-          // in lazy compute mode, we check if the map is already on disk first.
-          if ( m_lazyCompute && computeShadow ) {
-            MString fileName;
-            fileName = generateFileName( (fileGenMode) fgm_shadow_tex, thisJob );
-            if ( fileExists( fileName ) ) computeShadow = false;
-          }
-
-
           //
           // store the main shadow map    *****************************
           //
@@ -4129,11 +5032,6 @@ MStatus liqRibTranslator::buildJobs()
             }
 
 
-            MString fileName;
-            fileName = generateFileName( (fileGenMode) fgm_shadow_tex, thisJob );
-            if ( m_lazyCompute ) {
-              if ( fileExists( fileName ) ) computeShadow = false;
-            }
             if ( computeShadow ) jobList.push_back( thisJob );
           }
         }
@@ -4187,12 +5085,6 @@ MStatus liqRibTranslator::buildJobs()
             shadowCamParamPlug = shadowCamDepNode.findPlug( "liqShadingRateFactor", &status );
             if ( status == MS::kSuccess ) shadowCamParamPlug.getValue( thisJob.shadingRateFactor );
 
-            // test if the file is already on disk...
-            if ( m_lazyCompute ) {
-              MString fileName = generateFileName( (fileGenMode) fgm_shadow_tex, thisJob );
-              if ( fileExists( fileName ) ) continue;
-            }
-
             jobList.push_back( thisJob );
 
           }
@@ -4266,6 +5158,7 @@ MStatus liqRibTranslator::buildJobs()
     //
     iter->skip   = false;
     thisJob.skip = false;
+    iter->copyOf = "";
 
     if ( thisJob.isShadow ) {
       if ( !liqglo_doShadows ) {
@@ -4345,10 +5238,11 @@ MStatus liqRibTranslator::buildJobs()
 /**
  * Write the prologue for the RIB file.
  * This includes all RI options but not the camera transformation.
+ * The frames of a chunk leave them to the chunk RIB.
  */
 MStatus liqRibTranslator::ribPrologue( bool isShadow )
 {
-  if ( !m_exportReadArchive ) {
+  if ( !m_exportReadArchive && !m_chunkFrame ) {
     LIQDEBUGPRINTF( "-> beginning to write prologue\n" );
 
     // general info for traceability
@@ -4586,6 +5480,60 @@ MStatus liqRibTranslator::ribEpilogue()
   return (ribStatus == kRibOK ? MS::kSuccess : MS::kFailure);
 }
 
+/**
+ * Write the RIB of each job of the chunk of frames just exported : the
+ * options are declared once, then the frames are read in order.
+ */
+MStatus liqRibTranslator::writeChunkRibs()
+{
+  std::map<unsigned, chunkJob>::const_iterator chunk;
+  for ( chunk = m_chunkJobs.begin(); chunk != m_chunkJobs.end(); ++chunk ) {
+    liqglo_currentJob = chunk->second.job;
+    MString ribName = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, chunk->second.ribFileName, liqglo_projectDir );
+#if !defined(PRMAN) || defined(GENERIC_RIBLIB)
+    RiBegin( const_cast<char *>( ribOutputName( ribName ).asChar() ) );
+#else
+    liqglo_ribFP = fopen( ribOutputName( ribName ).asChar(), "w" );
+    if ( !liqglo_ribFP ) {
+      MString error( "Error opening rib !" );
+      throw error;
+    }
+    RtInt ribFD = fileno( liqglo_ribFP );
+    RiOption( ( RtToken )"rib", ( RtToken )"pipe", &ribFD, RI_NULL );
+    RiBegin( RI_NULL );
+#endif
+    if ( ribPrologue( liqglo_currentJob.isShadow ) == MS::kSuccess ) {
+      for ( unsigned f = 0; f < chunk->second.frames.length(); f++ ) {
+        MString frameRibName = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, chunk->second.frames[f], liqglo_projectDir );
+        RiArchiveRecord( RI_VERBATIM, "ReadArchive \"%s\"\n", frameRibName.asChar() );
+      }
+      ribEpilogue();
+    }
+    RiEnd();
+#if defined(PRMAN) && !defined(GENERIC_RIBLIB)
+    fclose( liqglo_ribFP );
+#endif
+    liqglo_ribFP = NULL;
+    ribWritten( ribName );
+    if ( ribStatus != kRibOK ) return MS::kFailure;
+  }
+  return MS::kSuccess;
+}
+
+/**
+ * The chunk a frame RIB of the current chunk is read by, NULL if it is
+ * not part of one.
+ */
+const liqRibTranslator::chunkJob *liqRibTranslator::chunkOf( const MString &frameRibName ) const
+{
+  std::map<unsigned, chunkJob>::const_iterator chunk;
+  for ( chunk = m_chunkJobs.begin(); chunk != m_chunkJobs.end(); ++chunk ) {
+    const MStringArray &frames = chunk->second.frames;
+    if ( frames.length() && frames[ frames.length() - 1 ] == frameRibName ) return &chunk->second;
+  }
+  return NULL;
+}
+
 /**
  * Scan the DAG at the given frame number and record information about the scene for writing.
  */
@@ -5779,6 +6727,341 @@ MStatus liqRibTranslator::frameEpilogue( long )
   return (ribStatus == kRibBegin ? MS::kSuccess : MS::kFailure);
 }
 
+/**
+ * Find the shaders an object is rendered with. The liquid shader nodes found
+ * are stored in the node's assignedShader, assignedDisp and assignedVolume.
+ */
+void liqRibTranslator::getShaderAssignment( liqRibNode *ribNode, shaderAssignment &shaders )
+{
+  MStatus status;
+  MFnDagNode fnDagNode( ribNode->path() );
+
+  shaders.hasSurfaceShader            = false;
+  shaders.hasDisplacementShader       = false;
+  shaders.hasVolumeShader             = false;
+  shaders.hasCustomSurfaceShader      = liqRegularShaderNode;
+  shaders.hasCustomDisplacementShader = liqRegularShaderNode;
+  shaders.hasCustomVolumeShader       = liqRegularShaderNode;
+  shaders.surfaceShaderRibBox         = "";
+  shaders.displacementShaderRibBox    = "";
+  shaders.volumeShaderRibBox          = "";
+
+  MPlug rmanShaderPlug;
+  // Check for surface shader
+  status.clear();
+  rmanShaderPlug = fnDagNode.findPlug( MString( "liquidSurfaceShaderNode" ), &status );
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "liquidSurfaceShaderNode" ), &status ); }
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShader.findPlug( MString( "liquidSurfaceShaderNode" ), &status ); }
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "surfaceShader" ), &status ); }
+  if ( status == MS::kSuccess && !rmanShaderPlug.isNull() ) {
+    if ( rmanShaderPlug.isConnected() ) {
+      MPlugArray rmShaderNodeArray;
+      rmanShaderPlug.connectedTo( rmShaderNodeArray, true, true );
+      MObject rmShaderNodeObj;
+      rmShaderNodeObj = rmShaderNodeArray[0].node();
+      MFnDependencyNode shaderDepNode( rmShaderNodeObj );
+      // philippe : we must check the node type to avoid checking in regular maya shaders
+      if ( shaderDepNode.typeName() == "liquidSurface" || shaderDepNode.typeName() == "oldBlindDataBase" ) {
+        //cout <<"setting shader"<<endl;
+        ribNode->assignedShader.setObject( rmShaderNodeObj );
+        shaders.hasSurfaceShader = true;
+      } else {
+        // Try to find a liqRIBBox attribute
+        MPlug ribbPlug = shaderDepNode.findPlug( MString( "liqRIBBox" ), &status );
+        if ( status == MS::kSuccess ) {
+          ribbPlug.getValue( shaders.surfaceShaderRibBox );
+          shaders.surfaceShaderRibBox = parseString(shaders.surfaceShaderRibBox);
+          shaders.hasSurfaceShader = true;
+          shaders.hasCustomSurfaceShader = liqRibBoxShader;
+        }
+      }
+    }
+  }
+  // Check for displacement shader
+  status.clear();
+  rmanShaderPlug = fnDagNode.findPlug( MString( "liquidDispShaderNode" ), &status );
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "liquidDispShaderNode" ), &status ); }
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedDisp.findPlug( MString( "liquidDispShaderNode" ), &status ); }
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "displacementShader" ), &status ); }
+  if ( ( status == MS::kSuccess ) && !rmanShaderPlug.isNull() && !m_ignoreDisplacements ) {
+    if ( rmanShaderPlug.isConnected() ) {
+      MPlugArray rmShaderNodeArray;
+      rmanShaderPlug.connectedTo( rmShaderNodeArray, true, true );
+      MObject rmShaderNodeObj;
+      rmShaderNodeObj = rmShaderNodeArray[0].node();
+      MFnDependencyNode shaderDepNode( rmShaderNodeObj );
+      // philippe : we must check the node type to avoid checking in regular maya shaders
+      if ( shaderDepNode.typeName() == "liquidDisplacement" || shaderDepNode.typeName() == "oldBlindDataBase" ) {
+        ribNode->assignedDisp.setObject( rmShaderNodeObj );
+        shaders.hasDisplacementShader = true;
+      } else {
+        // Try to find a liqRIBBox attribute
+        MPlug ribbPlug = shaderDepNode.findPlug( MString( "liqRIBBox" ), &status );
+        if ( status == MS::kSuccess ) {
+          ribbPlug.getValue( shaders.displacementShaderRibBox );
+          shaders.displacementShaderRibBox = parseString(shaders.displacementShaderRibBox);
+          shaders.hasDisplacementShader = true;
+          shaders.hasCustomDisplacementShader = liqRibBoxShader;
+        }
+      }
+    }
+  }
+  // Check for volume shader
+  status.clear();
+  rmanShaderPlug = fnDagNode.findPlug( MString( "liquidVolumeShaderNode" ), &status );
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "liquidVolumeShaderNode" ), &status ); }
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedVolume.findPlug( MString( "liquidVolumeShaderNode" ), &status ); }
+  if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "volumeShader" ), &status ); }
+  if ( ( status == MS::kSuccess ) && !rmanShaderPlug.isNull() && !m_ignoreVolumes ) {
+    if ( rmanShaderPlug.isConnected() ) {
+      MPlugArray rmShaderNodeArray;
+      rmanShaderPlug.connectedTo( rmShaderNodeArray, true, true );
+      MObject rmShaderNodeObj;
+      rmShaderNodeObj = rmShaderNodeArray[0].node();
+      MFnDependencyNode shaderDepNode( rmShaderNodeObj );
+      // philippe : we must check the node type to avoid checking in regular maya shaders
+      if ( shaderDepNode.typeName() == "liquidVolume" || shaderDepNode.typeName() == "oldBlindDataBase" ) {
+        ribNode->assignedVolume.setObject( rmShaderNodeObj );
+        shaders.hasVolumeShader = true;
+      } else {
+        // Try to find a liqRIBBox attribute
+        MPlug ribbPlug = shaderDepNode.findPlug( MString( "liqRIBBox" ), &status );
+        if ( status == MS::kSuccess ) {
+          ribbPlug.getValue( shaders.volumeShaderRibBox );
+          shaders.volumeShaderRibBox = parseString(shaders.volumeShaderRibBox);
+          shaders.hasVolumeShader = true;
+          shaders.hasCustomVolumeShader = liqRibBoxShader;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * The material group of an object : the names of its shader nodes, empty if
+ * its shaders can't be shared with other objects. A group binds its shaders
+ * before the transform of its members, so only shaders that set a shader
+ * space of their own can be shared : the others need the object transform
+ * as their "shader" space.
+ */
+std::string liqRibTranslator::materialKey( liqRibNode *ribNode, const shaderAssignment &shaders )
+{
+  if ( m_ignoreSurfaces || !shaders.hasSurfaceShader || shaders.hasCustomSurfaceShader ) return "";
+  if ( liqGetShader( ribNode->assignedShader.object() ).shaderSpace == "" ) return "";
+  std::string key = MFnDependencyNode( ribNode->assignedShader.object() ).name().asChar();
+  if ( shaders.hasDisplacementShader && !m_ignoreDisplacements ) {
+    if ( shaders.hasCustomDisplacementShader ) return "";
+    if ( liqGetShader( ribNode->assignedDisp.object() ).shaderSpace == "" ) return "";
+    key += " ";
+    key += MFnDependencyNode( ribNode->assignedDisp.object() ).name().asChar();
+  }
+  if ( shaders.hasVolumeShader && !m_ignoreVolumes ) {
+    if ( shaders.hasCustomVolumeShader ) return "";
+    if ( liqGetShader( ribNode->assignedVolume.object() ).shaderSpace == "" ) return "";
+    key += " ";
+    key += MFnDependencyNode( ribNode->assignedVolume.object() ).name().asChar();
+  }
+  return key;
+}
+
+/**
+ * Write the shaders of a material group, as objectBlock() would for any
+ * of its members without overrides. They all have their own shader space,
+ * see materialKey().
+ */
+void liqRibTranslator::writeMaterial( liqRibNode *ribNode, const shaderAssignment &shaders )
+{
+  if ( shaders.hasVolumeShader && !m_ignoreVolumes ) {
+    liqShader & currentShader = liqGetShader( ribNode->assignedVolume.object() );
+    if ( !currentShader.hasErrors && ( !liqglo_currentJob.isShadow || currentShader.outputInShadow ) ) writeShader( currentShader, SHADER_TYPE_VOLUME );
+  }
+
+  liqShader & currentShader = liqGetShader( ribNode->assignedShader.object() );
+  RiColor( currentShader.rmColor );
+  RiOpacity( currentShader.rmOpacity );
+  if ( !liqglo_currentJob.isShadow || currentShader.outputInShadow ) writeShader( currentShader, SHADER_TYPE_SURFACE );
+
+  if ( shaders.hasDisplacementShader && !m_ignoreDisplacements ) {
+    liqShader & currentShader = liqGetShader( ribNode->assignedDisp.object() );
+    if ( !currentShader.hasErrors && ( !liqglo_currentJob.isShadow || currentShader.outputInShadow ) ) writeShader( currentShader, SHADER_TYPE_DISPLACEMENT );
+  }
+}
+
+/**
+ * Write a RiSurface, RiDisplacement or RiAtmosphere call for a shader.
+ */
+void liqRibTranslator::writeShader( liqShader & currentShader, SHADER_TYPE type )
+{
+  unsigned numTokens = currentShader.tokenPointerArray.size();
+  RtToken *tokenArray = (RtToken *)alloca( sizeof(RtToken) * numTokens );
+  RtPointer *pointerArray = (RtPointer *)alloca( sizeof(RtPointer) * numTokens );
+  assignTokenArraysV( &currentShader.tokenPointerArray, tokenArray, pointerArray );
+
+  char *shaderFileName;
+  LIQ_GET_SHADER_FILE_NAME( shaderFileName, liqglo_shortShaderNames, currentShader );
+
+  // check shader space transformation
+  if ( currentShader.shaderSpace != "" ) {
+    RiTransformBegin();
+    RiCoordSysTransform( (char*) currentShader.shaderSpace.asChar() );
+  }
+  switch ( type ) {
+    case SHADER_TYPE_SURFACE:
+      RiSurfaceV( shaderFileName, numTokens, tokenArray, pointerArray );
+      break;
+    case SHADER_TYPE_DISPLACEMENT:
+      RiDisplacementV( shaderFileName, numTokens, tokenArray, pointerArray );
+      break;
+    case SHADER_TYPE_VOLUME:
+      RiAtmosphereV( shaderFileName, numTokens, tokenArray, pointerArray );
+      break;
+    default:
+      break;
+  }
+  if ( currentShader.shaderSpace != "" ) RiTransformEnd();
+}
+
+/**
+ * Get the displacement bound of an object, the larger of the ones of its
+ * surface and displacement shaders.
+ */
+void liqRibTranslator::getDisplacementBound( liqRibNode *ribNode, float &bound, MString &space )
+{
+  MStatus status;
+  float surfaceDisplacementBounds = 0.0;
+  MString surfaceDisplacementBoundsSpace = "shader";
+  MString tmpSpace = "";
+  if ( !ribNode->assignedShader.object().isNull() ) {
+    MPlug sDBPlug = ribNode->assignedShader.findPlug( MString( "displacementBound" ), &status );
+    if ( status == MS::kSuccess ) sDBPlug.getValue( surfaceDisplacementBounds );
+    MPlug sDBSPlug = ribNode->assignedShader.findPlug( MString( "displacementBoundSpace" ), &status );
+    if ( status == MS::kSuccess ) sDBSPlug.getValue( tmpSpace );
+    if ( tmpSpace != "" ) surfaceDisplacementBoundsSpace = tmpSpace;
+  }
+  float dispDisplacementBounds = 0.0;
+  MString dispDisplacementBoundsSpace = "shader";
+  tmpSpace = "";
+  status.clear();
+  if ( !ribNode->assignedDisp.object().isNull() ) {
+    MPlug dDBPlug = ribNode->assignedDisp.findPlug( MString( "displacementBound" ), &status );
+    if ( status == MS::kSuccess ) dDBPlug.getValue( dispDisplacementBounds );
+    MPlug sDBSPlug = ribNode->assignedDisp.findPlug( MString( "displacementBoundSpace" ), &status );
+    if ( status == MS::kSuccess ) sDBSPlug.getValue( tmpSpace );
+    if ( tmpSpace != "" ) dispDisplacementBoundsSpace = tmpSpace;
+  }
+
+  if ( ( dispDisplacementBounds != 0.0 ) && ( dispDisplacementBounds > surfaceDisplacementBounds ) ) {
+    bound = dispDisplacementBounds;
+    space = dispDisplacementBoundsSpace;
+  } else {
+    bound = surfaceDisplacementBounds;
+    space = surfaceDisplacementBoundsSpace;
+  }
+}
+
+/**
+ * Get the viewing volumes of a job camera, one per camera motion sample. The screen window is the one framePrologue() writes,
+ * grown on every side by margin times its size. A distance other than 0
+ * brings the far clipping plane closer.
+ */
+void liqRibTranslator::jobFrustums( const structJob &job, std::vector<liqFrustum> &frustums, double margin, double distance )
+{
+  int samples = ( doCameraMotion && ( !job.isShadow || job.deepShadows ) )? liqglo_motionSamples : 1;
+
+  for ( int sample = 0; sample < samples; sample++ ) {
+    const structCamera &camera = job.camera[ sample ];
+    double left, right, bottom, top;
+    if ( camera.isOrtho ) {
+      right = camera.orthoWidth  * 0.5;
+      top   = camera.orthoHeight * 0.5;
+      left   = -right;
+      bottom = -top;
+    } else {
+      // point light shadows have their field of view in degrees
+      double fieldOfView = camera.hFOV;
+      if ( job.isShadow && job.isPoint ) fieldOfView *= M_PI / 180.0;
+      double tangent = tan( fieldOfView * 0.5 );
+      if ( job.isShadow ) {
+        left = bottom = -tangent;
+        right = top = tangent;
+      } else {
+        double ratio = (double)job.width / (double)job.height;
+        left   = ( -ratio + camera.horizontalFilmOffset ) * tangent;
+        right  = (  ratio + camera.horizontalFilmOffset ) * tangent;
+        bottom = ( -1 + camera.verticalFilmOffset ) * tangent;
+        top    = (  1 + camera.verticalFilmOffset ) * tangent;
+        if ( liqglo_rotateCamera ) {
+          // the picture is turned on its side, keep both ways
+          double extent = std::max( std::max( -left, right ), std::max( -bottom, top ) );
+          left = bottom = -extent;
+          right = top = extent;
+        }
+      }
+    }
+    double width  = ( right - left ) * margin;
+    double height = ( top - bottom ) * margin;
+    left   -= width;
+    right  += width;
+    bottom -= height;
+    top    += height;
+
+    double fardb = ( distance > 0 && distance < camera.fardb )? distance : camera.fardb;
+    frustums.push_back( liqFrustum( camera.mat, camera.isOrtho, left, right, bottom, top, camera.neardb, fardb ) );
+  }
+}
+
+static bool hasRibString( const MString &value )
+{
+  return value != "" && value != "-";
+}
+
+/**
+ * Check if an object may show up in one of the viewing volumes. Objects
+ * that can't be bounded from Maya, are tagged liqNoCull or can be hit by
+ * rays in a beauty job are always in.
+ */
+bool liqRibTranslator::inFrustums( liqRibNode *ribNode, const std::vector<liqFrustum> &frustums )
+{
+  if ( !ribNode->hasWorldBound || ribNode->noCull ) return true;
+
+  if ( !liqglo_currentJob.isShadow && rt_useRayTracing &&
+       ( ribNode->visibility.trace || ribNode->visibility.diffuse || ribNode->visibility.specular ||
+         ribNode->visibility.newtransmission || ribNode->visibility.photon ||
+         ribNode->visibility.transmission != liqRibNode::visibility::TRANSMISSION_TRANSPARENT ) ) return true;
+
+  // rib boxes and archives bring in geometry Maya doesn't know the extent of
+  if ( hasRibString( ribNode->rib.box ) || hasRibString( ribNode->rib.readArchive ) || hasRibString( ribNode->rib.delayedReadArchive ) ||
+       hasRibString( ribNode->shadowRib.box ) || hasRibString( ribNode->shadowRib.readArchive ) || hasRibString( ribNode->shadowRib.delayedReadArchive ) ) return true;
+
+  MBoundingBox bound = ribNode->worldBound;
+
+  float displacementBound;
+  MString displacementSpace;
+  getDisplacementBound( ribNode, displacementBound, displacementSpace );
+  if ( displacementBound > 0 ) {
+    // outside of world space, grow the bound by the largest scale of the object
+    double padding = displacementBound;
+    if ( displacementSpace != "world" ) {
+      MMatrix matrix = ribNode->object( 0 )->matrix( ribNode->path().instanceNumber() );
+      double scale = 1.0;
+      for ( unsigned k = 0; k < 3; k++ ) {
+        double axis = MVector( matrix[k][0], matrix[k][1], matrix[k][2] ).length();
+        if ( axis > scale ) scale = axis;
+      }
+      padding *= scale;
+    }
+    MPoint min = bound.min();
+    MPoint max = bound.max();
+    bound.expand( min - MVector( padding, padding, padding ) );
+    bound.expand( max + MVector( padding, padding, padding ) );
+  }
+
+  for ( unsigned f = 0; f < frustums.size(); f++ ) {
+    if ( frustums[f].intersects( bound ) ) return true;
+  }
+  return false;
+}
+
 /**
  * Write out the body of the frame.
  * This is a dump of the DAG to RIB with flattened transforms (MtoR-style).
@@ -5800,6 +7083,11 @@ MStatus liqRibTranslator::objectBlock()
     RiArchiveRecord( RI_VERBATIM, "\n");
   }
 
+  // the shapes shared by all the jobs of the frame
+  if ( m_geometryArchive != "" ) {
+    RiArchiveRecord( RI_VERBATIM, "ReadArchive \"%s\"\n", m_geometryArchive.asChar() );
+  }
+
   // retrieve the shadow set object
   MObject shadowSetObj;
   if ( liqglo_currentJob.isShadow && liqglo_currentJob.shadowObjectSet != "" ) {
@@ -5821,9 +7109,29 @@ MStatus liqRibTranslator::objectBlock()
   MObject transform;
   MFnDagNode dagFn;
 
-  for ( RNMAP::iterator rniter = htable->RibNodeMap.begin(); rniter != htable->RibNodeMap.end(); rniter++ ) {
-    LIQ_CHECK_CANCEL_REQUEST;
+  // objects out of the view of a shadow can't cast into it, beauty jobs
+  // may leave out what is out of view with some margin too
+  std::vector<liqFrustum> frustums;
+  bool cullObjects = liqglo_currentJob.isShadow ? m_cullShadowObjects : m_cullCameraObjects;
+  if ( cullObjects ) {
+    if ( !liqglo_currentJob.isShadow ) jobFrustums( liqglo_currentJob, frustums, m_cullMargin, m_cullDistance );
+    else if ( fullShadowRib ) jobFrustums( liqglo_currentJob, frustums );
+    else {
+      // the shadow archive is read by all the shadows of the same set
+      std::vector<structJob>::iterator job = jobList.begin();
+      for ( ; job != jobList.end(); ++job ) {
+        if ( job->isShadow &&
+             job->shadowObjectSet == liqglo_currentJob.shadowObjectSet &&
+             job->everyFrame == liqglo_currentJob.everyFrame &&
+             job->renderFrame == liqglo_currentJob.renderFrame ) jobFrustums( *job, frustums );
+      }
+    }
+  }
+  unsigned culled = 0;
 
+  // objects of this job
+  std::vector<materialMember> objects;
+  for ( RNMAP::iterator rniter = htable->RibNodeMap.begin(); rniter != htable->RibNodeMap.end(); rniter++ ) {
     liqRibNode * ribNode = (*rniter).second;
     path = ribNode->path();
     transform = path.transform();
@@ -5837,6 +7145,96 @@ MStatus liqRibTranslator::objectBlock()
       //cout <<"SET FILTER : object "<<ribNode->name.asChar()<<" is NOT in "<<liqglo_currentJob.shadowObjectSet.asChar()<<endl;
       continue;
     }
+    if ( cullObjects && !inFrustums( ribNode, frustums ) ) {
+      culled++;
+      continue;
+    }
+    objects.push_back( materialMember() );
+    objects.back().ribNode = ribNode;
+    getShaderAssignment( ribNode, objects.back().shaders );
+  }
+  if ( culled ) {
+    if ( m_outputComments ) RiArchiveRecord( RI_COMMENT, "%u of %u objects out of view culled", culled, culled + (unsigned)objects.size() );
+    MString report = "Liquid : ";
+    report += liqglo_currentJob.name + " : ";
+    report += (int)culled;
+    report += " of ";
+    report += (int)( culled + objects.size() );
+    report += " objects out of view culled";
+    cout << report.asChar() << endl;
+    // RIB job and frame processes have no Maya session to show it in
+    if ( !m_jobWorker && !m_frameWorker ) MGlobal::displayInfo( report );
+  }
+
+  // thread safe ribgens of the objects kept are run up front on a pool,
+  // the loop below splices in what they wrote
+  if ( liqglo_ribGenThreads > 1 ) {
+    std::vector<liqRibGenData*> ribGens;
+    for ( unsigned o = 0; o < objects.size(); o++ ) {
+      if ( objects[o].ribNode->object(0)->type == MRT_RibGen ) ribGens.push_back( objects[o].ribNode->object(0)->ribGenData() );
+    }
+    if ( ribGens.size() ) liqRibGenData::generate( ribGens, liqglo_ribGenThreads );
+  }
+
+  bool writeShaders = true;
+
+  if ( liqglo_currentJob.isShadow &&
+       ( ( !liqglo_currentJob.deepShadows && !m_outputShadersInShadows ) ||
+         ( liqglo_currentJob.deepShadows && !m_outputShadersInDeepShadows ) ) )
+    writeShaders = false;
+
+  // objects sharing their shaders are gathered under one attribute block
+  // that binds the shaders once, only the per object state is left in
+  // their own blocks
+  if ( m_groupByMaterial && writeShaders ) {
+    std::map<std::string, unsigned> members;
+    for ( unsigned o = 0; o < objects.size(); o++ ) {
+      objects[o].material = materialKey( objects[o].ribNode, objects[o].shaders );
+      members[ objects[o].material ]++;
+    }
+    for ( unsigned o = 0; o < objects.size(); o++ ) {
+      if ( members[ objects[o].material ] < 2 ) objects[o].material.clear();
+    }
+    std::stable_sort( objects.begin(), objects.end() );
+  }
+
+  std::string material;
+  for ( unsigned o = 0; o < objects.size(); o++ ) {
+    if ( m_escHandler.isInterruptRequested() ) {
+      // leave the RIB balanced
+      if ( material != "" ) {
+        RiAttributeEnd();
+        attributeDepth--;
+      }
+      throw( LIQ_CANCEL_FEEDBACK_MESSAGE );
+    }
+
+    liqRibNode * ribNode = objects[o].ribNode;
+    path = ribNode->path();
+    transform = path.transform();
+
+    const shaderAssignment &shaders = objects[o].shaders;
+
+    if ( objects[o].material != material ) {
+      if ( material != "" ) {
+        RiAttributeEnd();
+        attributeDepth--;
+      }
+      material = objects[o].material;
+      if ( material != "" ) {
+        RiAttributeBegin();
+        attributeDepth++;
+        if ( m_outputComments ) RiArchiveRecord( RI_COMMENT, "Material: %s", material.c_str(), RI_NULL );
+        writeMaterial( ribNode, shaders );
+      }
+    }
+    bool grouped = material != "";
+
+    bool hasSurfaceShader                       = shaders.hasSurfaceShader;
+    bool hasDisplacementShader                  = shaders.hasDisplacementShader;
+    bool hasVolumeShader                        = shaders.hasVolumeShader;
+    liqDetailShaderKind hasCustomSurfaceShader  = shaders.hasCustomSurfaceShader;
+    MString surfaceShaderRibBox                 = shaders.surfaceShaderRibBox;
 
     if ( m_outputComments ) RiArchiveRecord( RI_COMMENT, "Name: %s", ribNode->name.asChar(), RI_NULL );
 
@@ -5878,25 +7276,11 @@ MStatus liqRibTranslator::objectBlock()
     MObject object;
 
     // Moritz: only write out light linking if we're not in a shadow pass
+    // the lights are all on after the light block, only the ones the
+    // object ignores are switched off. See lightLinks().
     if ( !liqglo_currentJob.isShadow || liqglo_currentJob.deepShadows && m_outputLightsInDeepShadows && !m_ignoreLights ) {
-      MObjectArray ignoredLights;
-      //ribNode->getIgnoredLights( ribNode->assignedShadingGroup.object(), ignoredLights );
-      ribNode->getIgnoredLights( ignoredLights );
-
-      for ( unsigned i=0; i<ignoredLights.length(); i++ )
-      {
-        MFnDagNode lightFnDag( ignoredLights[i] );
-        MString nodeName = lightFnDag.fullPathName();
-
-        if ( NULL != htable ) {
-          //RibNode * ln = htable->find( light, MRT_Light );
-          MDagPath nodeDagPath;
-          lightFnDag.getPath( nodeDagPath );
-          liqRibNode * ln = htable->find( lightFnDag.fullPathName(), nodeDagPath, MRT_Light );
-          if ( NULL != ln ) {
-            RiIlluminate( ln->object(0)->lightHandle(), RI_FALSE );
-          }
-        }
+      for ( unsigned i = 0; i < ribNode->ignoredLightBits.size(); i++ ) {
+        if ( ribNode->ignoredLightBits[i] ) RiIlluminate( m_linkedLights[i]->object(0)->lightHandle(), RI_FALSE );
       }
     }
 
@@ -5938,146 +7322,13 @@ MStatus liqRibTranslator::objectBlock()
       RiMotionEnd();
     }
 
-    // init variables
-    MFnDagNode fnDagNode( path );
-
-    typedef enum {
-      liqRegularShaderNode = 0,   // A regular Liquid node, keep it 0 to evaluate to false in conditions
-      liqCustomPxShaderNode = 1,  // A custom MPxNode inheriting from liqCustomNode
-      liqRibBoxShader = 2         // A rib box attached to the shader
-    } liqDetailShaderKind;
-
-    liqDetailShaderKind hasCustomSurfaceShader      = liqRegularShaderNode;
-    liqDetailShaderKind hasCustomDisplacementShader = liqRegularShaderNode;
-    liqDetailShaderKind hasCustomVolumeShader       = liqRegularShaderNode;
-    MString surfaceShaderRibBox( "" );
-    MString displacementShaderRibBox( "" );
-    MString volumeShaderRibBox( "" );
-    bool hasSurfaceShader       = false;
-    bool hasDisplacementShader  = false;
-    bool hasVolumeShader        = false;
-
-
-    MPlug rmanShaderPlug;
-    // Check for surface shader
-    status.clear();
-    rmanShaderPlug = fnDagNode.findPlug( MString( "liquidSurfaceShaderNode" ), &status );
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "liquidSurfaceShaderNode" ), &status ); }
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShader.findPlug( MString( "liquidSurfaceShaderNode" ), &status ); }
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "surfaceShader" ), &status ); }
-    if ( status == MS::kSuccess && !rmanShaderPlug.isNull() ) {
-      if ( rmanShaderPlug.isConnected() ) {
-        MPlugArray rmShaderNodeArray;
-        rmanShaderPlug.connectedTo( rmShaderNodeArray, true, true );
-        MObject rmShaderNodeObj;
-        rmShaderNodeObj = rmShaderNodeArray[0].node();
-        MFnDependencyNode shaderDepNode( rmShaderNodeObj );
-        // philippe : we must check the node type to avoid checking in regular maya shaders
-        if ( shaderDepNode.typeName() == "liquidSurface" || shaderDepNode.typeName() == "oldBlindDataBase" ) {
-          //cout <<"setting shader"<<endl;
-          ribNode->assignedShader.setObject( rmShaderNodeObj );
-          hasSurfaceShader = true;
-        } else {
-          // Try to find a liqRIBBox attribute
-          MPlug ribbPlug = shaderDepNode.findPlug( MString( "liqRIBBox" ), &status );
-          if ( status == MS::kSuccess ) {
-            ribbPlug.getValue( surfaceShaderRibBox );
-            surfaceShaderRibBox = parseString(surfaceShaderRibBox);
-            hasSurfaceShader = true;
-            hasCustomSurfaceShader = liqRibBoxShader;
-          }
-        }
-      }
-    }
-    // Check for displacement shader
-    status.clear();
-    rmanShaderPlug = fnDagNode.findPlug( MString( "liquidDispShaderNode" ), &status );
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "liquidDispShaderNode" ), &status ); }
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedDisp.findPlug( MString( "liquidDispShaderNode" ), &status ); }
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "displacementShader" ), &status ); }
-    if ( ( status == MS::kSuccess ) && !rmanShaderPlug.isNull() && !m_ignoreDisplacements ) {
-      if ( rmanShaderPlug.isConnected() ) {
-        MPlugArray rmShaderNodeArray;
-        rmanShaderPlug.connectedTo( rmShaderNodeArray, true, true );
-        MObject rmShaderNodeObj;
-        rmShaderNodeObj = rmShaderNodeArray[0].node();
-        MFnDependencyNode shaderDepNode( rmShaderNodeObj );
-        // philippe : we must check the node type to avoid checking in regular maya shaders
-        if ( shaderDepNode.typeName() == "liquidDisplacement" || shaderDepNode.typeName() == "oldBlindDataBase" ) {
-          ribNode->assignedDisp.setObject( rmShaderNodeObj );
-          hasDisplacementShader = true;
-        } else {
-          // Try to find a liqRIBBox attribute
-          MPlug ribbPlug = shaderDepNode.findPlug( MString( "liqRIBBox" ), &status );
-          if ( status == MS::kSuccess ) {
-            ribbPlug.getValue( displacementShaderRibBox );
-            displacementShaderRibBox = parseString(displacementShaderRibBox);
-            hasDisplacementShader = true;
-            hasCustomDisplacementShader = liqRibBoxShader;
-          }
-        }
-      }
-    }
-    // Check for volume shader
-    status.clear();
-    rmanShaderPlug = fnDagNode.findPlug( MString( "liquidVolumeShaderNode" ), &status );
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "liquidVolumeShaderNode" ), &status ); }
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedVolume.findPlug( MString( "liquidVolumeShaderNode" ), &status ); }
-    if ( ( status != MS::kSuccess ) || ( !rmanShaderPlug.isConnected() ) ) { status.clear(); rmanShaderPlug = ribNode->assignedShadingGroup.findPlug( MString( "volumeShader" ), &status ); }
-    if ( ( status == MS::kSuccess ) && !rmanShaderPlug.isNull() && !m_ignoreVolumes ) {
-      if ( rmanShaderPlug.isConnected() ) {
-        MPlugArray rmShaderNodeArray;
-        rmanShaderPlug.connectedTo( rmShaderNodeArray, true, true );
-        MObject rmShaderNodeObj;
-        rmShaderNodeObj = rmShaderNodeArray[0].node();
-        MFnDependencyNode shaderDepNode( rmShaderNodeObj );
-        // philippe : we must check the node type to avoid checking in regular maya shaders
-        if ( shaderDepNode.typeName() == "liquidVolume" || shaderDepNode.typeName() == "oldBlindDataBase" ) {
-          ribNode->assignedVolume.setObject( rmShaderNodeObj );
-          hasVolumeShader = true;
-        } else {
-          // Try to find a liqRIBBox attribute
-          MPlug ribbPlug = shaderDepNode.findPlug( MString( "liqRIBBox" ), &status );
-          if ( status == MS::kSuccess ) {
-            ribbPlug.getValue( volumeShaderRibBox );
-            volumeShaderRibBox = parseString(volumeShaderRibBox);
-            hasVolumeShader = true;
-            hasCustomVolumeShader = liqRibBoxShader;
-          }
-        }
-      }
-    }
-
     // displacement bounds
-    float surfaceDisplacementBounds = 0.0;
-    MString surfaceDisplacementBoundsSpace = "shader";
-    MString tmpSpace = "";
-    status.clear();
-    if ( !ribNode->assignedShader.object().isNull() ) {
-      MPlug sDBPlug = ribNode->assignedShader.findPlug( MString( "displacementBound" ), &status );
-      if ( status == MS::kSuccess ) sDBPlug.getValue( surfaceDisplacementBounds );
-      MPlug sDBSPlug = ribNode->assignedShader.findPlug( MString( "displacementBoundSpace" ), &status );
-      if ( status == MS::kSuccess ) sDBSPlug.getValue( tmpSpace );
-      if ( tmpSpace != "" ) surfaceDisplacementBoundsSpace = tmpSpace;
-    }
-    float dispDisplacementBounds = 0.0;
-    MString dispDisplacementBoundsSpace = "shader";
-    tmpSpace = "";
-    status.clear();
-    if ( !ribNode->assignedDisp.object().isNull() ) {
-      MPlug dDBPlug = ribNode->assignedDisp.findPlug( MString( "displacementBound" ), &status );
-      if ( status == MS::kSuccess ) dDBPlug.getValue( dispDisplacementBounds );
-      MPlug sDBSPlug = ribNode->assignedDisp.findPlug( MString( "displacementBoundSpace" ), &status );
-      if ( status == MS::kSuccess ) sDBSPlug.getValue( tmpSpace );
-      if ( tmpSpace != "" ) dispDisplacementBoundsSpace = tmpSpace;
-    }
-
-    if ( ( dispDisplacementBounds != 0.0 ) && ( dispDisplacementBounds > surfaceDisplacementBounds ) ) {
-      RtString coordsys = const_cast<char *>(dispDisplacementBoundsSpace.asChar());
-      RiAttribute( "displacementbound", (RtToken) "sphere", &dispDisplacementBounds, "coordinatesystem", &coordsys, RI_NULL );
-    } else if ( ( surfaceDisplacementBounds != 0.0 ) ) {
-      RtString coordsys = const_cast<char *>(surfaceDisplacementBoundsSpace.asChar());
-      RiAttribute( "displacementbound", (RtToken) "sphere", &surfaceDisplacementBounds, "coordinatesystem", &coordsys, RI_NULL );
+    float displacementBounds;
+    MString displacementBoundsSpace;
+    getDisplacementBound( ribNode, displacementBounds, displacementBoundsSpace );
+    if ( displacementBounds != 0.0 ) {
+      RtString coordsys = const_cast<char *>(displacementBoundsSpace.asChar());
+      RiAttribute( "displacementbound", (RtToken) "sphere", &displacementBounds, "coordinatesystem", &coordsys, RI_NULL );
     }
 
 
@@ -6330,18 +7581,9 @@ MStatus liqRibTranslator::objectBlock()
     }
 
 
-    bool writeShaders = true;
-
-    if ( liqglo_currentJob.isShadow &&
-    	 ( ( !liqglo_currentJob.deepShadows && !m_outputShadersInShadows )			||
-           ( liqglo_currentJob.deepShadows && !m_outputShadersInDeepShadows ) )
-        )
-      writeShaders = false;
-
-
     if ( writeShaders ) {
 
-      if ( hasVolumeShader && !m_ignoreVolumes ) {
+      if ( hasVolumeShader && !m_ignoreVolumes && !grouped ) {
 
         liqShader & currentShader = liqGetShader( ribNode->assignedVolume.object());
 
@@ -6349,20 +7591,7 @@ MStatus liqRibTranslator::objectBlock()
         bool outputVolumeShader = true;
         if ( liqglo_currentJob.isShadow && !currentShader.outputInShadow ) outputVolumeShader = false;
 
-        if( !currentShader.hasErrors && outputVolumeShader ) {
-          RtToken *tokenArray = (RtToken *)alloca( sizeof(RtToken) * currentShader.numTPV );
-          RtPointer *pointerArray = (RtPointer *)alloca( sizeof(RtPointer) * currentShader.numTPV );
-          assignTokenArrays( currentShader.numTPV, currentShader.tokenPointerArray, tokenArray, pointerArray );
-          char *shaderFileName;
-          LIQ_GET_SHADER_FILE_NAME( shaderFileName, liqglo_shortShaderNames, currentShader );
-          // check shader space transformation
-          if ( currentShader.shaderSpace != "" ) {
-            RiTransformBegin();
-            RiCoordSysTransform( (char*) currentShader.shaderSpace.asChar() );
-          }
-          RiAtmosphereV ( shaderFileName, currentShader.numTPV, tokenArray, pointerArray );
-          if ( currentShader.shaderSpace != "" ) RiTransformEnd();
-        }
+        if( !currentShader.hasErrors && outputVolumeShader ) writeShader( currentShader, SHADER_TYPE_VOLUME );
       }
 
       if ( hasSurfaceShader && !m_ignoreSurfaces ) {
@@ -6377,14 +7606,15 @@ MStatus liqRibTranslator::objectBlock()
           bool outputSurfaceShader = true;
           if ( liqglo_currentJob.isShadow && !currentShader.outputInShadow ) outputSurfaceShader = false;
 
-          // Output color overrides or color
+          // Output color overrides or color, the material group has the
+          // shader's own
           if (ribNode->shading.color.r != -1.0) {
             RtColor rColor;
             rColor[0] = ribNode->shading.color[0];
             rColor[1] = ribNode->shading.color[1];
             rColor[2] = ribNode->shading.color[2];
             RiColor( rColor );
-          } else {
+          } else if ( !grouped ) {
             RiColor( currentShader.rmColor );
           }
 
@@ -6394,29 +7624,11 @@ MStatus liqRibTranslator::objectBlock()
             rOpacity[1] = ribNode->shading.opacity[1];
             rOpacity[2] = ribNode->shading.opacity[2];
             RiOpacity( rOpacity );
-          } else {
+          } else if ( !grouped ) {
             RiOpacity( currentShader.rmOpacity );
           }
 
-          if ( outputSurfaceShader ) {
-            RtToken *tokenArray = (RtToken *)alloca( sizeof(RtToken) * currentShader.numTPV );
-            RtPointer *pointerArray = (RtPointer *)alloca( sizeof(RtPointer) * currentShader.numTPV );
-
-            assignTokenArrays( currentShader.numTPV, currentShader.tokenPointerArray, tokenArray, pointerArray );
-
-            char *shaderFileName;
-            LIQ_GET_SHADER_FILE_NAME(shaderFileName, liqglo_shortShaderNames, currentShader );
-
-            // check shader space transformation
-            if ( currentShader.shaderSpace != "" ) {
-              RiTransformBegin();
-              RiCoordSysTransform( (char*) currentShader.shaderSpace.asChar() );
-            }
-
-            // output shader
-            RiSurfaceV ( shaderFileName, currentShader.numTPV, tokenArray, pointerArray );
-            if ( currentShader.shaderSpace != "" ) RiTransformEnd();
-          }
+          if ( outputSurfaceShader && !grouped ) writeShader( currentShader, SHADER_TYPE_SURFACE );
         }
 
       } else {
@@ -6631,7 +7843,7 @@ MStatus liqRibTranslator::objectBlock()
       }
     }
 
-    if ( hasDisplacementShader && !m_ignoreDisplacements ) {
+    if ( hasDisplacementShader && !m_ignoreDisplacements && !grouped ) {
 
       liqShader & currentShader = liqGetShader( ribNode->assignedDisp.object() );
 
@@ -6639,23 +7851,7 @@ MStatus liqRibTranslator::objectBlock()
       bool outputDispShader = true;
       if ( liqglo_currentJob.isShadow && !currentShader.outputInShadow ) outputDispShader = false;
 
-      if ( !currentShader.hasErrors && outputDispShader ) {
-        RtToken *tokenArray = ( RtToken *)alloca( sizeof( RtToken ) * currentShader.numTPV );
-        RtPointer *pointerArray = ( RtPointer *)alloca( sizeof( RtPointer ) * currentShader.numTPV );
-
-        assignTokenArrays( currentShader.numTPV, currentShader.tokenPointerArray, tokenArray, pointerArray );
-
-        char *shaderFileName;
-        LIQ_GET_SHADER_FILE_NAME(shaderFileName, liqglo_shortShaderNames, currentShader );
-        // check shader space transformation
-        if ( currentShader.shaderSpace != "" ) {
-            RiTransformBegin();
-            RiCoordSysTransform( (char*) currentShader.shaderSpace.asChar() );
-        }
-        // output shader
-        RiDisplacementV ( shaderFileName, currentShader.numTPV, tokenArray, pointerArray );
-        if ( currentShader.shaderSpace != "" ) RiTransformEnd();
-      }
+      if ( !currentShader.hasErrors && outputDispShader ) writeShader( currentShader, SHADER_TYPE_DISPLACEMENT );
     }
 
     if ( liqglo_currentJob.isShadow && ribNode->shadowRib.box != "" && ribNode->shadowRib.box != "-" ) {
@@ -6710,44 +7906,8 @@ MStatus liqRibTranslator::objectBlock()
     }
 
     if ( !ribNode->ignoreShapes ) {
-
-      // check to see if we are writing a curve to set the proper basis
-      if ( ribNode->object(0)->type == MRT_NuCurve ||
-           ribNode->object(0)->type == MRT_PfxHair ) {
-        RiBasis( RiBSplineBasis, 1, RiBSplineBasis, 1 );
-      }
-
-      if( liqglo_doDef &&
-          ribNode->motion.deformationBlur &&
-          ( ribNode->object(1) != NULL ) &&
-          ( ribNode->object(0)->type != MRT_RibGen ) &&
-     //     ( ribNode->object(0)->type != MRT_Locator ) &&
-          ( !liqglo_currentJob.isShadow || liqglo_currentJob.deepShadows ) )
-      {
-        // Moritz: replaced RiMotionBegin call with ..V version to allow for more than five motion samples
-        if (liqglo_relativeMotion)
-          RiMotionBeginV( liqglo_motionSamples, liqglo_sampleTimesOffsets );
-        else
-          RiMotionBeginV( liqglo_motionSamples, liqglo_sampleTimes );
-      }
-
-      ribNode->object(0)->writeObject();
-      if ( liqglo_doDef &&
-           ribNode->motion.deformationBlur &&
-           ( ribNode->object(1) != NULL ) &&
-           ( ribNode->object(0)->type != MRT_RibGen ) &&
-      //     ( ribNode->object(0)->type != MRT_Locator ) &&
-           ( !liqglo_currentJob.isShadow || liqglo_currentJob.deepShadows ) )
-      {
-        LIQDEBUGPRINTF( "-> writing deformation blur data\n" );
-        int msampleOn = 1;
-        while ( msampleOn < liqglo_motionSamples ) {
-          ribNode->object(msampleOn)->writeObject();
-          ++msampleOn;
-        }
-        RiMotionEnd();
-      }
-
+      if ( ribNode->geometryHandle != "" ) RiArchiveRecord( RI_VERBATIM, "ReadArchive \"%s\"\n", ribNode->geometryHandle.asChar() );
+      else writeGeometry( ribNode, !liqglo_currentJob.isShadow || liqglo_currentJob.deepShadows );
     } else RiArchiveRecord( RI_COMMENT, " Shapes Ignored !!" );
 
     RiAttributeEnd();
@@ -6761,6 +7921,168 @@ MStatus liqRibTranslator::objectBlock()
   return returnStatus;
 }
 
+/**
+ * Resolve the light linking of the scanned frame once for all its jobs :
+ * the lights are indexed and each object gets the bits of the lights it
+ * ignores, objectBlock() then only has to switch these off.
+ */
+void liqRibTranslator::lightLinks()
+{
+  m_linkedLights.clear();
+  std::map<std::string, unsigned> lightIndices;
+  RNMAP::iterator rniter;
+  for ( rniter = htable->RibNodeMap.begin(); rniter != htable->RibNodeMap.end(); rniter++ ) {
+    liqRibNode * ribNode = (*rniter).second;
+    if ( NULL == ribNode || ribNode->object(0)->type != MRT_Light ) continue;
+    lightIndices[ ribNode->path().fullPathName().asChar() ] = m_linkedLights.size();
+    m_linkedLights.push_back( ribNode );
+  }
+
+  unsigned links = 0;
+  for ( rniter = htable->RibNodeMap.begin(); rniter != htable->RibNodeMap.end(); rniter++ ) {
+    liqRibNode * ribNode = (*rniter).second;
+    if ( NULL == ribNode ) continue;
+    ribNode->ignoredLightBits.clear();
+    int type = ribNode->object(0)->type;
+    if ( type == MRT_Light || type == MRT_Coord || type == MRT_ClipPlane ) continue;
+
+    MObjectArray ignoredLights;
+    ribNode->getIgnoredLights( ignoredLights );
+    for ( unsigned i = 0; i < ignoredLights.length(); i++ ) {
+      MDagPath lightPath;
+      MFnDagNode( ignoredLights[i] ).getPath( lightPath );
+      std::map<std::string, unsigned>::const_iterator light = lightIndices.find( lightPath.fullPathName().asChar() );
+      if ( light == lightIndices.end() ) continue;
+      if ( ribNode->ignoredLightBits.empty() ) ribNode->ignoredLightBits.resize( m_linkedLights.size(), false );
+      ribNode->ignoredLightBits[ light->second ] = true;
+      links++;
+    }
+  }
+  if ( debugMode ) printf( "-> %u lights, %u ignored by objects\n", ( unsigned )m_linkedLights.size(), links );
+}
+
+/**
+ * Write the shapes of the scanned frame once for all its jobs. Each object
+ * goes in its own inline archive, objectBlock() reads the file and then
+ * refers to the archives instead of writing the shapes again. Particles
+ * and ribgens depend on the job and are still written in place.
+ */
+MStatus liqRibTranslator::geometryArchive( long frame )
+{
+  m_geometryArchive = LIQ_GET_ABS_REL_FILE_NAME( liqglo_relativeFileNames, generateGeometryArchiveName( frame ), liqglo_projectDir );
+
+  // the archive only depends on the scan, if it is up to date the objects
+  // still get their handles
+  bool upToDate = ribUpToDate( m_geometryArchive, m_scanInputs );
+  if ( !upToDate ) {
+#if !defined(PRMAN) || defined(GENERIC_RIBLIB)
+    RiBegin( const_cast<char *>( ribOutputName( m_geometryArchive ).asChar() ) );
+#else
+    liqglo_ribFP = fopen( ribOutputName( m_geometryArchive ).asChar(), "w" );
+    if ( !liqglo_ribFP ) {
+      MString error( "Error opening rib !" );
+      throw error;
+    }
+    RtInt ribFD = fileno( liqglo_ribFP );
+    RiOption( "rib", "pipe", &ribFD, RI_NULL );
+    RiBegin( RI_NULL );
+#endif
+  }
+
+  unsigned count = 0;
+  for ( RNMAP::iterator rniter = htable->RibNodeMap.begin(); rniter != htable->RibNodeMap.end(); rniter++ ) {
+    liqRibNode * ribNode = (*rniter).second;
+    if ( NULL == ribNode || ribNode->ignoreShapes ) continue;
+    int type = ribNode->object(0)->type;
+    if ( type == MRT_Light || type == MRT_Coord || type == MRT_ClipPlane || type == MRT_RibGen || type == MRT_Particles ) continue;
+    if ( ribNode->object(0)->ignore && ribNode->object(0)->ignoreShadow ) continue;
+
+    char handle[32];
+    sprintf( handle, "liqGeometry%u", count++ );
+    ribNode->geometryHandle = handle;
+    if ( upToDate ) continue;
+
+    if ( m_outputComments ) RiArchiveRecord( RI_COMMENT, "Name: %s", ribNode->name.asChar(), RI_NULL );
+    RiArchiveRecord( RI_VERBATIM, "ArchiveBegin \"%s\"\n", handle );
+    writeGeometry( ribNode, true );
+    RiArchiveRecord( RI_VERBATIM, "ArchiveEnd\n" );
+  }
+
+  if ( !upToDate ) {
+    RiEnd();
+#if defined(PRMAN) && !defined(GENERIC_RIBLIB)
+    fclose( liqglo_ribFP );
+#endif
+    liqglo_ribFP = NULL;
+    ribWritten( m_geometryArchive, m_scanInputs );
+  }
+
+  if ( debugMode ) printf( "-> %u objects shared in %s\n", count, m_geometryArchive.asChar() );
+  return MS::kSuccess;
+}
+
+/**
+ * Write the shapes of an object, with their detail levels and deformation
+ * motion blur.
+ */
+void liqRibTranslator::writeGeometry( liqRibNode *ribNode, bool deformationBlur )
+{
+  // check to see if we are writing a curve to set the proper basis
+  if ( ribNode->object(0)->type == MRT_NuCurve ||
+       ribNode->object(0)->type == MRT_PfxHair ) {
+    RiBasis( RiBSplineBasis, 1, RiBSplineBasis, 1 );
+  }
+
+  // geometry with decimated versions goes out once per level, each in
+  // its own detail range, the renderer picks by screen size. Without a
+  // bound to measure it there is only the full detail.
+  unsigned detailLevels = ribNode->hasWorldBound ? ribNode->object(0)->detailLevels() : 1;
+  if ( detailLevels > 1 ) {
+    const MBoundingBox &bounding = ribNode->objectBound;
+    RtBound detailBound = { bounding.min().x, bounding.max().x, bounding.min().y, bounding.max().y, bounding.min().z, bounding.max().z };
+    RiDetail( detailBound );
+  }
+
+  for ( unsigned detailLevel = 0; detailLevel < detailLevels; detailLevel++ ) {
+    if ( detailLevels > 1 ) {
+      RtFloat range[4];
+      ribNode->object(0)->detailRange( detailLevel, liqglo_polygonLODArea, range );
+      RiDetailRange( range[0], range[1], range[2], range[3] );
+    }
+
+    if( liqglo_doDef &&
+        ribNode->motion.deformationBlur &&
+        ( ribNode->object(1) != NULL ) &&
+        ( ribNode->object(0)->type != MRT_RibGen ) &&
+   //     ( ribNode->object(0)->type != MRT_Locator ) &&
+        deformationBlur )
+    {
+      // Moritz: replaced RiMotionBegin call with ..V version to allow for more than five motion samples
+      if (liqglo_relativeMotion)
+        RiMotionBeginV( liqglo_motionSamples, liqglo_sampleTimesOffsets );
+      else
+        RiMotionBeginV( liqglo_motionSamples, liqglo_sampleTimes );
+    }
+
+    ribNode->object(0)->writeObject( detailLevel );
+    if ( liqglo_doDef &&
+         ribNode->motion.deformationBlur &&
+         ( ribNode->object(1) != NULL ) &&
+         ( ribNode->object(0)->type != MRT_RibGen ) &&
+    //     ( ribNode->object(0)->type != MRT_Locator ) &&
+         deformationBlur )
+    {
+      LIQDEBUGPRINTF( "-> writing deformation blur data\n" );
+      int msampleOn = 1;
+      while ( msampleOn < liqglo_motionSamples ) {
+        ribNode->object(msampleOn)->writeObject( detailLevel );
+        ++msampleOn;
+      }
+      RiMotionEnd();
+    }
+  }
+}
+
 /**
  * Write the world prologue.
  * This includes the pre- and post-world begin RIB boxes and the definition of
@@ -24,6 +24,9 @@
 ** RenderMan (R) is a registered trademark of Pixar
 */
 
+#include <string.h>
+#include <math.h>
+
 #include <maya/MPlug.h>
 #include <maya/MDoubleArray.h>
 #include <maya/MFnDoubleArrayData.h>
@@ -33,6 +36,7 @@
 #include <liqGlobalHelpers.h>
 
 extern int debugMode;
+extern bool liqglo_outputAllShaderParams;
 
 
 liqShader::liqShader()
@@ -52,6 +56,7 @@ liqShader::liqShader()
   displacementBound     = 0.0;
   outputInShadow        = false;
   hasErrors             = false;
+  isAnimated            = false;
   shader_type           = SHADER_TYPE_UNKNOWN;
   shaderSpace           = "";
 }
@@ -59,9 +64,7 @@ liqShader::liqShader()
 liqShader::liqShader( const liqShader & src )
 {
   numTPV = src.numTPV;
-  for( unsigned int i = 0; i < numTPV; i++ ) {
-    tokenPointerArray[i] = src.tokenPointerArray[i];
-  }
+  tokenPointerArray = src.tokenPointerArray;
   name                 = src.name;
   file                 = src.file;
   rmColor[0]           = src.rmColor[0];
@@ -76,6 +79,7 @@ liqShader::liqShader( const liqShader & src )
   displacementBound    = src.displacementBound;
   outputInShadow       = src.outputInShadow;
   hasErrors            = src.hasErrors;
+  isAnimated           = src.isAnimated;
   shader_type          = src.shader_type;
   shaderSpace          = src.shaderSpace;
 }
@@ -83,6 +87,7 @@ liqShader::liqShader( const liqShader & src )
 
 liqShader::liqShader( MObject shaderObj )
 {
+  lmemCategory category( "shader" );
   MString rmShaderStr;
   MStatus status;
 
@@ -98,6 +103,7 @@ liqShader::liqShader( MObject shaderObj )
   hasDisplacementBound = false;
   outputInShadow = false;
   hasErrors = false;
+  isAnimated = false;
 
   // if this shader instance isn't currently used already then load it into the
   // lookup set it as my slo lookup
@@ -169,17 +175,20 @@ liqShader::liqShader( MObject shaderObj )
         hasShadingRate = true;
         continue;
       }
+      int previousTPV = numTPV;
+      // the vector parsers below fill this same slot
+      liqTokenPointer &param = nextParameter();
       switch ( shaderInfo.getArgDetail(i) ) {
         case SHADER_DETAIL_UNIFORM: {
-          tokenPointerArray[numTPV].setDetailType( rUniform );
+          param.setDetailType( rUniform );
           break;
         }
         case SHADER_DETAIL_VARYING: {
-          tokenPointerArray[numTPV].setDetailType( rVarying);
+          param.setDetailType( rVarying);
           break;
         }
         case SHADER_DETAIL_UNKNOWN:
-          tokenPointerArray[numTPV].setDetailType( rUniform);
+          param.setDetailType( rUniform);
           break;
       }
       switch ( shaderInfo.getArgType( i ) ) {
@@ -191,14 +200,14 @@ liqShader::liqShader( MObject shaderObj )
               bool isArrayAttr = stringPlug.isArray( &status );
               if ( isArrayAttr ) {
                 MPlug plugObj;
-                tokenPointerArray[ numTPV ].set( shaderInfo.getArgName( i ).asChar(), rString, false, arraySize, 0 );
+                param.set( shaderInfo.getArgName( i ).asChar(), rString, false, arraySize, 0 );
                 for( unsigned int kk = 0; kk < arraySize; kk++ ) {
                   plugObj = stringPlug.elementByLogicalIndex( kk, &status );
                   if ( status == MS::kSuccess ) {
                     MString stringPlugVal;
                     plugObj.getValue( stringPlugVal );
                     MString stringVal = parseString( stringPlugVal );
-                    tokenPointerArray[ numTPV ].setTokenString( kk, stringVal.asChar(), stringVal.length() );
+                    param.setTokenString( kk, stringVal.asChar(), stringVal.length() );
                   }
                 }
                 numTPV++;
@@ -207,10 +216,10 @@ liqShader::liqShader( MObject shaderObj )
               MString stringPlugVal;
               stringPlug.getValue( stringPlugVal );
               MString stringDefault = shaderInfo.getArgStringDefault( i, 0 );
-              if ( stringPlugVal != stringDefault ) {
+              if ( liqglo_outputAllShaderParams || stringPlugVal != stringDefault ) {
                 MString stringVal = parseString( stringPlugVal );
-                tokenPointerArray[ numTPV ].set( shaderInfo.getArgName( i ).asChar(), rString, false, 0, 0 );
-                tokenPointerArray[ numTPV ].setTokenString( 0, stringVal.asChar(), stringVal.length() );
+                param.set( shaderInfo.getArgName( i ).asChar(), rString, false, 0, 0 );
+                param.setTokenString( 0, stringVal.asChar(), stringVal.length() );
                 numTPV++;
               }
             }
@@ -228,13 +237,13 @@ liqShader::liqShader( MObject shaderObj )
 
                 // philippe : new way to store float arrays as multi attr
                 MPlug plugObj;
-                tokenPointerArray[ numTPV ].set( shaderInfo.getArgName( i ).asChar(), rFloat, false, false, true, arraySize );
+                param.set( shaderInfo.getArgName( i ).asChar(), rFloat, false, false, true, arraySize );
                 for( unsigned int kk = 0; kk < arraySize; kk++ ) {
                   plugObj = floatPlug.elementByLogicalIndex( kk, &status );
                   if ( status == MS::kSuccess ) {
                     float x;
                     plugObj.getValue(x);
-                    tokenPointerArray[numTPV].setTokenFloat( kk, x  );
+                    param.setTokenFloat( kk, x  );
                   }
                 }
 
@@ -247,17 +256,17 @@ liqShader::liqShader( MObject shaderObj )
                 MFnDoubleArrayData  fnDoubleArrayData( plugObj );
                 MDoubleArray doubleArrayData = fnDoubleArrayData.array( &status );
                 // Hmmmmmmm Really a uArray ?
-                tokenPointerArray[ numTPV ].set( shaderInfo.getArgName( i ).asChar(), rFloat, false, false, true, arraySize );
+                param.set( shaderInfo.getArgName( i ).asChar(), rFloat, false, false, true, arraySize );
                 for( unsigned int kk = 0; kk < arraySize; kk++ ) {
-                  tokenPointerArray[numTPV].setTokenFloat( kk, doubleArrayData[kk] );
+                  param.setTokenFloat( kk, doubleArrayData[kk] );
                 }
 
               }
             } else {
               float floatPlugVal;
               floatPlug.getValue( floatPlugVal );
-              tokenPointerArray[ numTPV ].set( shaderInfo.getArgName( i ).asChar(), rFloat, false, false, false, 0 );
-              tokenPointerArray[ numTPV ].setTokenFloat( 0, floatPlugVal );
+              param.set( shaderInfo.getArgName( i ).asChar(), rFloat, false, false, false, 0 );
+              param.setTokenFloat( 0, floatPlugVal );
             }
             numTPV++;
           }
@@ -310,9 +319,37 @@ liqShader::liqShader( MObject shaderObj )
           printf("Unknown\n");
           break;
         }
+      // the shader already has these values, no need to pass them
+      if ( numTPV > previousTPV && !liqglo_outputAllShaderParams &&
+           isDefault( shaderInfo, i, param ) ) {
+        numTPV--;
+      }
+    }
+  }
+  if ( success ) {
+    // connected parameters and strings with frame or environment variables
+    // may not give the same values on another frame
+    for ( unsigned int i = 0; !isAnimated && i < numArgs; i++ ) {
+      MPlug plug = shaderNode.findPlug( shaderInfo.getArgName( i ), &status );
+      if ( status != MS::kSuccess ) continue;
+      if ( plug.isConnected() ||
+           ( plug.isArray() && plug.numConnectedElements() ) ||
+           ( plug.isCompound() && plug.numConnectedChildren() ) ) {
+        isAnimated = true;
+      } else if ( shaderInfo.getArgType( i ) == SHADER_TYPE_STRING && !plug.isArray() ) {
+        MString stringPlugVal;
+        plug.getValue( stringPlugVal );
+        isAnimated = strpbrk( stringPlugVal.asChar(), "$#`" ) != NULL;
+      }
+    }
+    const char *colorAttrs[] = { "color", "opacity" };
+    for ( unsigned int i = 0; !isAnimated && i < 2; i++ ) {
+      MPlug plug = shaderNode.findPlug( colorAttrs[i], &status );
+      if ( status == MS::kSuccess ) isAnimated = plug.isConnected() || plug.numConnectedChildren();
     }
   }
   shaderInfo.resetIt();
+  tokenPointerArray.resize( numTPV );
 }
 
 MStatus liqShader::liqShaderParseVectorAttr ( MFnDependencyNode & shaderNode, const char * argName, ParameterType pType )
@@ -321,11 +358,12 @@ MStatus liqShader::liqShaderParseVectorAttr ( MFnDependencyNode & shaderNode, co
   MPlug triplePlug = shaderNode.findPlug( argName, &status );
   if ( status == MS::kSuccess ) {
     float x, y, z;
-    tokenPointerArray[ numTPV ].set( argName, pType, false, false, false, 0 );
+    liqTokenPointer &param = nextParameter();
+    param.set( argName, pType, false, false, false, 0 );
     triplePlug.child(0).getValue( x );
     triplePlug.child(1).getValue( y );
     triplePlug.child(2).getValue( z );
-    tokenPointerArray[ numTPV ].setTokenFloat( 0, x, y, z );
+    param.setTokenFloat( 0, x, y, z );
     numTPV++;
   }
   return status;
@@ -335,7 +373,8 @@ MStatus liqShader::liqShaderParseVectorAttr ( MFnDependencyNode & shaderNode, co
 MStatus liqShader::liqShaderParseVectorArrayAttr ( MFnDependencyNode & shaderNode, const char * argName, ParameterType pType, unsigned int arraySize )
 {
   MStatus status = MS::kSuccess;
-  tokenPointerArray[ numTPV ].set( argName, pType, false, false, true, arraySize );
+  liqTokenPointer &param = nextParameter();
+  param.set( argName, pType, false, false, true, arraySize );
   MPlug triplePlug;
 
   triplePlug = shaderNode.findPlug( argName, true, &status );
@@ -350,7 +389,7 @@ MStatus liqShader::liqShaderParseVectorArrayAttr ( MFnDependencyNode & shaderNod
       argNameElement.child(0).getValue( x );
       argNameElement.child(1).getValue( y );
       argNameElement.child(2).getValue( z );
-      tokenPointerArray[numTPV].setTokenFloat( kk, x, y, z );
+      param.setTokenFloat( kk, x, y, z );
     }
 
   }
@@ -361,13 +400,45 @@ MStatus liqShader::liqShaderParseVectorArrayAttr ( MFnDependencyNode & shaderNod
 }
 
 
+// true if the token holds the default of parameter arg of the compiled shader
+bool liqShader::isDefault( liqGetSloInfo & shaderInfo, int arg, liqTokenPointer & token )
+{
+  unsigned int elements = shaderInfo.getArgArraySize( arg );
+  unsigned int size;
+  switch ( shaderInfo.getArgType( arg ) ) {
+    case SHADER_TYPE_SCALAR:
+      size = 1;
+      break;
+    case SHADER_TYPE_COLOR:
+      size = 3;
+      break;
+    default:
+      // strings are compared on the raw attribute value. The defaults of
+      // points, vectors and normals are in shader space while the values
+      // passed are in object space, so those and matrices are always passed
+      return false;
+  }
+  size *= elements ? elements : 1;
+
+  const RtFloat *values = token.getTokenFloatArray();
+  unsigned int uSize = token.getUArraySize();
+  if ( !shaderInfo.hasArgDefault( arg ) || values == NULL ||
+       token.getArraySize() * ( uSize ? uSize : 1 ) * token.getElementSize() != size ) {
+    return false;
+  }
+  // defaults go through printf formatting on their way to the node
+  for ( unsigned int k = 0; k < size; k++ ) {
+    float def = shaderInfo.getArgFloatDefault( arg, k );
+    if ( fabs( values[k] - def ) > 1e-5 * ( fabs( def ) > 1.0 ? fabs( def ) : 1.0 ) ) return false;
+  }
+  return true;
+}
+
 liqShader & liqShader::operator=( const liqShader & src )
 {
   freeShader();
   numTPV = src.numTPV;
-  for( unsigned int i = 0; i < numTPV; i++ ) {
-    tokenPointerArray[i] = src.tokenPointerArray[i];
-  }
+  tokenPointerArray = src.tokenPointerArray;
   name                  = src.name;
   file                  = src.file;
   rmColor[0]            = src.rmColor[0];
@@ -382,6 +453,7 @@ liqShader & liqShader::operator=( const liqShader & src )
   displacementBound     = src.displacementBound;
   outputInShadow        = src.outputInShadow;
   hasErrors             = src.hasErrors;
+  isAnimated            = src.isAnimated;
   shader_type           = src.shader_type;
   shaderSpace           = src.shaderSpace;
   return *this;
@@ -394,10 +466,30 @@ liqShader::~liqShader()
 
 void liqShader::freeShader( )
 {
-  unsigned int k = 0;
-  while ( k < numTPV ) {
-    tokenPointerArray[k].reset();
-    k++;
-  }
+  tokenPointerArray.clear();
   numTPV = 0;
 }
+
+liqTokenPointer & liqShader::nextParameter( )
+{
+  if ( tokenPointerArray.size() <= ( unsigned int )numTPV ) tokenPointerArray.resize( numTPV + 1 );
+  return tokenPointerArray[ numTPV ];
+}
+
+void liqShader::hash( liqHash &h ) const
+{
+  h.add( name.c_str() );
+  h.add( file.c_str() );
+  h.add( rmColor, sizeof( RtColor ) );
+  h.add( rmOpacity, sizeof( RtColor ) );
+  h.add( ( int )hasShadingRate );
+  h.add( shadingRate );
+  h.add( ( int )hasDisplacementBound );
+  h.add( displacementBound );
+  h.add( ( int )outputInShadow );
+  h.add( ( int )hasErrors );
+  h.add( ( int )shader_type );
+  h.add( shaderSpace );
+  h.add( ( unsigned )tokenPointerArray.size() );
+  for ( unsigned i = 0; i < tokenPointerArray.size(); i++ ) tokenPointerArray[i].hash( h );
+}
@@ -0,0 +1,564 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+/* ______________________________________________________________________
+**
+** Liquid Shader Info Source
+** ______________________________________________________________________
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <map>
+
+// Renderer shader libraries
+#if defined( PRMAN ) || defined( DELIGHT )
+extern "C" {
+#include <slo.h>
+}
+#define LIQ_SL_ARGS
+#define SL_VISSYMDEF            SLO_VISSYMDEF
+#define SL_STOR_OUTPUTPARAMETER SLO_STOR_OUTPUTPARAMETER
+#define SL_SetShader            Slo_SetShader
+#define SL_GetName              Slo_GetName
+#define SL_GetType              Slo_GetType
+#define SL_GetNArgs             Slo_GetNArgs
+#define SL_GetArgById           Slo_GetArgById
+#define SL_GetArrayArgElement   Slo_GetArrayArgElement
+#define SL_EndShader            Slo_EndShader
+#ifdef PRMAN
+#define SL_EXTENSION            "slo"
+#else
+#define SL_EXTENSION            "sdl"
+#endif
+#elif defined( AQSIS )
+#include <slx.h>
+#define LIQ_SL_ARGS
+#define SL_VISSYMDEF            SLX_VISSYMDEF
+#define SL_STOR_OUTPUTPARAMETER SLX_STOR_OUTPUTPARAMETER
+#define SL_SetShader            SLX_SetShader
+#define SL_GetName              SLX_GetName
+#define SL_GetType              SLX_GetType
+#define SL_GetNArgs             SLX_GetNArgs
+#define SL_GetArgById           SLX_GetArgById
+#define SL_GetArrayArgElement   SLX_GetArrayArgElement
+#define SL_EndShader            SLX_EndShader
+#define SL_EXTENSION            "slx"
+#elif defined( PIXIE )
+#include <sdr.h>
+#endif
+
+#include <maya/MGlobal.h>
+#include <maya/MIntArray.h>
+
+#include <liquid.h>
+#include <liqGlobalHelpers.h>
+#include <liqShaderInfo.h>
+
+extern int debugMode;
+extern const char* shaderTypeStr[14];
+extern const char* shaderDetailStr[3];
+
+static const char *cacheHeader = "liquidShaderInfo 1";
+
+struct shaderInfoEntry {
+  long            mtime;
+  liqShaderInfo  *info;
+};
+
+static std::map<std::string, shaderInfoEntry> shaderInfoCache;
+static bool     shaderInfoCacheLoaded = false;
+static unsigned shaderInfoCacheRecords = 0;
+
+
+static unsigned floatsPerItem( SHADER_TYPE type )
+{
+  switch ( type ) {
+    case SHADER_TYPE_SCALAR:  return 1;
+    case SHADER_TYPE_POINT:
+    case SHADER_TYPE_COLOR:
+    case SHADER_TYPE_VECTOR:
+    case SHADER_TYPE_NORMAL:  return 3;
+    case SHADER_TYPE_MATRIX:  return 16;
+    default:                  return 0;
+  }
+}
+
+static SHADER_TYPE shaderTypeFromStr( const MString &str )
+{
+  for ( unsigned i = 0; i < 14; i++ ) {
+    if ( str == shaderTypeStr[i] ) return ( SHADER_TYPE )i;
+  }
+  return SHADER_TYPE_UNKNOWN;
+}
+
+static SHADER_DETAIL shaderDetailFromStr( const MString &str )
+{
+  for ( unsigned i = 0; i < 3; i++ ) {
+    if ( str == shaderDetailStr[i] ) return ( SHADER_DETAIL )i;
+  }
+  return SHADER_DETAIL_UNKNOWN;
+}
+
+// $LIQUIDSHADERINFOCACHE or .liquidShaderInfo in the home directory
+static MString cacheFileName()
+{
+  const char *env = getenv( "LIQUIDSHADERINFOCACHE" );
+  if ( env ) return MString( env );
+#ifndef _WIN32
+  env = getenv( "HOME" );
+#else
+  env = getenv( "USERPROFILE" );
+#endif
+  if ( !env ) return MString( "" );
+  return MString( env ) + "/.liquidShaderInfo";
+}
+
+static void writeString( std::string &out, const std::string &str )
+{
+  char length[32];
+  sprintf( length, "%u:", ( unsigned )str.size() );
+  out += length;
+  out += str;
+}
+
+static bool readString( FILE *fp, std::string &str )
+{
+  unsigned length;
+  if ( fscanf( fp, " %u:", &length ) != 1 ) return false;
+  str.resize( length );
+  return length == 0 || fread( &str[0], 1, length, fp ) == length;
+}
+
+void liqShaderInfo::write( FILE *fp ) const
+{
+  // one fwrite per record, appends from several sessions don't interleave
+  std::string out;
+  char buffer[64];
+  writeString( out, name );
+  sprintf( buffer, " %d %u\n", ( int )type, ( unsigned )params.size() );
+  out += buffer;
+  for ( unsigned i = 0; i < params.size(); i++ ) {
+    const param &p = params[i];
+    writeString( out, p.name );
+    sprintf( buffer, " %d %d %d %d %u", ( int )p.type, ( int )p.detail, p.arraySize, p.isOutput? 1 : 0, ( unsigned )p.floats.size() );
+    out += buffer;
+    for ( unsigned k = 0; k < p.floats.size(); k++ ) {
+      sprintf( buffer, " %.9g", p.floats[k] );
+      out += buffer;
+    }
+    sprintf( buffer, " %u", ( unsigned )p.strings.size() );
+    out += buffer;
+    for ( unsigned k = 0; k < p.strings.size(); k++ ) {
+      out += " ";
+      writeString( out, p.strings[k] );
+    }
+    out += "\n";
+  }
+  fwrite( out.data(), 1, out.size(), fp );
+}
+
+bool liqShaderInfo::read( FILE *fp )
+{
+  int shaderType;
+  unsigned numParams;
+  if ( !readString( fp, name ) || fscanf( fp, " %d %u", &shaderType, &numParams ) != 2 ) return false;
+  type = ( SHADER_TYPE )shaderType;
+  params.resize( numParams );
+  for ( unsigned i = 0; i < numParams; i++ ) {
+    param &p = params[i];
+    int paramType, detail, isOutput;
+    unsigned numFloats, numStrings;
+    if ( !readString( fp, p.name ) ||
+         fscanf( fp, " %d %d %d %d %u", &paramType, &detail, &p.arraySize, &isOutput, &numFloats ) != 5 ) return false;
+    p.type = ( SHADER_TYPE )paramType;
+    p.detail = ( SHADER_DETAIL )detail;
+    p.isOutput = isOutput != 0;
+    p.floats.resize( numFloats );
+    for ( unsigned k = 0; k < numFloats; k++ ) {
+      if ( fscanf( fp, " %f", &p.floats[k] ) != 1 ) return false;
+    }
+    if ( fscanf( fp, " %u", &numStrings ) != 1 ) return false;
+    p.strings.resize( numStrings );
+    for ( unsigned k = 0; k < numStrings; k++ ) {
+      if ( !readString( fp, p.strings[k] ) ) return false;
+    }
+  }
+  return true;
+}
+
+static void saveCache()
+{
+  MString fileName = cacheFileName();
+  if ( fileName == "" ) return;
+  MString tmpName = fileName + ".tmp";
+  FILE *fp = fopen( tmpName.asChar(), "wb" );
+  if ( !fp ) return;
+  fprintf( fp, "%s\n", cacheHeader );
+  std::map<std::string, shaderInfoEntry>::const_iterator it;
+  for ( it = shaderInfoCache.begin(); it != shaderInfoCache.end(); ++it ) {
+    std::string path;
+    writeString( path, it->first );
+    fprintf( fp, "shader %ld %s ", it->second.mtime, path.c_str() );
+    it->second.info->write( fp );
+  }
+  fclose( fp );
+#ifdef _WIN32
+  remove( fileName.asChar() );
+#endif
+  rename( tmpName.asChar(), fileName.asChar() );
+  shaderInfoCacheRecords = shaderInfoCache.size();
+}
+
+static void loadCache()
+{
+  shaderInfoCacheLoaded = true;
+  MString fileName = cacheFileName();
+  if ( fileName == "" ) return;
+  FILE *fp = fopen( fileName.asChar(), "rb" );
+  if ( !fp ) return;
+
+  char header[64];
+  if ( fgets( header, sizeof( header ), fp ) && !strncmp( header, cacheHeader, strlen( cacheHeader ) ) ) {
+    long mtime;
+    std::string path;
+    // later records of a shader replace earlier ones
+    while ( fscanf( fp, " shader %ld", &mtime ) == 1 && readString( fp, path ) ) {
+      liqShaderInfo *info = new liqShaderInfo;
+      if ( !info->read( fp ) ) {
+        delete info;
+        break;
+      }
+      shaderInfoEntry &entry = shaderInfoCache[ path ];
+      delete entry.info;
+      entry.info = info;
+      entry.mtime = mtime;
+      shaderInfoCacheRecords++;
+    }
+  }
+  fclose( fp );
+  if ( debugMode ) printf( "-> read %u shader infos from %s\n", ( unsigned )shaderInfoCache.size(), fileName.asChar() );
+
+  // too many outdated records
+  if ( shaderInfoCacheRecords > 2 * shaderInfoCache.size() + 64 ) saveCache();
+}
+
+static void appendToCache( const std::string &path, long mtime, const liqShaderInfo &info )
+{
+  MString fileName = cacheFileName();
+  if ( fileName == "" ) return;
+  bool isNew = !fileExists( fileName );
+  FILE *fp = fopen( fileName.asChar(), "ab" );
+  if ( !fp ) return;
+  if ( isNew ) fprintf( fp, "%s\n", cacheHeader );
+  std::string pathStr;
+  writeString( pathStr, path );
+  fprintf( fp, "shader %ld %s ", mtime, pathStr.c_str() );
+  info.write( fp );
+  fclose( fp );
+  shaderInfoCacheRecords++;
+}
+
+
+const liqShaderInfo *liqShaderInfo::get( const MString &shaderFile )
+{
+  struct stat fileStat;
+  if ( stat( shaderFile.asChar(), &fileStat ) != 0 ) return NULL;
+  if ( !shaderInfoCacheLoaded ) loadCache();
+
+  std::string path( shaderFile.asChar() );
+  std::map<std::string, shaderInfoEntry>::iterator found = shaderInfoCache.find( path );
+  if ( found != shaderInfoCache.end() && found->second.mtime == ( long )fileStat.st_mtime ) {
+    return found->second.info;
+  }
+
+  liqShaderInfo *info = new liqShaderInfo;
+  if ( !info->readNative( shaderFile ) && !info->readMel( shaderFile ) ) {
+    delete info;
+    return NULL;
+  }
+  if ( found == shaderInfoCache.end() ) {
+    shaderInfoEntry entry = { 0, NULL };
+    found = shaderInfoCache.insert( std::make_pair( path, entry ) ).first;
+  }
+  delete found->second.info;
+  found->second.info = info;
+  found->second.mtime = ( long )fileStat.st_mtime;
+  appendToCache( path, found->second.mtime, *info );
+  return info;
+}
+
+
+#ifdef LIQ_SL_ARGS
+static void readSlDefault( SL_VISSYMDEF *arg, liqShaderInfo::param &p )
+{
+  unsigned n = floatsPerItem( p.type );
+  if ( p.type == SHADER_TYPE_STRING ) {
+    p.strings.push_back( arg->svd_default.stringval? arg->svd_default.stringval : "" );
+  } else if ( n == 3 && arg->svd_default.pointval ) {
+    p.floats.push_back( arg->svd_default.pointval->xval );
+    p.floats.push_back( arg->svd_default.pointval->yval );
+    p.floats.push_back( arg->svd_default.pointval->zval );
+  } else if ( n && n != 3 && arg->svd_default.scalarval ) {
+    // a matrix is 16 floats in a row
+    p.floats.insert( p.floats.end(), arg->svd_default.scalarval, arg->svd_default.scalarval + n );
+  } else {
+    p.floats.resize( p.floats.size() + n, 0.0 );
+  }
+}
+#endif
+
+bool liqShaderInfo::readNative( const MString &shaderFile )
+{
+  int dot = shaderFile.rindex( '.' );
+  MString extension = ( dot > 0 )? shaderFile.substring( dot + 1, shaderFile.length() - 1 ) : MString( "" );
+  MString baseName  = ( dot > 0 )? shaderFile.substring( 0, dot - 1 ) : shaderFile;
+
+#ifdef LIQ_SL_ARGS
+  if ( extension != SL_EXTENSION ) return false;
+  if ( SL_SetShader( const_cast< char * >( baseName.asChar() ) ) != 0 ) return false;
+
+  const char *shaderName = SL_GetName();
+  name = shaderName? shaderName : "";
+  type = ( SHADER_TYPE )SL_GetType();
+  int numArgs = SL_GetNArgs();
+  params.resize( numArgs > 0 ? numArgs : 0 );
+  for ( int i = 0; i < numArgs; i++ ) {
+    SL_VISSYMDEF *arg = SL_GetArgById( i + 1 );
+    param &p = params[i];
+    if ( !arg ) {
+      SL_EndShader();
+      return false;
+    }
+    p.name      = arg->svd_name;
+    p.type      = ( SHADER_TYPE )arg->svd_type;
+    p.detail    = ( SHADER_DETAIL )arg->svd_detail;
+    p.arraySize = arg->svd_arraylen;
+    p.isOutput  = arg->svd_storage == SL_STOR_OUTPUTPARAMETER;
+    if ( p.arraySize > 0 ) {
+      for ( int k = 0; k < p.arraySize; k++ ) {
+        SL_VISSYMDEF *element = SL_GetArrayArgElement( arg, k );
+        if ( element ) readSlDefault( element, p );
+      }
+    } else {
+      readSlDefault( arg, p );
+    }
+  }
+  SL_EndShader();
+  return true;
+
+#elif defined( PIXIE )
+  if ( extension != "sdr" ) return false;
+  TSdrShader *shader = sdrGet( const_cast< char * >( shaderFile.asChar() ), "" );
+  if ( !shader ) return false;
+
+  // sdr numbering to liquid's
+  static const SHADER_TYPE sdrShaderTypes[5] = { SHADER_TYPE_SURFACE, SHADER_TYPE_DISPLACEMENT, SHADER_TYPE_VOLUME, SHADER_TYPE_LIGHT, SHADER_TYPE_IMAGER };
+  static const SHADER_TYPE sdrTypes[7] = { SHADER_TYPE_SCALAR, SHADER_TYPE_VECTOR, SHADER_TYPE_NORMAL, SHADER_TYPE_POINT, SHADER_TYPE_COLOR, SHADER_TYPE_MATRIX, SHADER_TYPE_STRING };
+
+  name = shader->name? shader->name : "";
+  type = ( shader->type >= 0 && shader->type < 5 )? sdrShaderTypes[ shader->type ] : SHADER_TYPE_UNKNOWN;
+  for ( TSdrParameter *sdrParam = shader->parameters; sdrParam; sdrParam = sdrParam->next ) {
+    params.push_back( param() );
+    param &p = params.back();
+    p.name      = sdrParam->name;
+    p.type      = ( sdrParam->type >= 0 && sdrParam->type < 7 )? sdrTypes[ sdrParam->type ] : SHADER_TYPE_UNKNOWN;
+    p.detail    = ( sdrParam->container == CONTAINER_UNIFORM || sdrParam->container == CONTAINER_CONSTANT )? SHADER_DETAIL_UNIFORM : SHADER_DETAIL_VARYING;
+    p.arraySize = ( sdrParam->numItems > 1 )? sdrParam->numItems : 0;
+    p.isOutput  = sdrParam->writable != 0;
+
+    unsigned n = floatsPerItem( p.type );
+    int items = p.arraySize? p.arraySize : 1;
+    for ( int k = 0; k < items; k++ ) {
+      UDefaultVal *value = p.arraySize? &sdrParam->defaultValue.array[k] : &sdrParam->defaultValue;
+      if ( p.type == SHADER_TYPE_STRING ) {
+        p.strings.push_back( value->string? value->string : "" );
+      } else if ( n == 1 ) {
+        p.floats.push_back( value->scalar );
+      } else if ( n == 3 && value->vector ) {
+        p.floats.insert( p.floats.end(), value->vector, value->vector + 3 );
+      } else if ( n == 16 && value->matrix ) {
+        p.floats.insert( p.floats.end(), value->matrix, value->matrix + 16 );
+      } else {
+        p.floats.resize( p.floats.size() + n, 0.0 );
+      }
+    }
+  }
+  sdrDelete( shader );
+  return true;
+
+#else
+  return false;
+#endif
+}
+
+// parse the numbers out of a liquidSlAllParamDefaultsRaw() entry
+static void readRawFloats( const char *raw, unsigned count, std::vector<float> &floats )
+{
+  const char *c = raw;
+  while ( *c && floats.size() < count ) {
+    char *end;
+    float value = ( float )strtod( c, &end );
+    if ( end == c ) {
+      c++;
+    } else {
+      floats.push_back( value );
+      c = end;
+    }
+  }
+  floats.resize( count, 0.0 );
+}
+
+// parse the strings out of a liquidSlAllParamDefaultsRaw() entry, a quoted
+// string or a {"a", "b"} list of them
+static void readRawStrings( const char *raw, unsigned count, std::vector<std::string> &strings )
+{
+  const char *c = raw;
+  if ( !strchr( raw, '"' ) ) {
+    // not quoted, taken as it is
+    if ( count == 1 ) strings.push_back( raw );
+    c = "";
+  }
+  while ( *c && strings.size() < count ) {
+    if ( *c++ != '"' ) continue;
+    std::string str;
+    while ( *c && *c != '"' ) {
+      if ( *c == '\\' && c[1] ) c++;
+      str += *c++;
+    }
+    if ( *c ) c++;
+    strings.push_back( str );
+  }
+  strings.resize( count );
+}
+
+bool liqShaderInfo::readMel( const MString &shaderFile )
+{
+  MStatus status;
+  MString shaderName, shaderType;
+  int numParams;
+  MStringArray names, types, details, defaults;
+  MIntArray arraySizes, isOutput;
+
+  status = MGlobal::executeCommand( "liquidSlParseShaderFile \"" + shaderFile + "\";" );
+  if ( status != MS::kSuccess ) return false;
+  status = MGlobal::executeCommand( "liquidSlShaderName();", shaderName );
+  if ( status == MS::kSuccess ) status = MGlobal::executeCommand( "liquidSlShaderType();", shaderType );
+  if ( status == MS::kSuccess ) status = MGlobal::executeCommand( "liquidSlNumParams();", numParams );
+  if ( status == MS::kSuccess ) status = MGlobal::executeCommand( "liquidSlAllParamNames();", names );
+  if ( status == MS::kSuccess ) status = MGlobal::executeCommand( "liquidSlAllParamTypes();", types );
+  if ( status == MS::kSuccess ) status = MGlobal::executeCommand( "liquidSlAllParamDetails();", details );
+  if ( status == MS::kSuccess ) status = MGlobal::executeCommand( "liquidSlAllParamArraySizes();", arraySizes );
+  if ( status == MS::kSuccess ) status = MGlobal::executeCommand( "liquidSlAllParamDefaultsRaw();", defaults );
+  if ( status == MS::kSuccess ) status = MGlobal::executeCommand( "liquidSlAllParamIsOutput();", isOutput );
+  if ( status != MS::kSuccess || numParams < 0 ) return false;
+
+  name = shaderName.asChar();
+  type = shaderTypeFromStr( shaderType );
+  params.resize( numParams );
+  for ( int i = 0; i < numParams; i++ ) {
+    param &p = params[i];
+    p.name      = ( i < ( int )names.length() )? names[i].asChar() : "";
+    p.type      = ( i < ( int )types.length() )? shaderTypeFromStr( types[i] ) : SHADER_TYPE_UNKNOWN;
+    p.detail    = ( i < ( int )details.length() )? shaderDetailFromStr( details[i] ) : SHADER_DETAIL_UNKNOWN;
+    p.arraySize = ( i < ( int )arraySizes.length() )? arraySizes[i] : 0;
+    p.isOutput  = ( i < ( int )isOutput.length() )? isOutput[i] != 0 : false;
+
+    MString raw = ( i < ( int )defaults.length() )? defaults[i] : MString( "" );
+    if ( p.type == SHADER_TYPE_STRING ) {
+      readRawStrings( raw.asChar(), p.arraySize? p.arraySize : 1, p.strings );
+    } else {
+      readRawFloats( raw.asChar(), floatsPerItem( p.type ) * ( p.arraySize? p.arraySize : 1 ), p.floats );
+    }
+  }
+  return true;
+}
+
+
+static MString melFloat( float value )
+{
+  char buffer[64];
+  sprintf( buffer, "%g", value );
+  if ( !strpbrk( buffer, ".eni" ) ) strcat( buffer, ".0" );
+  return MString( buffer );
+}
+
+static MString melString( const std::string &str )
+{
+  MString result( "\"" );
+  for ( unsigned i = 0; i < str.size(); i++ ) {
+    char c[3] = { '\\', str[i], 0 };
+    result += ( str[i] == '"' || str[i] == '\\' )? c : c + 1;
+  }
+  return result + "\"";
+}
+
+MString liqShaderInfo::melDefault( unsigned i ) const
+{
+  const param &p = params[i];
+  unsigned items = p.arraySize? p.arraySize : 1;
+  unsigned n = floatsPerItem( p.type );
+  MString result;
+  for ( unsigned k = 0; k < items; k++ ) {
+    if ( k ) result += ", ";
+    if ( p.type == SHADER_TYPE_STRING ) {
+      result += melString( k < p.strings.size()? p.strings[k] : std::string() );
+    } else if ( n == 1 ) {
+      result += melFloat( k < p.floats.size()? p.floats[k] : 0 );
+    } else if ( n ) {
+      result += "<<";
+      for ( unsigned j = 0; j < n; j++ ) {
+        if ( j ) result += ( n == 16 && j % 4 == 0 )? "; " : ", ";
+        unsigned f = k * n + j;
+        result += melFloat( f < p.floats.size()? p.floats[f] : 0 );
+      }
+      result += ">>";
+    }
+  }
+  if ( p.arraySize ) result = "{" + result + "}";
+  return result;
+}
+
+void liqShaderInfo::melInfo( MStringArray &info ) const
+{
+  info.clear();
+  info.append( MString( name.c_str() ) );
+  info.append( MString( shaderTypeStr[ type ] ) );
+  info.append( MString( "" ) + ( int )params.size() );
+  for ( unsigned i = 0; i < params.size(); i++ ) {
+    const param &p = params[i];
+    info.append( MString( p.name.c_str() ) );
+    info.append( MString( shaderDetailStr[ p.detail ] ) );
+    info.append( MString( shaderTypeStr[ p.type ] ) );
+    info.append( p.isOutput? "1" : "0" );
+    info.append( MString( "" ) + p.arraySize );
+    info.append( melDefault( i ) );
+  }
+}
@@ -0,0 +1,211 @@
+/*
+**
+** The contents of this file are subject to the Mozilla Public License Version 1.1 (the
+** "License"); you may not use this file except in compliance with the License. You may
+** obtain a copy of the License at http://www.mozilla.org/MPL/
+**
+** Software distributed under the License is distributed on an "AS IS" basis, WITHOUT
+** WARRANTY OF ANY KIND, either express or implied. See the License for the specific
+** language governing rights and limitations under the License.
+**
+** The Original Code is the Liquid Rendering Toolkit.
+**
+** The Initial Developer of the Original Code is Colin Doncaster. Portions created by
+** Colin Doncaster are Copyright (C) 2002. All Rights Reserved.
+**
+** Contributor(s): Berj Bannayan.
+**
+**
+** The RenderMan (R) Interface Procedures and Protocol are:
+** Copyright 1988, 1989, Pixar
+** All Rights Reserved
+**
+**
+** RenderMan (R) is a registered trademark of Pixar
+*/
+
+
+/* ______________________________________________________________________
+**
+** Liquid Texture Cache Source
+** ______________________________________________________________________
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <map>
+#include <string>
+
+#include <liquid.h>
+#include <liqGlobalHelpers.h>
+#include <liqTextureCache.h>
+
+extern int debugMode;
+extern MString liqglo_textureDir;
+
+static const char *manifestHeader = "liquidTextures 2";
+
+struct textureEntry {
+  std::string   source;
+  std::string   options;
+  long          size;
+  long          mtime;
+  std::string   hash;     // of the source contents
+  long          destMtime;  // of the destination when it was recorded
+};
+
+static std::string                         manifestName;
+static std::map<std::string, textureEntry> textures;   // converted textures, by destination
+static std::map<std::string, textureEntry> pending;    // what the out of date ones will be made from
+static bool                                manifestDirty = false;
+
+
+static void writeString( FILE *fp, const std::string &str )
+{
+  fprintf( fp, " %u:", ( unsigned )str.size() );
+  fwrite( str.data(), 1, str.size(), fp );
+}
+
+static bool readString( FILE *fp, std::string &str )
+{
+  unsigned length;
+  if ( fscanf( fp, " %u:", &length ) != 1 ) return false;
+  str.resize( length );
+  return length == 0 || fread( &str[0], 1, length, fp ) == length;
+}
+
+// the manifest of the current texture directory
+static void loadManifest()
+{
+  std::string fileName = ( liqglo_textureDir + ".liquidTextures" ).asChar();
+  if ( fileName == manifestName ) return;
+  liqTextureCache::save();
+  manifestName = fileName;
+  textures.clear();
+  pending.clear();
+
+  FILE *fp = fopen( fileName.c_str(), "rb" );
+  if ( !fp ) return;
+  char header[64];
+  if ( fgets( header, sizeof( header ), fp ) && !strncmp( header, manifestHeader, strlen( manifestHeader ) ) ) {
+    std::string dest;
+    textureEntry entry;
+    while ( readString( fp, dest ) && readString( fp, entry.source ) && readString( fp, entry.options ) &&
+            fscanf( fp, " %ld %ld", &entry.size, &entry.mtime ) == 2 && readString( fp, entry.hash ) &&
+            fscanf( fp, " %ld", &entry.destMtime ) == 1 ) {
+      textures[ dest ] = entry;
+    }
+  }
+  fclose( fp );
+  if ( debugMode ) printf( "-> read %u texture records from %s\n", ( unsigned )textures.size(), fileName.c_str() );
+}
+
+bool liqTextureCache::upToDate( const MString &source, const MString &options, const MString &dest )
+{
+  loadManifest();
+
+  struct stat sourceStat;
+  if ( stat( source.asChar(), &sourceStat ) ) return false;
+
+  textureEntry current;
+  current.source  = source.asChar();
+  current.options = options.asChar();
+  current.size    = ( long )sourceStat.st_size;
+  current.mtime   = ( long )sourceStat.st_mtime;
+  current.destMtime = 0;
+
+  struct stat destStat;
+  bool destExists = !stat( dest.asChar(), &destStat );
+  std::map<std::string, textureEntry>::iterator found = textures.find( dest.asChar() );
+  if ( destExists && found != textures.end() && ( long )destStat.st_mtime > found->second.destMtime &&
+       destStat.st_mtime >= sourceStat.st_mtime ) {
+    // remade since it was recorded, by the job of a render script that
+    // can't report back
+    current.hash = liquidFileHash( source ).asChar();
+    if ( current.hash == "" ) return false;
+    current.destMtime = ( long )destStat.st_mtime;
+    textures[ dest.asChar() ] = current;
+    pending.erase( dest.asChar() );
+    manifestDirty = true;
+    return true;
+  }
+
+  // already found out of date, no need to read the source again
+  found = pending.find( dest.asChar() );
+  if ( found != pending.end() && found->second.source == current.source && found->second.options == current.options &&
+       found->second.size == current.size && found->second.mtime == current.mtime ) {
+    return false;
+  }
+
+  found = textures.find( dest.asChar() );
+  if ( destExists && found != textures.end() && found->second.source == current.source && found->second.options == current.options ) {
+    if ( found->second.size == current.size && found->second.mtime == current.mtime ) return true;
+    current.hash = liquidFileHash( source ).asChar();
+    if ( current.hash == "" ) return false;
+    if ( current.hash == found->second.hash ) {
+      // touched but unchanged
+      found->second.mtime = current.mtime;
+      manifestDirty = true;
+      return true;
+    }
+  } else {
+    current.hash = liquidFileHash( source ).asChar();
+    if ( current.hash == "" ) return false;
+    if ( destExists && found == textures.end() && fileIsNewer( dest, source ) ) {
+      // made before the manifest knew about it
+      current.destMtime = ( long )destStat.st_mtime;
+      textures[ dest.asChar() ] = current;
+      manifestDirty = true;
+      return true;
+    }
+  }
+  pending[ dest.asChar() ] = current;
+  return false;
+}
+
+void liqTextureCache::converted( const MString &dest )
+{
+  std::map<std::string, textureEntry>::iterator found = pending.find( dest.asChar() );
+  if ( found == pending.end() ) return;
+  struct stat destStat;
+  found->second.destMtime = stat( dest.asChar(), &destStat )? 0 : ( long )destStat.st_mtime;
+  textures[ found->first ] = found->second;
+  pending.erase( found );
+  manifestDirty = true;
+}
+
+void liqTextureCache::save()
+{
+  if ( !manifestDirty || manifestName == "" ) return;
+  // written aside and moved over the old one, so an export that dies half
+  // way through never leaves a truncated manifest
+  std::string written = manifestName + ".pending";
+  FILE *fp = fopen( written.c_str(), "wb" );
+  if ( !fp ) {
+    if ( debugMode ) printf( "-> could not write texture manifest %s\n", manifestName.c_str() );
+    return;
+  }
+  fprintf( fp, "%s\n", manifestHeader );
+  std::map<std::string, textureEntry>::const_iterator it;
+  for ( it = textures.begin(); it != textures.end(); ++it ) {
+    writeString( fp, it->first );
+    writeString( fp, it->second.source );
+    writeString( fp, it->second.options );
+    fprintf( fp, " %ld %ld", it->second.size, it->second.mtime );
+    writeString( fp, it->second.hash );
+    fprintf( fp, " %ld\n", it->second.destMtime );
+  }
+  bool failed = ferror( fp ) != 0;
+  if ( fclose( fp ) ) failed = true;
+  if ( failed ) {
+    if ( debugMode ) printf( "-> could not write texture manifest %s\n", manifestName.c_str() );
+    remove( written.c_str() );
+    return;
+  }
+  remove( manifestName.c_str() );
+  rename( written.c_str(), manifestName.c_str() );
+  manifestDirty = false;
+}
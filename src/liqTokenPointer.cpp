@@ -36,9 +36,13 @@
 extern "C" {
 #include <ri.h>
 }
+#include <algorithm>
+#include <set>
+#include <string>
 #include <liqTokenPointer.h>
 #include <liqMemory.h>
 #include <liquid.h>
+#include <liqGlobalHelpers.h>
 
 extern int debugMode;
 
@@ -53,10 +57,32 @@ const char * liqTokenPointer::StringDetailType[] = {
 };
 
 
+// Token names come from a small set, each token points into this table
+// instead of carrying its own copy. The detailed names carry array sizes,
+// so the table is emptied after each export, see releaseNames().
+static std::set<std::string> liqTokenNames;
+unsigned long liqTokenPointer::liveTokens = 0;
+
+const char *liqTokenPointer::internName( const char *name )
+{
+  return liqTokenNames.insert( std::string( name ) ).first->c_str();
+}
+
+void liqTokenPointer::releaseNames( void )
+{
+  if ( liveTokens ) {
+    if ( debugMode ) printf( "-> %lu tokens alive, keeping their names\n", liveTokens );
+    return;
+  }
+  liqTokenNames.clear();
+}
+
 liqTokenPointer::liqTokenPointer()
 {
+  liveTokens++;
   m_pType        = rFloat;
-  m_tokenName[0] = '\0';
+  m_tokenName    = "";
+  m_detailedTokenName = "";
   m_tokenFloats  = NULL;
   m_tokenString  = NULL;
   m_isArray      = false;
@@ -77,46 +103,11 @@ liqTokenPointer::liqTokenPointer( const liqTokenPointer &src )
   LIQDEBUGPRINTF(src.m_tokenName);
   LIQDEBUGPRINTF("\n" );
 
+  liveTokens++;
   m_tokenFloats   = NULL;
   m_tokenString   = NULL;
-  m_isArray       = false;
-  m_isUArray      = false;
-  m_isNurbs       = false;
-  m_isString      = false;
-  m_isFull        = false;
-  m_arraySize     = 0;
-  m_uArraySize    = 0;
-  m_eltSize       = 0;
-  m_tokenSize     = 0;
-  m_stringSize    = 0;
-
-  if( src.m_isUArray )
-    // Moritz: this is the baddy: src.m_arraySize wasn't divided by m_uArraySize!
-    //         m_uArraySize actually is only used in the set() method to calculate
-    //         m_arraySize and in getRiDeclare()
-    // Todo:   Find a less Italian (non-spaghetticode) solution to this.
-    set( src.m_tokenName, src.m_pType, src.m_isNurbs, src.m_arraySize / src.m_uArraySize, src.m_uArraySize );
-  else
-    set( src.m_tokenName, src.m_pType, src.m_isNurbs, src.m_arraySize );
-  m_dType = src.m_dType;
-
-  if( m_pType != rString ) {
-    setTokenFloats( src.m_tokenFloats );
-  } else {
-    if( src.m_tokenString ) {
-      if ( m_arraySize ) {
-        for ( unsigned int i=0; i<m_arraySize; i++) {
-          setTokenString( i, src.m_tokenString[i], strlen( src.m_tokenString[i]) );
-        }
-      } else {
-        setTokenString( 0, src.m_tokenString[0], strlen( src.m_tokenString[0]) );
-      }
-    }
-  }
-
-  LIQDEBUGPRINTF("-> done copy constructing additional ribdata: " );
-  LIQDEBUGPRINTF(src.m_tokenName);
-  LIQDEBUGPRINTF("\n" );
+  m_detailedTokenName = "";
+  copy( src );
 }
 
 liqTokenPointer & liqTokenPointer::operator=( const liqTokenPointer &src)
@@ -125,30 +116,61 @@ liqTokenPointer & liqTokenPointer::operator=( const liqTokenPointer &src)
   LIQDEBUGPRINTF(src.m_tokenName);
   LIQDEBUGPRINTF("\n" );
 
-  reset();
-  if( src.m_isUArray )
-    set( src.m_tokenName, src.m_pType, src.m_isNurbs, src.m_arraySize / src.m_uArraySize, src.m_uArraySize );
-  else
-    set( src.m_tokenName, src.m_pType, src.m_isNurbs, src.m_arraySize );
-  m_dType = src.m_dType;
-  if( m_pType != rString ) {
-    setTokenFloats( src.m_tokenFloats );
-  } else {
-    if( src.m_tokenString ) {
-      if ( m_arraySize ) {
-        for ( unsigned int i=0; i<m_arraySize; i++) {
-          setTokenString( i, src.m_tokenString[i], strlen( src.m_tokenString[i]) );
-        }
-      } else {
-        setTokenString( 0, src.m_tokenString[0], strlen( src.m_tokenString[0]) );
-      }
+  if ( this != &src ) {
+    reset();
+    copy( src );
+  }
+  return *this;
+}
+
+void liqTokenPointer::copy( const liqTokenPointer &src )
+{
+  // the floats are shared, see detachFloats()
+  m_tokenFloats = src.m_tokenFloats;
+  if ( m_tokenFloats ) floatsHeader( m_tokenFloats )->refCount++;
+  m_tokenSize   = src.m_tokenSize;
+
+  m_pType       = src.m_pType;
+  m_dType       = src.m_dType;
+  m_arraySize   = src.m_arraySize;
+  m_uArraySize  = src.m_uArraySize;
+  m_eltSize     = src.m_eltSize;
+  m_isArray     = src.m_isArray;
+  m_isUArray    = src.m_isUArray;
+  m_isNurbs     = src.m_isNurbs;
+  m_isString    = src.m_isString;
+  m_isFull      = src.m_isFull;
+  m_stringSize  = 0;
+  m_tokenName   = src.m_tokenName;
+
+  // strings are small, they are still copied
+  if ( src.m_tokenString ) {
+    unsigned int n = m_arraySize ? m_arraySize : 1;
+    m_tokenString = ( char ** ) lcalloc( n, sizeof( char * ) );
+    for ( unsigned int i = 0; i < n; i++ ) {
+      if ( src.m_tokenString[i] ) setTokenString( i, src.m_tokenString[i], strlen( src.m_tokenString[i] ) );
     }
   }
+}
 
-  LIQDEBUGPRINTF("-> done copying additional ribdata: " );
-  LIQDEBUGPRINTF(src.m_tokenName);
-  LIQDEBUGPRINTF("\n" );
-  return *this;
+void liqTokenPointer::swap( liqTokenPointer &other )
+{
+  std::swap( m_tokenName, other.m_tokenName );
+  std::swap( m_detailedTokenName, other.m_detailedTokenName );
+  std::swap( m_tokenFloats, other.m_tokenFloats );
+  std::swap( m_tokenString, other.m_tokenString );
+  std::swap( m_pType, other.m_pType );
+  std::swap( m_dType, other.m_dType );
+  std::swap( m_arraySize, other.m_arraySize );
+  std::swap( m_uArraySize, other.m_uArraySize );
+  std::swap( m_eltSize, other.m_eltSize );
+  std::swap( m_isArray, other.m_isArray );
+  std::swap( m_isUArray, other.m_isUArray );
+  std::swap( m_isNurbs, other.m_isNurbs );
+  std::swap( m_isString, other.m_isString );
+  std::swap( m_isFull, other.m_isFull );
+  std::swap( m_stringSize, other.m_stringSize );
+  std::swap( m_tokenSize, other.m_tokenSize );
 }
 
 liqTokenPointer::~liqTokenPointer()
@@ -158,14 +180,54 @@ liqTokenPointer::~liqTokenPointer()
   LIQDEBUGPRINTF(m_tokenName);
   LIQDEBUGPRINTF("\n" );
 
-  if( m_tokenFloats ) { lfree( m_tokenFloats ); m_tokenFloats = NULL; }
+  releaseFloats();
   resetTokenString();
+  liveTokens--;
 
 };
 
+RtFloat *liqTokenPointer::allocFloats( unsigned long size )
+{
+  floatsHeaderType *header = ( floatsHeaderType * ) lamalloc( sizeof( floatsHeaderType ) + size );
+  if ( !header ) return NULL;
+  header->refCount = 1;
+  return ( RtFloat * )( header + 1 );
+}
+
+liqTokenPointer::floatsHeaderType *liqTokenPointer::floatsHeader( RtFloat *floats )
+{
+  return ( ( floatsHeaderType * ) floats ) - 1;
+}
+
+void liqTokenPointer::releaseFloats()
+{
+  if ( m_tokenFloats ) {
+    floatsHeaderType *header = floatsHeader( m_tokenFloats );
+    if ( --header->refCount == 0 ) lafree( header );
+    m_tokenFloats = NULL;
+  }
+  m_tokenSize = 0;
+}
+
+bool liqTokenPointer::detachFloats()
+{
+  // copy on write : get our own floats before changing shared ones
+  if ( m_tokenFloats && floatsHeader( m_tokenFloats )->refCount > 1 ) {
+    RtFloat *floats = allocFloats( m_tokenSize );
+    if ( !floats ) {
+      printf("Error : liqTokenPointer out of memory for %ld bytes\n", m_tokenSize );
+      return false;
+    }
+    memcpy( floats, m_tokenFloats, m_tokenSize );
+    floatsHeader( m_tokenFloats )->refCount--;
+    m_tokenFloats = floats;
+  }
+  return true;
+}
+
 void liqTokenPointer::reset()
 {
-  if( m_tokenFloats ) { lfree( m_tokenFloats ); m_tokenFloats = NULL; }
+  releaseFloats();
   if( m_tokenString ) {
     resetTokenString();
   }
@@ -180,7 +242,7 @@ void liqTokenPointer::reset()
   m_tokenSize    = 0;
   m_stringSize   = 0;
   m_pType        = rFloat;
-  m_tokenName[0] = '\0';
+  m_tokenName    = "";
 }
 
 int liqTokenPointer::set( const char * name, ParameterType ptype, bool asNurbs )
@@ -255,21 +317,13 @@ int liqTokenPointer::set( const char * name, ParameterType ptype, bool asNurbs,
       neededSize = m_eltSize * sizeof( RtFloat);
     }
 
-    // allocate whatever we need
-    if( m_tokenFloats ) {
-      // Check if we already got enough space
-      if( m_tokenSize < neededSize ) {
-        lfree( m_tokenFloats );
-        m_tokenSize = 0;
-        m_tokenFloats = ( RtFloat * ) lmalloc( neededSize );
-        if( ! m_tokenFloats ) {
-          printf("Error : liqTokenPointer out of memory for %ld bytes\n", neededSize );
-          return 0;
-        }
-        m_tokenSize = neededSize;
-      }
-    } else if( neededSize ) {
-      m_tokenFloats = ( RtFloat * ) lmalloc( neededSize );
+    // allocate whatever we need, shared floats are let go as they are
+    // about to be overwritten anyway
+    if( m_tokenFloats && ( m_tokenSize < ( long )neededSize || floatsHeader( m_tokenFloats )->refCount > 1 ) ) {
+      releaseFloats();
+    }
+    if( !m_tokenFloats && neededSize ) {
+      m_tokenFloats = allocFloats( neededSize );
       if( ! m_tokenFloats ) {
         printf("Error : liqTokenPointer out of memory for %ld bytes\n", neededSize );
         return 0;
@@ -283,10 +337,7 @@ int liqTokenPointer::set( const char * name, ParameterType ptype, bool asNurbs,
     // Space is now allocated upfront
 
     // free mem
-    if( m_tokenFloats ) {
-      lfree( m_tokenFloats );
-      m_tokenFloats = NULL;
-    }
+    releaseFloats();
     resetTokenString();
 
     m_isUArray    = false;
@@ -316,11 +367,13 @@ int liqTokenPointer::adjustArraySize( unsigned int size )
   {
     // Only augment allocated memory if needed, do not reduce it
     unsigned long neededSize = size * m_eltSize * sizeof( RtFloat);
-    if( m_tokenSize < neededSize ) {
-      RtFloat * tmp = ( RtFloat * ) realloc( m_tokenFloats, neededSize );
+    if( m_tokenSize < ( long )neededSize ) {
+      RtFloat * tmp = allocFloats( neededSize );
       // Hmmmmm should get a way to report error message to caller
       if( !tmp )
         return 0;
+      if( m_tokenFloats ) memcpy( tmp, m_tokenFloats, m_tokenSize );
+      releaseFloats();
       m_tokenFloats = tmp;
       m_tokenSize = neededSize;
     }
@@ -344,6 +397,26 @@ ParameterType liqTokenPointer::getParameterType( void )
   return m_pType;
 }
 
+unsigned int liqTokenPointer::getArraySize( void )
+{
+  return m_isUArray ? m_arraySize / m_uArraySize : m_arraySize;
+}
+
+unsigned int liqTokenPointer::getUArraySize( void )
+{
+  return m_isUArray ? m_uArraySize : 0;
+}
+
+unsigned int liqTokenPointer::getElementSize( void )
+{
+  return m_eltSize;
+}
+
+bool liqTokenPointer::isNurbs( void )
+{
+  return m_isNurbs;
+}
+
 void liqTokenPointer::setTokenFloat( unsigned int i, RtFloat val )
 {
 #ifdef DEBUG
@@ -352,6 +425,7 @@ void liqTokenPointer::setTokenFloat( unsigned int i, RtFloat val )
     LIQDEBUGPRINTF( "setTokeFloat out of bounds, max: %d, asked: %d\n", max, i );
   }
 #endif
+  if( !detachFloats() ) return;
   m_tokenFloats[i] = val;
 }
 
@@ -368,13 +442,31 @@ void liqTokenPointer::setTokenFloat( unsigned int i, unsigned int uIndex, RtFloa
 
 void liqTokenPointer::setTokenFloat( unsigned int i, RtFloat x, RtFloat y , RtFloat z )
 {
+  if( !detachFloats() ) return;
   m_tokenFloats[3 * i + 0] = x;
   m_tokenFloats[3 * i + 1] = y;
   m_tokenFloats[3 * i + 2] = z;
 }
 
+void liqTokenPointer::hash( liqHash &h ) const
+{
+  h.add( m_tokenName );
+  h.add( ( int )m_pType );
+  h.add( ( int )m_dType );
+  h.add( m_arraySize );
+  h.add( m_uArraySize );
+  h.add( ( int )m_isNurbs );
+  if( m_pType == rString ) {
+    unsigned int count = m_arraySize ? m_arraySize : 1;
+    for( unsigned int i = 0; m_tokenString && i < count; i++ ) h.add( m_tokenString[i] );
+  } else if( m_tokenFloats ) {
+    h.add( m_tokenFloats, ( m_isArray ? m_arraySize : 1 ) * m_eltSize * sizeof( RtFloat ) );
+  }
+}
+
 void liqTokenPointer::setTokenFloats( const RtFloat * vals )
 {
+  if( vals == m_tokenFloats || !detachFloats() ) return;
   if( m_isArray || m_isUArray ) {
     memcpy( m_tokenFloats, vals, m_arraySize * m_eltSize * sizeof( RtFloat) );
   } else {
@@ -389,6 +481,7 @@ const RtFloat * liqTokenPointer::getTokenFloatArray( )
 
 void liqTokenPointer::setTokenFloat( unsigned int i, RtFloat x, RtFloat y , RtFloat z, RtFloat w )
 {
+  if( !detachFloats() ) return;
   m_tokenFloats[4 * i + 0] = x;
   m_tokenFloats[4 * i + 1] = y;
   m_tokenFloats[4 * i + 2] = z;
@@ -424,34 +517,35 @@ void liqTokenPointer::resetTokenString( void )
 
 void liqTokenPointer::setTokenName( const char * name )
 {
-  // Hmmm we should check name length here
-  strcpy( m_tokenName, name );
+  m_tokenName = internName( name );
 }
 
 char * liqTokenPointer::getTokenName( void )
 {
   // Hmmmm should we handle token without name ?
-  return m_tokenName;
+  return const_cast< char * >( m_tokenName );
 }
 
 char * liqTokenPointer::getDetailedTokenName( void )
 {
   // Hmmmm should we handle token without name ?
+  char detailedTokenName[512];
 #ifdef PRMAN
   // Philippe : in PRMAN, declaring P as a vertex point is not necessary and it make riCurves generation fail.
   // so when the token is P, we just skip the type declaration.
   if ( strcmp(m_tokenName, "P\0") == 0 ) {
-    m_detailedTokenName[0] = '\0';
+    detailedTokenName[0] = '\0';
   } else {
-    getRiDeclare( m_detailedTokenName );
-    strcat( m_detailedTokenName, " " );
+    getRiDeclare( detailedTokenName );
+    strcat( detailedTokenName, " " );
   }
 #else
-  getRiDeclare( m_detailedTokenName );
-  strcat( m_detailedTokenName, " " );
+  getRiDeclare( detailedTokenName );
+  strcat( detailedTokenName, " " );
 #endif
-  strcat( m_detailedTokenName, m_tokenName );
-  return m_detailedTokenName;
+  strcat( detailedTokenName, m_tokenName );
+  m_detailedTokenName = internName( detailedTokenName );
+  return const_cast< char * >( m_detailedTokenName );
 }
 
 RtPointer liqTokenPointer::getRtPointer( void )
@@ -525,6 +619,50 @@ void liqTokenPointer::getRiDeclare( char *declare  )
   }
 }
 
+#ifdef GENERIC_RIBLIB
+void liqTokenPointer::getRiParameterType( RtParameterType &type )
+{
+  type.token = const_cast< char * >( m_tokenName );
+  type.arraySize = 0;
+  switch ( m_pType ) {
+  case rString:
+    type.type = RI_PARAMETER_STRING;
+    if ( m_isArray ) type.arraySize = m_arraySize;
+    break;
+  case rMatrix:
+    type.type = RI_PARAMETER_MATRIX;
+    break;
+  case rHpoint:
+  case rPoint:
+    if ( m_isNurbs ) {
+      type.type = m_isArray ? RI_PARAMETER_HPOINT : RI_PARAMETER_POINT;
+    } else {
+      type.type = RI_PARAMETER_POINT;
+      if ( m_isUArray ) type.arraySize = m_uArraySize;
+    }
+    break;
+  case rFloat:
+  case rVector:
+  case rNormal:
+  case rColor:
+    type.type = ( m_pType == rFloat )?  RI_PARAMETER_FLOAT :
+                ( m_pType == rVector )? RI_PARAMETER_VECTOR :
+                ( m_pType == rNormal )? RI_PARAMETER_NORMAL : RI_PARAMETER_COLOR;
+    if ( m_isUArray ) type.arraySize = m_uArraySize;
+    break;
+  }
+  switch ( m_dType ) {
+  case rUniform:      type.detail = RI_PARAMETER_UNIFORM;     break;
+  case rVarying:      type.detail = RI_PARAMETER_VARYING;     break;
+  case rVertex:       type.detail = RI_PARAMETER_VERTEX;      break;
+  case rConstant:     type.detail = RI_PARAMETER_CONSTANT;    break;
+  // ribLib has no facevertex
+  case rFaceVarying:
+  case rFaceVertex:   type.detail = RI_PARAMETER_FACEVARYING; break;
+  }
+}
+#endif
+
 bool liqTokenPointer::isBasicST( void )
 {
   // Not st or, if it is, face varying
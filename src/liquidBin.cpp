@@ -76,6 +76,8 @@ Frame\n\
 \t-ar     -aspect <n>\n\
 \t-n      -sequence <start> <stop> <step>\n\
 \t-fl     -frameList <n,n,n,...>\n\
+\t-fw     -frameWorkers <n>                 processes sharing the frames once the scene is loaded\n\
+\t-fcs    -frameChunkSize <n>               consecutive frames rendered from one RIB per job\n\
 \t-mb     -motionBlur\n\
 \t-db     -deformationBlur\n\
 \t-m      -mbSamples <n>\n\